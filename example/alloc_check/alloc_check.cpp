@@ -0,0 +1,124 @@
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "dysv/dy_log.hpp"
+#include "dysv/dy_async_log.hpp"
+#include "dysv/dy_log_stream.hpp"
+
+/**
+ * @brief 日志调用路径的内存申请检查。替换全局operator new，统计调用线程中的申请次数:
+ *        每个入口先预热(线程内缓冲、队列槽位、分片等在此期间分配完毕)，再在稳态下调用若干次，
+ *        期间只要有一次申请即判为失败。用于守住DY_LOG_*、DY_LOG_FMT_*、DY_LOGF_*、限频宏、流式日志
+ *        与异步日志器生产者一侧"稳态不申请内存"的承诺。
+ * @usage dysv_alloc_check
+ *        全部通过时返回0，否则打印申请了内存的入口并返回1。
+ */
+
+#define CHECK_WARMUP_CALLS      4096
+#define CHECK_STEADY_CALLS      20000
+#define CHECK_QUEUE_SIZE        1024        // 异步日志器的队列长度，预热调用数须超过它，使每个槽位都被用过
+#define CHECK_LONG_STR          "a string argument long enough to defeat the small string optimization"
+
+// 只统计当前线程，后台线程与sink中的申请不计入
+static thread_local bool t_counting = false;
+static thread_local size_t t_allocs = 0;
+
+static void* CountedAlloc(size_t size){
+    if(t_counting){
+        t_allocs++;
+    }
+    void* p = malloc(size == 0 ? 1 : size);
+    if(p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(size_t size){ return CountedAlloc(size); }
+void* operator new[](size_t size){ return CountedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept{
+    if(t_counting){
+        t_allocs++;
+    }
+    return malloc(size == 0 ? 1 : size);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept{ return operator new(size, tag); }
+void operator delete(void* p) noexcept{ free(p); }
+void operator delete[](void* p) noexcept{ free(p); }
+void operator delete(void* p, size_t) noexcept{ free(p); }
+void operator delete[](void* p, size_t) noexcept{ free(p); }
+
+// 丢弃所有记录
+class NullLoggerSink : public dysv::LoggerSinkInterface
+{
+public:
+    explicit NullLoggerSink(const std::string& name) : LoggerSinkInterface(name){}
+    void Sink(const std::string&) override{}
+};
+
+struct CheckCase{
+    const char*                 name;
+    std::function<void(int)>    call;
+};
+
+// 返回稳态调用中的申请次数
+static size_t RunCase(const CheckCase& c){
+    for(int i = 0; i < CHECK_WARMUP_CALLS; i++){
+        c.call(i);
+    }
+    t_allocs = 0;
+    t_counting = true;
+    for(int i = 0; i < CHECK_STEADY_CALLS; i++){
+        c.call(i);
+    }
+    t_counting = false;
+    return t_allocs;
+}
+
+int main(){
+    auto sink = std::make_shared<NullLoggerSink>("null");
+    CLEAN_SINK();
+    ADD_SINK(sink);
+    DEFAULT_LOGGER->SetLevel(dysv::level::TRACE);
+
+    auto async = std::make_shared<dysv::AsyncLogger>("alloc_check_async", dysv::level::TRACE,
+                                                        DEFAULT_PATTERN_STR, CHECK_QUEUE_SIZE);
+    async->AddSink(sink);
+    auto sharded = std::make_shared<dysv::ShardedAsyncLogger>("alloc_check_sharded", dysv::level::TRACE,
+                                                                DEFAULT_PATTERN_STR, CHECK_QUEUE_SIZE);
+    sharded->AddSink(sink);
+    const std::string arg(CHECK_LONG_STR);
+
+    std::vector<CheckCase> cases = {
+        {"DY_LOG_INFO", [](int){ DY_LOG_INFO("a plain message, longer than the small string buffer"); }},
+        {"DY_LOG_FMT_INFO", [&](int i){ DY_LOG_FMT_INFO("request %d served in %s", i, arg.c_str()); }},
+        {"DY_LOGF_INFO", [&](int i){ DY_LOGF_INFO("request {} served in {} ({})", i, arg, 0.25); }},
+        {"DY_LOG_STREAM_INFO", [&](int i){ DY_LOG_STREAM_INFO << "request " << i << " served in " << arg; }},
+        {"DY_LOGF_EVERY_N", [&](int i){ DY_LOGF_EVERY_N(dysv::level::WARN, 100, "every 100th: {} {}", i, arg); }},
+        {"DY_LOG_FMT_EVERY_MS", [&](int i){ DY_LOG_FMT_EVERY_MS(dysv::level::WARN, 1, "every 1ms: %d %s", i, arg.c_str()); }},
+        {"dysv::info", [](int){ dysv::info("a plain message, longer than the small string buffer"); }},
+        {"AsyncLogger::Log", [&](int){ async->Log(ADD_ADDITION_INFO, dysv::level::INFO, arg); }},
+        {"AsyncLogger::Logf", [&](int i){ async->Logf(ADD_ADDITION_INFO, dysv::level::INFO, "request %d %s", i, arg.c_str()); }},
+        {"AsyncLogger::LogFmt", [&](int i){ async->LogFmt(ADD_ADDITION_INFO, dysv::level::INFO, "request {} {}", i, arg); }},
+        {"ShardedAsyncLogger::Log", [&](int){ sharded->Log(ADD_ADDITION_INFO, dysv::level::INFO, arg); }},
+    };
+
+    int failed = 0;
+    for(const CheckCase& c : cases){
+        size_t allocs = RunCase(c);
+        printf("%-28s %s (%zu allocation(s) in %d calls)\n", c.name, allocs == 0 ? "ok  " : "FAIL", allocs, CHECK_STEADY_CALLS);
+        if(allocs != 0){
+            failed++;
+        }
+    }
+    async->Stop();
+    sharded->Stop();
+    if(failed > 0){
+        printf("%d case(s) allocated on the steady-state path\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/dy_executor.hpp"
+
+/**
+ * @brief 线程池基准：工作窃取线程池(dysv::Executor)对比单个互斥锁保护的共享队列。
+ *        external: 一个外部线程连续提交大量小任务; spawn: 任务在工作线程中派生子任务(二叉树)，
+ *        工作窃取线程池的子任务进入本线程队列，只在空闲时被窃取。
+ * @usage dysv_executor_bench [tasks] [threads]
+ */
+
+#define BENCH_DEFAULT_TASKS     1000000
+#define BENCH_TASK_WORK         64      // 每个任务内的空循环次数，模拟极小的任务
+
+// 对照组：所有线程共用一个std::mutex + std::condition_variable + std::deque
+class MutexQueuePool
+{
+public:
+    explicit MutexQueuePool(size_t threads) : m_stop(false){
+        for(size_t i = 0; i < threads; i++){
+            m_threads.emplace_back([this]{ WorkerLoop(); });
+        }
+    }
+
+    ~MutexQueuePool(){
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_cv.notify_all();
+        for(auto& t : m_threads){
+            t.join();
+        }
+    }
+
+    void Post(std::function<void()> task){
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        m_cv.notify_one();
+    }
+private:
+    void WorkerLoop(){
+        for(;;){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk(m_mutex);
+                m_cv.wait(lk, [this]{ return m_stop || !m_tasks.empty(); });
+                if(m_tasks.empty()){
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex                          m_mutex;
+    std::condition_variable             m_cv;
+    std::deque<std::function<void()>>   m_tasks;
+    std::vector<std::thread>            m_threads;
+    bool                                m_stop;
+};
+
+static std::atomic<long> g_done(0);
+
+static void TinyWork(){
+    volatile int sink = 0;
+    for(int i = 0; i < BENCH_TASK_WORK; i++){
+        sink = sink + i;
+    }
+    g_done.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void WaitDone(long expected){
+    while(g_done.load(std::memory_order_relaxed) < expected){
+        std::this_thread::yield();
+    }
+}
+
+// 深度为depth的二叉任务树，共2^(depth+1)-1个任务
+template<class Pool>
+static void Spawn(Pool& pool, int depth){
+    TinyWork();
+    if(depth == 0){
+        return;
+    }
+    pool.Post([&pool, depth]{ Spawn(pool, depth - 1); });
+    pool.Post([&pool, depth]{ Spawn(pool, depth - 1); });
+}
+
+template<class Pool>
+static void RunCase(const char* pool_name, const char* case_name, Pool& pool, long tasks){
+    g_done.store(0);
+    auto begin = std::chrono::steady_clock::now();
+    long expected = tasks;
+    if(case_name[0] == 'e'){
+        for(long i = 0; i < tasks; i++){
+            pool.Post([]{ TinyWork(); });
+        }
+    }else{
+        int depth = 0;
+        while((2L << (depth + 1)) - 1 <= tasks){
+            depth++;
+        }
+        expected = (2L << depth) - 1;
+        pool.Post([&pool, depth]{ Spawn(pool, depth); });
+    }
+    WaitDone(expected);
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+    printf("%-14s %-9s tasks=%-9ld ns/task=%-8.1f tasks/s=%.0f\n",
+            pool_name, case_name, expected, ns / expected, expected / (ns / 1e9));
+}
+
+int main(int argc, char** argv){
+    long tasks = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_TASKS;
+    size_t threads = argc > 2 ? (size_t)atol(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+
+    for(const char* case_name : {"external", "spawn"}){
+        {
+            MutexQueuePool pool(threads);
+            RunCase("mutex-queue", case_name, pool, tasks);
+        }
+        {
+            dysv::ExecutorConfig config;
+            config.threads = threads;
+            dysv::Executor pool(config);
+            RunCase("work-stealing", case_name, pool, tasks);
+            printf("%-14s %-9s steals=%llu\n", "", "", (unsigned long long)pool.GetStealCount());
+        }
+    }
+    return 0;
+}
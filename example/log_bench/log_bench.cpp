@@ -0,0 +1,342 @@
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "dysv/dy_log.hpp"
+#include "dysv/dy_async_log.hpp"
+
+/**
+ * @brief 日志库吞吐与尾延迟基准。对线程数 x 消息长度 x 入口 x 是否被级别过滤 x sink x 日志器 的矩阵逐项测量
+ *        消息/秒与单次调用延迟的p50/p99/p99.9/max，结果以JSON写入文件，便于不同提交之间对比。
+ *        单次调用延迟由两次CLOCK_MONOTONIC读数相减得到，包含计时本身的开销(见timer_overhead_ns)。
+ * @usage dysv_log_bench [-t 1,2,4,8] [-s 16,128,1024] [-e log,logf,dy_log,dy_logf,dy_log_fmt] [-k null,file,stdout]
+ *                       [-l sync,async,sharded] [-f enabled,filtered] [-n records_per_thread] [-d output_dir] [-o result.json]
+ *        stdout sink会输出大量日志，可将标准输出重定向到/dev/null，JSON结果写入-o指定的文件("-"表示标准错误)。
+ */
+
+#define BENCH_DEFAULT_RECORDS       20000
+#define BENCH_DEFAULT_THREADS       "1,2,4,8"
+#define BENCH_DEFAULT_SIZES         "16,128,1024"
+#define BENCH_DEFAULT_ENTRIES       "log,logf,dy_log,dy_logf,dy_log_fmt"
+#define BENCH_DEFAULT_SINKS         "null,file,stdout"
+#define BENCH_DEFAULT_LOGGERS       "sync"
+#define BENCH_DEFAULT_FILTERS       "enabled,filtered"
+#define BENCH_DEFAULT_OUTPUT        "log_bench.json"
+#define BENCH_LOGGER_NAME           "log_bench"
+#define BENCH_TIMER_SAMPLES         100000
+
+// 丢弃所有记录，只衡量日志库自身的开销
+class NullLoggerSink : public dysv::LoggerSinkInterface
+{
+public:
+    explicit NullLoggerSink(const std::string& name) : LoggerSinkInterface(name){}
+    void Sink(const std::string&) override{}
+};
+
+struct BenchOptions{
+    std::vector<long>           threads;
+    std::vector<long>           sizes;
+    std::vector<std::string>    entries;
+    std::vector<std::string>    sinks;
+    std::vector<std::string>    loggers;
+    std::vector<std::string>    filters;
+    long                        records = BENCH_DEFAULT_RECORDS;
+    std::string                 dir = ".";
+    std::string                 output = BENCH_DEFAULT_OUTPUT;
+};
+
+struct CaseResult{
+    std::string     logger;
+    std::string     sink;
+    std::string     entry;
+    long            threads;
+    long            msg_size;
+    bool            enabled;
+    long            messages;
+    double          seconds;
+    uint64_t        p50_ns;
+    uint64_t        p99_ns;
+    uint64_t        p999_ns;
+    uint64_t        max_ns;
+};
+
+static inline uint64_t NowNs(){
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static std::vector<std::string> SplitList(const std::string& str){
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while(begin <= str.size()){
+        size_t end = str.find(',', begin);
+        if(end == std::string::npos){
+            end = str.size();
+        }
+        if(end > begin){
+            items.push_back(str.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+static std::vector<long> SplitNumbers(const std::string& str){
+    std::vector<long> nums;
+    for(const auto& item : SplitList(str)){
+        nums.push_back(atol(item.c_str()));
+    }
+    return nums;
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& opt){
+    std::string threads = BENCH_DEFAULT_THREADS, sizes = BENCH_DEFAULT_SIZES, entries = BENCH_DEFAULT_ENTRIES;
+    std::string sinks = BENCH_DEFAULT_SINKS, loggers = BENCH_DEFAULT_LOGGERS, filters = BENCH_DEFAULT_FILTERS;
+    for(int i = 1; i < argc; i++){
+        if(strlen(argv[i]) != 2 || argv[i][0] != '-' || i + 1 >= argc){
+            return false;
+        }
+        const char* val = argv[++i];
+        switch(argv[i - 1][1]){
+            case 't': threads = val; break;
+            case 's': sizes = val; break;
+            case 'e': entries = val; break;
+            case 'k': sinks = val; break;
+            case 'l': loggers = val; break;
+            case 'f': filters = val; break;
+            case 'n': opt.records = atol(val); break;
+            case 'd': opt.dir = val; break;
+            case 'o': opt.output = val; break;
+            default: return false;
+        }
+    }
+    opt.threads = SplitNumbers(threads);
+    opt.sizes = SplitNumbers(sizes);
+    opt.entries = SplitList(entries);
+    opt.sinks = SplitList(sinks);
+    opt.loggers = SplitList(loggers);
+    opt.filters = SplitList(filters);
+    return opt.records > 0;
+}
+
+static dysv::Logger::ptr MakeLogger(const std::string& kind){
+    if(kind == "async"){
+        return std::make_shared<dysv::AsyncLogger>(BENCH_LOGGER_NAME, dysv::level::TRACE, DEFAULT_PATTERN_STR);
+    }
+    if(kind == "sharded"){
+        return std::make_shared<dysv::ShardedAsyncLogger>(BENCH_LOGGER_NAME, dysv::level::TRACE, DEFAULT_PATTERN_STR);
+    }
+    if(kind == "sync"){
+        return std::make_shared<dysv::Logger>(BENCH_LOGGER_NAME, dysv::level::TRACE, DEFAULT_PATTERN_STR);
+    }
+    return nullptr;
+}
+
+static dysv::LoggerSinkInterface::ptr MakeSink(const std::string& kind, const std::string& file_name){
+    if(kind == "null"){
+        return std::make_shared<NullLoggerSink>(kind);
+    }
+    if(kind == "file"){
+        return std::make_shared<dysv::FileLoggerSink>(kind, file_name);
+    }
+    if(kind == "stdout"){
+        return std::make_shared<dysv::StdLoggerSink>(kind, dysv::STD_COUT);
+    }
+    return nullptr;
+}
+
+// 通过指定入口打印一条INFO日志。宏入口经由默认日志器
+static inline void LogOnce(const dysv::Logger::ptr& logger, int entry, const std::string& payload, long seq){
+    switch(entry){
+        case 0: logger->Log(ADD_ADDITION_INFO, dysv::level::INFO, payload); break;
+        case 1: logger->Logf(ADD_ADDITION_INFO, dysv::level::INFO, "%s %ld", payload.c_str(), seq); break;
+        case 2: DY_LOG_INFO(payload); break;
+        case 3: DY_LOGF_INFO("{} {}", payload, seq); break;
+        default: DY_LOG_FMT_INFO("%s %ld", payload.c_str(), seq); break;
+    }
+}
+
+static int EntryIndex(const std::string& entry){
+    static const char* names[] = {"log", "logf", "dy_log", "dy_logf", "dy_log_fmt"};
+    for(int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++){
+        if(entry == names[i]){
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint64_t Percentile(const std::vector<uint64_t>& sorted, double p){
+    if(sorted.empty()){
+        return 0;
+    }
+    size_t idx = (size_t)(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+static CaseResult RunCase(const BenchOptions& opt, const dysv::Logger::ptr& logger, const std::string& logger_kind,
+                            const std::string& sink_kind, const std::string& entry, long threads, long msg_size, bool enabled){
+    std::string file_name = opt.dir + "/log_bench_" + sink_kind + ".log";
+    logger->CleanSink();
+    logger->AddSink(MakeSink(sink_kind, file_name));
+    logger->SetLevel(enabled ? dysv::level::TRACE : dysv::level::WARN);
+
+    int entry_index = EntryIndex(entry);
+    std::string payload(msg_size, 'x');
+    std::vector<std::vector<uint64_t>> latencies(threads, std::vector<uint64_t>(opt.records));
+    std::atomic<long> ready{0};
+    std::atomic<bool> go{false};
+
+    std::vector<std::thread> workers;
+    for(long t = 0; t < threads; t++){
+        workers.emplace_back([&, t]{
+            std::vector<uint64_t>& lat = latencies[t];
+            ready++;
+            while(!go.load(std::memory_order_acquire)){
+                std::this_thread::yield();
+            }
+            for(long i = 0; i < opt.records; i++){
+                uint64_t begin = NowNs();
+                LogOnce(logger, entry_index, payload, i);
+                lat[i] = NowNs() - begin;
+            }
+        });
+    }
+    while(ready.load() < threads){
+        std::this_thread::yield();
+    }
+    uint64_t begin = NowNs();
+    go.store(true, std::memory_order_release);
+    for(auto& worker : workers){
+        worker.join();
+    }
+    logger->Flush();
+    uint64_t end = NowNs();
+
+    std::vector<uint64_t> all;
+    all.reserve(threads * opt.records);
+    for(const auto& lat : latencies){
+        all.insert(all.end(), lat.begin(), lat.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    logger->CleanSink();
+    if(sink_kind == "file"){
+        unlink(file_name.c_str());
+    }
+
+    CaseResult res;
+    res.logger = logger_kind;
+    res.sink = sink_kind;
+    res.entry = entry;
+    res.threads = threads;
+    res.msg_size = msg_size;
+    res.enabled = enabled;
+    res.messages = threads * opt.records;
+    res.seconds = (end - begin) / 1e9;
+    res.p50_ns = Percentile(all, 0.50);
+    res.p99_ns = Percentile(all, 0.99);
+    res.p999_ns = Percentile(all, 0.999);
+    res.max_ns = all.empty() ? 0 : all.back();
+    return res;
+}
+
+// 连续两次读时钟的中位差值，即每个延迟样本中包含的计时开销
+static uint64_t MeasureTimerOverhead(){
+    std::vector<uint64_t> samples(BENCH_TIMER_SAMPLES);
+    for(auto& sample : samples){
+        uint64_t begin = NowNs();
+        sample = NowNs() - begin;
+    }
+    std::sort(samples.begin(), samples.end());
+    return Percentile(samples, 0.5);
+}
+
+static void WriteJson(FILE* fp, const BenchOptions& opt, uint64_t timer_overhead, const std::vector<CaseResult>& results){
+    time_t now = time(nullptr);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+    fprintf(fp, "{\n");
+    fprintf(fp, "  \"date\": \"%s\",\n", date);
+    fprintf(fp, "  \"hardware_concurrency\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(fp, "  \"records_per_thread\": %ld,\n", opt.records);
+    fprintf(fp, "  \"timer_overhead_ns\": %lu,\n", (unsigned long)timer_overhead);
+    fprintf(fp, "  \"results\": [\n");
+    for(size_t i = 0; i < results.size(); i++){
+        const CaseResult& r = results[i];
+        fprintf(fp, "    {\"logger\": \"%s\", \"sink\": \"%s\", \"entry\": \"%s\", \"threads\": %ld, \"msg_size\": %ld, "
+                    "\"enabled\": %s, \"messages\": %ld, \"seconds\": %.6f, \"msgs_per_sec\": %.0f, "
+                    "\"p50_ns\": %lu, \"p99_ns\": %lu, \"p999_ns\": %lu, \"max_ns\": %lu}%s\n",
+                r.logger.c_str(), r.sink.c_str(), r.entry.c_str(), r.threads, r.msg_size,
+                r.enabled ? "true" : "false", r.messages, r.seconds, r.messages / r.seconds,
+                (unsigned long)r.p50_ns, (unsigned long)r.p99_ns, (unsigned long)r.p999_ns, (unsigned long)r.max_ns,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+int main(int argc, char** argv){
+    BenchOptions opt;
+    if(!ParseOptions(argc, argv, opt)){
+        fprintf(stderr, "usage: %s [-t threads] [-s sizes] [-e entries] [-k sinks] [-l loggers] [-f filters] "
+                        "[-n records_per_thread] [-d output_dir] [-o result.json]\n", argv[0]);
+        return 1;
+    }
+    for(const auto& entry : opt.entries){
+        if(EntryIndex(entry) < 0){
+            fprintf(stderr, "unknown entry: %s\n", entry.c_str());
+            return 1;
+        }
+    }
+    for(const auto& sink : opt.sinks){
+        if(MakeSink(sink, "/dev/null") == nullptr){
+            fprintf(stderr, "unknown sink: %s\n", sink.c_str());
+            return 1;
+        }
+    }
+
+    uint64_t timer_overhead = MeasureTimerOverhead();
+    std::vector<CaseResult> results;
+    for(const auto& logger_kind : opt.loggers){
+        dysv::Logger::ptr logger = MakeLogger(logger_kind);
+        if(logger == nullptr){
+            fprintf(stderr, "unknown logger: %s\n", logger_kind.c_str());
+            return 1;
+        }
+        // 宏入口经由默认日志器
+        SET_DEFAULT_LOGGER(logger);
+        for(const auto& sink : opt.sinks){
+            for(const auto& entry : opt.entries){
+                for(const auto& filter : opt.filters){
+                    for(long threads : opt.threads){
+                        for(long msg_size : opt.sizes){
+                            CaseResult r = RunCase(opt, logger, logger_kind, sink, entry, threads, msg_size, filter != "filtered");
+                            fprintf(stderr, "%-7s %-6s %-10s %-8s threads=%-3ld size=%-5ld %12.0f msg/s p50=%-6lu p99=%-7lu p99.9=%-8lu max=%lu\n",
+                                    r.logger.c_str(), r.sink.c_str(), r.entry.c_str(), r.enabled ? "enabled" : "filtered",
+                                    r.threads, r.msg_size, r.messages / r.seconds, (unsigned long)r.p50_ns,
+                                    (unsigned long)r.p99_ns, (unsigned long)r.p999_ns, (unsigned long)r.max_ns);
+                            results.push_back(r);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    FILE* fp = opt.output == "-" ? stderr : fopen(opt.output.c_str(), "w");
+    if(fp == nullptr){
+        fprintf(stderr, "cannot open %s\n", opt.output.c_str());
+        return 1;
+    }
+    WriteJson(fp, opt, timer_overhead, results);
+    if(fp != stderr){
+        fclose(fp);
+        fprintf(stderr, "results written to %s\n", opt.output.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * @brief 本地日志收集端，SocketLoggerSink的接收端示例(也可作为测试替身)。
+ *        把收到的日志原样写到标准输出，退出(SIGINT/SIGTERM)时在标准错误输出收到的记录数与字节数。
+ *        数据报套接字以recvmmsg成批接收。
+ * @usage dysv_log_collector unix:PATH | unix-stream:PATH | udp:PORT [-q]
+ *        -q 不输出日志内容，只统计
+ * @example
+ *      dysv_log_collector unix:/tmp/dysv.sock &
+ *      ADD_SINK(std::make_shared<dysv::SocketLoggerSink>("collector", dysv::SocketSinkConfig::Unix("/tmp/dysv.sock")));
+ */
+
+#define COLLECTOR_RECV_BATCH        16              // 每次recvmmsg最多接收的报文数
+#define COLLECTOR_BUFFER_SIZE       (64 * 1024)     // 每个报文/每次读取的缓冲大小
+#define COLLECTOR_LISTEN_BACKLOG    16
+#define COLLECTOR_RCVBUF_SIZE       (8 * 1024 * 1024)   // 接收缓冲，UDP没有流控，越大越不容易丢(受net.core.rmem_max限制)
+
+static volatile sig_atomic_t g_stop = 0;
+
+static void OnStopSignal(int){
+    g_stop = 1;
+}
+
+struct Stats{
+    uint64_t    records = 0;
+    uint64_t    bytes = 0;
+    uint64_t    datagrams = 0;
+};
+
+static void Consume(const char* data, size_t len, bool quiet, Stats& stats){
+    stats.bytes += len;
+    for(size_t i = 0; i < len; i++){
+        stats.records += (data[i] == '\n');
+    }
+    if(!quiet){
+        fwrite(data, 1, len, stdout);
+    }
+}
+
+static int BindSocket(const std::string& kind, const std::string& where){
+    bool udp = (kind == "udp");
+    bool stream = (kind == "unix-stream");
+    int fd = socket(udp ? AF_INET : AF_UNIX, (stream ? SOCK_STREAM : SOCK_DGRAM) | SOCK_CLOEXEC, 0);
+    if(fd < 0){
+        return -1;
+    }
+    int rcvbuf = COLLECTOR_RCVBUF_SIZE;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    int ret;
+    if(udp){
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)atoi(where.c_str()));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ret = bind(fd, (sockaddr*)&addr, sizeof(addr));
+    }else{
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, where.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(where.c_str());
+        ret = bind(fd, (sockaddr*)&addr, sizeof(addr));
+    }
+    if(ret != 0 || (stream && listen(fd, COLLECTOR_LISTEN_BACKLOG) != 0)){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void ServeDatagrams(int fd, bool quiet, Stats& stats){
+    std::vector<char> buffers((size_t)COLLECTOR_RECV_BATCH * COLLECTOR_BUFFER_SIZE);
+    mmsghdr msgs[COLLECTOR_RECV_BATCH];
+    iovec iovs[COLLECTOR_RECV_BATCH];
+    while(!g_stop){
+        for(size_t i = 0; i < COLLECTOR_RECV_BATCH; i++){
+            iovs[i].iov_base = &buffers[i * COLLECTOR_BUFFER_SIZE];
+            iovs[i].iov_len = COLLECTOR_BUFFER_SIZE;
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        // 阻塞到至少一个报文，之后取走已到达的全部(至多一批)
+        int n = recvmmsg(fd, msgs, COLLECTOR_RECV_BATCH, MSG_WAITFORONE, nullptr);
+        if(n < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            perror("recvmmsg");
+            return;
+        }
+        for(int i = 0; i < n; i++){
+            stats.datagrams++;
+            Consume((const char*)iovs[i].iov_base, msgs[i].msg_len, quiet, stats);
+        }
+    }
+}
+
+static void ServeStream(int listen_fd, bool quiet, Stats& stats){
+    std::vector<pollfd> fds;
+    fds.push_back(pollfd{listen_fd, POLLIN, 0});
+    std::vector<char> buffer(COLLECTOR_BUFFER_SIZE);
+    while(!g_stop){
+        if(poll(fds.data(), fds.size(), -1) < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            perror("poll");
+            return;
+        }
+        for(size_t i = fds.size(); i-- > 1;){
+            if(fds[i].revents == 0){
+                continue;
+            }
+            ssize_t n = read(fds[i].fd, buffer.data(), buffer.size());
+            if(n > 0){
+                Consume(buffer.data(), n, quiet, stats);
+            }else if(n == 0 || errno != EINTR){
+                close(fds[i].fd);
+                fds.erase(fds.begin() + i);
+            }
+        }
+        if(fds[0].revents & POLLIN){
+            int client = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if(client >= 0){
+                fds.push_back(pollfd{client, POLLIN, 0});
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        fprintf(stderr, "usage: %s unix:PATH | unix-stream:PATH | udp:PORT [-q]\n", argv[0]);
+        return 1;
+    }
+    std::string target = argv[1];
+    size_t colon = target.find(':');
+    std::string kind = target.substr(0, colon);
+    std::string where = (colon == std::string::npos ? "" : target.substr(colon + 1));
+    bool quiet = (argc > 2 && strcmp(argv[2], "-q") == 0);
+    if(where.empty() || (kind != "unix" && kind != "unix-stream" && kind != "udp")){
+        fprintf(stderr, "bad address: %s\n", argv[1]);
+        return 1;
+    }
+
+    // 不设SA_RESTART，使阻塞中的recvmmsg/poll以EINTR返回
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = OnStopSignal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    int fd = BindSocket(kind, where);
+    if(fd < 0){
+        perror("bind");
+        return 1;
+    }
+    Stats stats;
+    if(kind == "unix-stream"){
+        ServeStream(fd, quiet, stats);
+    }else{
+        ServeDatagrams(fd, quiet, stats);
+    }
+    fflush(stdout);
+    fprintf(stderr, "collector: %llu records, %llu bytes, %llu datagrams\n",
+            (unsigned long long)stats.records, (unsigned long long)stats.bytes, (unsigned long long)stats.datagrams);
+    close(fd);
+    if(kind != "udp"){
+        unlink(where.c_str());
+    }
+    return 0;
+}
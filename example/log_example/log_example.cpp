@@ -1,12 +1,28 @@
 #include <cstdio>
 #include "dysv/dy_log.hpp"
+#include "dysv/dy_async_log.hpp"
+#include "dysv/dy_file_sink.hpp"
+#include "dysv/dy_binary_log.hpp"
+#include "dysv/dy_log_stream.hpp"
+#include "dysv/dy_crash_handler.hpp"
+#include "dysv/dy_socket_sink.hpp"
 
 #define SINK_NAME_TMP_FILE      "name_tmp_file"
 #define TMP_FILE_PATH           "./tmp_file.txt"
 #define LOGGER_NAME_STD_ERROR   "log2stderr"
 #define SINK_NAME_STD_ERROR     "sink2stderr"
+#define LOGGER_NAME_ASYNC       "async_logger"
+#define SINK_NAME_ASYNC_FILE    "async_file"
+#define SINK_NAME_ROTATE        "rotate_file"
+#define ROTATE_FILE_PATH        "./rotate_file.txt"
+#define BINARY_FILE_PATH        "./binary_log.dybl"
+#define SINK_NAME_COLLECTOR     "collector"
+#define COLLECTOR_SOCKET_PATH   "/tmp/dysv.sock"
 
 int main(){
+    /*opt in first: on SIGSEGV/SIGABRT/SIGBUS the buffered and queued logs are written out before the process dies*/
+    dysv::CrashHandler::Install();
+
     /*just cout what you give.*/
     dysv::warn("Hello! Canary.");
     //console: Hello! Canary.
@@ -23,6 +39,16 @@ int main(){
     DY_LOG_FMT_WARN("%s answer is %d!", "Ultimate", 42);
     //console: [2022/02/08 12:49:31:394228][8065][/home/dysv/example/example.cpp][21][WARN][Ultimate answer is 42!]
     
+    /*type-safe "{}" format, checked against the argument types at compile time*/
+    DY_LOGF_WARN("{} answer is {:04}, pi is {:.2f}", "Ultimate", 42, 3.14159);
+    //console: [2022/02/08 12:49:31:394236][8065][/home/dysv/example/example.cpp][25][WARN][Ultimate answer is 0042, pi is 3.14]
+    dysv::warn("welcome {}", "dysv");
+    //console: welcome dysv
+
+    /*stream style, the operands are not evaluated when the level is filtered*/
+    DY_LOG_STREAM_WARN << "stream answer is " << 42 << ", pi is " << 3.14;
+    //console: [2022/02/08 12:49:31:394240][8065][/home/dysv/example/example.cpp][42][WARN][stream answer is 42, pi is 3.14]
+
     /*change default logger's pattern*/
     SET_DEFAULT_PATTERN("[%T][%P][%C][%F][%L][%D %H:%M:%S:%s]");
     //no output
@@ -59,6 +85,68 @@ int main(){
     my_logger->Logf(ADD_ADDITION_INFO, dysv::level::TRACE, "just have %s", "fun"); // written. 
     // // console: [2022/02/08 12:49:31:394356][TRACE][just have fun]
 
+    /*per sink level and pattern: records below every sink's level are rejected before formatting*/
+    auto terse_sink = std::make_shared<dysv::FileLoggerSink>(SINK_NAME_TMP_FILE, TMP_FILE_PATH);
+    terse_sink->SetLevel(dysv::level::WARN);
+    terse_sink->SetPattern("[%P][%C]%n");                   // each distinct pattern is rendered once per record
+    my_logger->AddSink(terse_sink);
+    my_logger->Log(ADD_ADDITION_INFO, dysv::level::INFO, "console only");
+    // // console: [2022/02/08 12:49:31:394360][INFO][console only]
+    my_logger->Log(ADD_ADDITION_INFO, dysv::level::ERROR, "both");
+    // // console: [2022/02/08 12:49:31:394364][ERROR][both]
+    // // file:    [ERROR][both]
+
+    /*async logger: callers only enqueue, a background thread patterns and sinks*/
+    auto async_logger = std::make_shared<dysv::AsyncLogger>(LOGGER_NAME_ASYNC, dysv::level::INFO, DEFAULT_PATTERN_STR);
+    async_logger->AddSink(std::make_shared<dysv::FileLoggerSink>(SINK_NAME_ASYNC_FILE, TMP_FILE_PATH));
+    async_logger->Logf(ADD_ADDITION_INFO, dysv::level::INFO, "written by %s", "backend");
+    async_logger->Flush();  // block until everything above is in the file
+    // //file: [2022/02/08 12:49:31:394400][8065][/home/dysv/example/example.cpp][63][INFO][written by backend]
+
+    /*rotating file sink: rotate_file.txt -> rotate_file.txt.1 ... when it grows past 1MB or at midnight*/
+    dysv::RotatePolicy rotate_policy;
+    rotate_policy.max_file_size = 1024 * 1024;
+    rotate_policy.interval_sec = 24 * 3600;
+    rotate_policy.max_files = 3;
+    ADD_SINK(std::make_shared<dysv::RotatingFileLoggerSink>(SINK_NAME_ROTATE, ROTATE_FILE_PATH, rotate_policy));
+    DY_LOG_WARN("rotate me!");
+    // //file: [8065][WARN][rotate me!][/home/dysv/example/example.cpp][87][2022/02/08 12:49:31:394420]
+
+    /*socket sink: batched datagrams to a local collector, run `dysv_log_collector unix:/tmp/dysv.sock` first*/
+    ADD_SINK(std::make_shared<dysv::SocketLoggerSink>(SINK_NAME_COLLECTOR, dysv::SocketSinkConfig::Unix(COLLECTOR_SOCKET_PATH)));
+    DY_LOG_INFO("shipped to the collector");    // never blocks: without a collector records are buffered, then dropped
+    DEL_SINK(SINK_NAME_COLLECTOR);
+
+    /*per call site rate limiting: suppressed calls cost an atomic op, arguments are not evaluated*/
+    for(int i = 0; i < 25; i++){
+        DY_LOGF_EVERY_N(dysv::level::WARN, 10, "queue is full, i={}", i);
+    }
+    // //file: [8065][WARN][queue is full, i=0][/home/dysv/example/example.cpp][92][2022/02/08 12:49:31:394425]
+    // //file: [8065][WARN][queue is full, i=10 (9 suppressed)][/home/dysv/example/example.cpp][92][2022/02/08 12:49:31:394428]
+    // //file: [8065][WARN][queue is full, i=20 (9 suppressed)][/home/dysv/example/example.cpp][92][2022/02/08 12:49:31:394430]
+    // DY_LOG_FIRST_N / DY_LOG_EVERY_MS / DY_LOG_RATE_LIMITED(lv, rate, burst, txt) work the same way
+
+    /*structured key-value logging, rendered by the pattern's encoding (text/json/logfmt)*/
+    DY_LOG_KV(INFO, "request served", "user", 42, "path", "/index.html", "latency_us", 17);
+    // //file: [8065][INFO][request served user=42 path=/index.html latency_us=17][/home/dysv/example/example.cpp][102][2022/02/08 12:49:31:394432]
+    DEFAULT_LOGGER->SetEncoding(dysv::ENCODING_JSON);
+    DY_LOG_KV(INFO, "request served", "user", 42, "path", "/index.html", "latency_us", 17);
+    // //file: {"thread":8065,"level":"INFO","msg":"request served","file":"/home/dysv/example/example.cpp","line":105,"time":"2022/02/08 12:49:31","us":"394436","user":42,"path":"/index.html","latency_us":17}
+    DEFAULT_LOGGER->SetEncoding(dysv::ENCODING_TEXT);
+
+    /*binary mode: DY_LOG_FMT_X and DY_LOGF_X only record the call site id, time and raw arguments*/
+    DEFAULT_LOGGER->SetBinaryWriter(std::make_shared<dysv::BinaryLogWriter>(BINARY_FILE_PATH));
+    DY_LOGF_INFO("{} answer is {}", "Ultimate", 42);
+    DEFAULT_LOGGER->SetBinaryWriter(nullptr);   // back to text mode, the writer flushes when released
+    // //shell: dysv_log_decode ./binary_log.dybl
+    // //       [8065][INFO][Ultimate answer is 42][/home/dysv/example/example.cpp][94][2022/02/08 12:49:31:394440]
+
+    /*runtime statistics: per logger accepted/filtered/dropped, per sink records/bytes and Sink() latency*/
+    std::cout << DEFAULT_LOGGER_MANGER->Snapshot().ToString();
+    // //console: 2022/02/08 12:49:31 [dysv stats] logger=__root__ accepted=12 filtered=1 dropped=0 queue_depth=0
+    // //         2022/02/08 12:49:31 [dysv stats] logger=__root__ sink=__stdout__ records=12 bytes=960 dropped=0 sink_p50_ns=4096 ...
+    // DEFAULT_LOGGER_MANGER->StartStatsReport(sink, 60 * 1000);  // or write the per-minute deltas to a sink
+
     return 0;
 }
 
@@ -0,0 +1,206 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <any>
+#include <chrono>
+#include <future>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "dysv/dy_net.hpp"
+
+/**
+ * @brief 本机回环压测工具，dysv_net_server的客户端。
+ *        闭环：每个连接发出一个请求，收到完整响应后记录延迟并立即发出下一个; 连接均分到若干个EventLoop线程。
+ *        结束时输出每秒请求数与延迟分位数(p50/p99/p999)。
+ * @usage dysv_net_loadgen [host] [port] [connections] [threads] [seconds] [echo|http] [size]
+ *        默认 127.0.0.1 9000 64 1 5 echo 64; size为echo模式的消息字节数
+ * @example
+ *      dysv_net_server 9000 2 http &
+ *      dysv_net_loadgen 127.0.0.1 9000 64 2 10 http
+ */
+
+#define LOADGEN_WARMUP_MS       500     // 预热时间，期间的请求不计入统计
+#define LOADGEN_HTTP_REQUEST    "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"
+
+using Clock = std::chrono::steady_clock;
+
+struct LoadConfig{
+    std::string host = "127.0.0.1";
+    uint16_t    port = 9000;
+    size_t      connections = 64;
+    size_t      threads = 1;
+    int         seconds = 5;
+    bool        http = false;
+    size_t      size = 64;
+};
+
+// 每个连接的状态，存放在TcpConnection::Context中
+struct ClientState{
+    Clock::time_point   sent;
+};
+
+// 一个压测线程：一个EventLoop及分到它的连接，延迟只在本线程记录
+class LoadWorker
+{
+public:
+    LoadWorker(const LoadConfig& config, size_t connections) : m_config(config), m_connections(connections),
+                                                                m_loop(nullptr), m_measuring(false){
+        if(config.http){
+            m_request = LOADGEN_HTTP_REQUEST;
+        }else{
+            m_request.assign(config.size, 'x');
+        }
+        m_latencies.reserve(1 << 20);
+    }
+
+    void Start(){
+        std::promise<void> ready;
+        m_thread = std::thread([this, &ready]{ Run(&ready); });
+        ready.get_future().wait();
+    }
+
+    void SetMeasuring(bool measuring){
+        m_loop->RunInLoop([this, measuring]{ m_measuring = measuring; });
+    }
+
+    void Stop(){
+        m_loop->RunInLoop([this]{
+            for(auto& conn : m_conns){
+                conn->ForceClose();
+            }
+            m_loop->Quit();
+        });
+        m_thread.join();
+    }
+
+    const std::vector<uint32_t>& Latencies() const{ return m_latencies; }
+    size_t Errors() const{ return m_errors; }
+private:
+    void Run(std::promise<void>* ready){
+        dysv::EventLoop loop;
+        m_loop = &loop;
+        for(size_t i = 0; i < m_connections; i++){
+            dysv::TcpConnectionPtr conn = dysv::TcpConnection::Connect(&loop, m_config.host, m_config.port);
+            if(!conn){
+                m_errors++;
+                continue;
+            }
+            conn->Context() = ClientState();
+            conn->SetMessageCallback([this](const dysv::TcpConnectionPtr& c, dysv::InputBuffer& input){
+                OnMessage(c, input);
+            });
+            conn->Start();
+            m_conns.push_back(conn);
+        }
+        ready->set_value();
+        for(auto& conn : m_conns){
+            SendRequest(conn);
+        }
+        loop.Loop();
+        m_conns.clear();
+    }
+
+    void SendRequest(const dysv::TcpConnectionPtr& conn){
+        std::any_cast<ClientState&>(conn->Context()).sent = Clock::now();
+        conn->Send(m_request);
+    }
+
+    // 返回缓冲开头完整响应的长度，不完整时返回0
+    size_t ResponseLength(std::string_view data) const{
+        if(!m_config.http){
+            return data.size() >= m_request.size() ? m_request.size() : 0;
+        }
+        size_t end = data.find("\r\n\r\n");
+        if(end == std::string_view::npos){
+            return 0;
+        }
+        size_t body = 0;
+        std::string_view header = data.substr(0, end);
+        size_t pos = header.find("Content-Length:");
+        if(pos != std::string_view::npos){
+            body = (size_t)atol(std::string(header.substr(pos + 15, 16)).c_str());
+        }
+        return data.size() >= end + 4 + body ? end + 4 + body : 0;
+    }
+
+    void OnMessage(const dysv::TcpConnectionPtr& conn, dysv::InputBuffer& input){
+        size_t len;
+        while((len = ResponseLength(input.View())) > 0){
+            input.Retrieve(len);
+            if(m_measuring){
+                auto sent = std::any_cast<ClientState&>(conn->Context()).sent;
+                m_latencies.push_back((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sent).count());
+            }
+            SendRequest(conn);
+        }
+    }
+
+    const LoadConfig&                       m_config;
+    size_t                                  m_connections;
+    std::string                             m_request;
+    std::thread                             m_thread;
+    dysv::EventLoop*                        m_loop;
+    std::vector<dysv::TcpConnectionPtr>     m_conns;
+    bool                                    m_measuring;
+    std::vector<uint32_t>                   m_latencies;    // 微秒
+    size_t                                  m_errors = 0;
+};
+
+static uint32_t Percentile(const std::vector<uint32_t>& sorted, double p){
+    if(sorted.empty()){
+        return 0;
+    }
+    size_t index = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+    return sorted[index];
+}
+
+int main(int argc, char** argv){
+    LoadConfig config;
+    if(argc > 1) config.host = argv[1];
+    if(argc > 2) config.port = (uint16_t)atoi(argv[2]);
+    if(argc > 3) config.connections = std::max(1, atoi(argv[3]));
+    if(argc > 4) config.threads = std::max(1, atoi(argv[4]));
+    if(argc > 5) config.seconds = std::max(1, atoi(argv[5]));
+    if(argc > 6) config.http = (strcmp(argv[6], "http") == 0);
+    if(argc > 7) config.size = std::max(1, atoi(argv[7]));
+
+    std::vector<std::unique_ptr<LoadWorker>> workers;
+    for(size_t i = 0; i < config.threads; i++){
+        size_t conns = config.connections / config.threads + (i < config.connections % config.threads ? 1 : 0);
+        workers.emplace_back(new LoadWorker(config, conns));
+        workers.back()->Start();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOADGEN_WARMUP_MS));
+    for(auto& w : workers){
+        w->SetMeasuring(true);
+    }
+    auto begin = Clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(config.seconds));
+    for(auto& w : workers){
+        w->SetMeasuring(false);
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::vector<uint32_t> latencies;
+    size_t errors = 0;
+    for(auto& w : workers){
+        w->Stop();
+        latencies.insert(latencies.end(), w->Latencies().begin(), w->Latencies().end());
+        errors += w->Errors();
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("%s:%u %s, %zu connection(s), %zu thread(s), %.1fs%s\n", config.host.c_str(), config.port,
+            config.http ? "http" : "echo", config.connections, config.threads, elapsed,
+            errors > 0 ? " (some connects failed)" : "");
+    printf("requests   %zu\n", latencies.size());
+    printf("rps        %.0f\n", latencies.size() / elapsed);
+    printf("latency us p50 %u  p99 %u  p999 %u  max %u\n", Percentile(latencies, 0.50), Percentile(latencies, 0.99),
+            Percentile(latencies, 0.999), latencies.empty() ? 0 : latencies.back());
+    return latencies.empty() ? 1 : 0;
+}
@@ -0,0 +1,75 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <pthread.h>
+#include "dysv/dy_net.hpp"
+#include "dysv/dy_log.hpp"
+
+/**
+ * @brief dysv::TcpServer示例：echo或极简HTTP(keep-alive，任何请求都回复同一个200响应)。
+ *        配合dysv_net_loadgen在本机回环上测量吞吐与尾延迟; 也可用wrk等工具压测http模式。
+ * @usage dysv_net_server [port] [threads] [echo|http] [idle_ms]
+ *        默认端口9000，1个循环线程，echo模式，不关闭空闲连接; SIGINT/SIGTERM时退出
+ * @example
+ *      dysv_net_server 9000 4 http &
+ *      dysv_net_loadgen 127.0.0.1 9000 64 2 10 http
+ */
+
+#define SERVER_DEFAULT_PORT     9000
+#define SERVER_HTTP_BODY        "hello from dysv\n"
+
+// 找出缓冲中完整的请求(以空行结束，不处理请求体)，每个回复一次
+static void OnHttpMessage(const dysv::TcpConnectionPtr& conn, dysv::InputBuffer& input){
+    static const std::string_view body(SERVER_HTTP_BODY);
+    static const std::string header = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: keep-alive\r\n"
+                                      "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    for(;;){
+        std::string_view data = input.View();
+        size_t end = data.find("\r\n\r\n");
+        if(end == std::string_view::npos){
+            return;
+        }
+        conn->Send({header, body});
+        input.Retrieve(end + 4);
+    }
+}
+
+static void OnEchoMessage(const dysv::TcpConnectionPtr& conn, dysv::InputBuffer& input){
+    conn->Send(input.View());
+    input.RetrieveAll();
+}
+
+int main(int argc, char** argv){
+    dysv::TcpServerConfig config;
+    config.port = argc > 1 ? (uint16_t)atoi(argv[1]) : SERVER_DEFAULT_PORT;
+    config.threads = argc > 2 ? (size_t)atoi(argv[2]) : 1;
+    std::string mode = argc > 3 ? argv[3] : "echo";
+    config.idle_timeout_ms = argc > 4 ? (uint32_t)atoi(argv[4]) : 0;
+    if(mode != "echo" && mode != "http"){
+        fprintf(stderr, "usage: %s [port] [threads] [echo|http] [idle_ms]\n", argv[0]);
+        return 1;
+    }
+
+    // 在启动循环线程前屏蔽信号，由主线程sigwait等待退出
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    dysv::TcpServer server(config);
+    server.SetMessageCallback(mode == "http" ? OnHttpMessage : OnEchoMessage);
+    if(!server.Start()){
+        return 1;
+    }
+    DY_LOGF_INFO("net server: {} mode on port {}", mode, server.GetPort());
+
+    int sig = 0;
+    sigwait(&signals, &sig);
+    DY_LOGF_INFO("net server: got signal {}, {} connection(s) open, stopping", sig, server.GetConnectionCount());
+    server.Stop();
+    return 0;
+}
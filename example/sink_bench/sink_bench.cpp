@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <fstream>
+#include "dysv/dy_log.hpp"
+#include "dysv/dy_file_sink.hpp"
+#include "dysv/dy_uring_sink.hpp"
+
+/**
+ * @brief 文件sink基准：对比每条记录的write(2)次数与耗时。
+ *        syscalls通过/proc/self/io中的syscw(本进程write类系统调用计数)统计。
+ *        io_uring的写请求经io_uring_enter提交、由内核完成，不计入syscw。
+ * @usage dysv_sink_bench [records] [output_dir]
+ */
+
+#define BENCH_DEFAULT_RECORDS   200000
+#define BENCH_LOGGER_NAME       "sink_bench"
+
+// 旧版FileLoggerSink的行为：std::ofstream + std::endl，每条记录一次flush
+class LegacyOfstreamSink : public dysv::LoggerSinkInterface
+{
+public:
+    LegacyOfstreamSink(const std::string& name, const std::string& file_name)
+                        : LoggerSinkInterface(name), m_stream(file_name, std::ios::app){}
+    void Sink(const std::string& content) override{
+        m_stream << content << std::endl;
+    }
+    void Flush() override{
+        m_stream.flush();
+    }
+private:
+    std::ofstream m_stream;
+};
+
+static long ReadWriteSyscalls(){
+    FILE* fp = fopen("/proc/self/io", "r");
+    if(fp == nullptr){
+        return -1;
+    }
+    char line[128];
+    long syscw = -1;
+    while(fgets(line, sizeof(line), fp) != nullptr){
+        if(strncmp(line, "syscw:", 6) == 0){
+            syscw = atol(line + 6);
+        }
+    }
+    fclose(fp);
+    return syscw;
+}
+
+static void RunCase(const char* case_name, dysv::LoggerSinkInterface::ptr sink, long records){
+    auto logger = std::make_shared<dysv::Logger>(BENCH_LOGGER_NAME, dysv::level::TRACE, DEFAULT_PATTERN_STR);
+    logger->AddSink(sink);
+
+    long syscw_begin = ReadWriteSyscalls();
+    auto begin = std::chrono::steady_clock::now();
+    for(long i = 0; i < records; i++){
+        logger->LogFmt(ADD_ADDITION_INFO, dysv::level::INFO, "request {} served in {} us", i, i % 977);
+    }
+    logger->Flush();
+    auto end = std::chrono::steady_clock::now();
+    long syscw_end = ReadWriteSyscalls();
+
+    double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+    printf("%-22s records=%-8ld write_syscalls=%-8ld syscalls/record=%-8.4f ns/record=%.1f\n",
+            case_name, records, syscw_end - syscw_begin, (double)(syscw_end - syscw_begin) / records, ns / records);
+}
+
+int main(int argc, char** argv){
+    long records = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_RECORDS;
+    std::string dir = argc > 2 ? argv[2] : ".";
+
+    RunCase("legacy ofstream+endl",
+            std::make_shared<LegacyOfstreamSink>("legacy", dir + "/bench_legacy.log"), records);
+    RunCase("file immediate",
+            std::make_shared<dysv::FileLoggerSink>("immediate", dir + "/bench_immediate.log",
+                                                    dysv::FileFlushPolicy::Immediate()), records);
+    RunCase("file buffered 64KB",
+            std::make_shared<dysv::FileLoggerSink>("buffered", dir + "/bench_buffered.log"), records);
+
+    dysv::FileFlushPolicy big;
+    big.buffer_size = 1024 * 1024;
+    RunCase("file buffered 1MB",
+            std::make_shared<dysv::FileLoggerSink>("buffered_1m", dir + "/bench_buffered_1m.log", big), records);
+    RunCase("mmap 16MB segments",
+            std::make_shared<dysv::MmapFileLoggerSink>("mmap", dir + "/bench_mmap.log"), records);
+    auto uring = std::make_shared<dysv::IoUringFileLoggerSink>("uring", dir + "/bench_uring.log");
+    RunCase(uring->IsUringEnabled() ? "io_uring 8x64KB" : "io_uring (pwrite fallback)", uring, records);
+    return 0;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace dysv{
+    // 缓存行大小。被多个线程分别频繁写入的成员以此对齐，避免伪共享; 各公共组件共用这一处定义
+#define DYSV_CACHE_LINE_SIZE 64
+} // namespace dysv
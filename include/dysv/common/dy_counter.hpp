@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "dy_cache_line.hpp"
+
+namespace dysv{
+#define DYSV_COUNTER_STRIPES 16     // 计数器的条带数，线程按首次使用的顺序轮流分到各条带
+#define DYSV_HISTOGRAM_BUCKETS 64   // 直方图桶数，第i桶统计[2^(i-1), 2^i)，第0桶统计0
+#define DYSV_THREAD_COUNTER_SLOTS 64    // 线程私有计数器的槽位数，槽位用尽后新建的计数器退化为共享的原子计数
+
+    // 当前线程使用的条带下标，线程内缓存
+    inline size_t ThreadStripe(){
+        static std::atomic<size_t> s_next_stripe{0};
+        static thread_local size_t t_stripe = s_next_stripe.fetch_add(1, std::memory_order_relaxed) % DYSV_COUNTER_STRIPES;
+        return t_stripe;
+    }
+
+    /**
+     * @brief 按缓存行分条带的一组计数器。写入只落在本线程的条带上(一次relaxed原子加)，读取时汇总所有条带。
+     *        读到的是近似的瞬时值，各字段之间不保证一致。
+     *
+     * @tparam FIELDS 计数器个数
+     */
+    template<size_t FIELDS>
+    class StripedCounters{
+    public:
+        void Add(size_t field, uint64_t n = 1){
+            m_cells[ThreadStripe()].values[field].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        uint64_t Sum(size_t field) const{
+            uint64_t sum = 0;
+            for(const Cell& cell : m_cells){
+                sum += cell.values[field].load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+    private:
+        struct alignas(DYSV_CACHE_LINE_SIZE) Cell{
+            std::atomic<uint64_t> values[FIELDS] = {};
+        };
+        Cell m_cells[DYSV_COUNTER_STRIPES];
+    };
+
+    /**
+     * @brief ThreadCounter的线程私有部分：每个线程一块(独占缓存行)，登记在全局表中供汇总，线程退出时并入退役值。
+     *
+     */
+    class ThreadCounterRegistry{
+    public:
+        struct alignas(DYSV_CACHE_LINE_SIZE) Block{
+            std::atomic<uint64_t> values[DYSV_THREAD_COUNTER_SLOTS] = {};
+
+            Block(){
+                ThreadCounterRegistry& reg = Instance();
+                std::lock_guard<std::mutex> lk(reg.m_mutex);
+                reg.m_blocks.push_back(this);
+            }
+            ~Block(){
+                ThreadCounterRegistry& reg = Instance();
+                std::lock_guard<std::mutex> lk(reg.m_mutex);
+                for(size_t i = 0; i < DYSV_THREAD_COUNTER_SLOTS; i++){
+                    reg.m_retired[i] += values[i].load(std::memory_order_relaxed);
+                }
+                for(size_t i = 0; i < reg.m_blocks.size(); i++){
+                    if(reg.m_blocks[i] == this){
+                        reg.m_blocks[i] = reg.m_blocks.back();
+                        reg.m_blocks.pop_back();
+                        break;
+                    }
+                }
+            }
+        };
+
+        // 不析构，线程退出(含主线程在静态对象析构之后)时仍可访问
+        static ThreadCounterRegistry& Instance(){
+            static ThreadCounterRegistry* s_registry = new ThreadCounterRegistry();
+            return *s_registry;
+        }
+
+        static Block& LocalBlock(){
+            static thread_local Block t_block;
+            return t_block;
+        }
+
+        // 没有空闲槽位时返回DYSV_THREAD_COUNTER_SLOTS
+        size_t Claim(){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for(size_t i = 0; i < DYSV_THREAD_COUNTER_SLOTS; i++){
+                if(!m_claimed[i]){
+                    m_claimed[i] = true;
+                    return i;
+                }
+            }
+            return DYSV_THREAD_COUNTER_SLOTS;
+        }
+
+        // 清零后归还，下一个使用者从0开始计数
+        void Release(size_t slot){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            for(Block* block : m_blocks){
+                block->values[slot].store(0, std::memory_order_relaxed);
+            }
+            m_retired[slot] = 0;
+            m_claimed[slot] = false;
+        }
+
+        uint64_t Sum(size_t slot){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            uint64_t sum = m_retired[slot];
+            for(Block* block : m_blocks){
+                sum += block->values[slot].load(std::memory_order_relaxed);
+            }
+            return sum;
+        }
+    private:
+        ThreadCounterRegistry() = default;
+
+        std::mutex          m_mutex;
+        std::vector<Block*> m_blocks;       // 存活线程的块
+        uint64_t            m_retired[DYSV_THREAD_COUNTER_SLOTS] = {};  // 已退出线程的累计值
+        bool                m_claimed[DYSV_THREAD_COUNTER_SLOTS] = {};
+    };
+
+    /**
+     * @brief 线程私有的单个计数器。写入只读写本线程块中的一个槽位(relaxed读后写，没有原子读改写，也不碰共享缓存行)，
+     *        读取时加锁汇总各线程。适合热路径上频繁递增而很少读取的计数，如被级别过滤的日志调用数。
+     *
+     */
+    class ThreadCounter{
+    public:
+        ThreadCounter() : m_slot(ThreadCounterRegistry::Instance().Claim()){}
+        ~ThreadCounter(){
+            if(m_slot < DYSV_THREAD_COUNTER_SLOTS){
+                ThreadCounterRegistry::Instance().Release(m_slot);
+            }
+        }
+        ThreadCounter(const ThreadCounter&) = delete;
+        ThreadCounter& operator=(const ThreadCounter&) = delete;
+
+        void Add(uint64_t n = 1){
+            if(m_slot < DYSV_THREAD_COUNTER_SLOTS){
+                std::atomic<uint64_t>& value = ThreadCounterRegistry::LocalBlock().values[m_slot];
+                value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }else{
+                m_overflow.fetch_add(n, std::memory_order_relaxed);
+            }
+        }
+
+        uint64_t Sum() const{
+            if(m_slot < DYSV_THREAD_COUNTER_SLOTS){
+                return ThreadCounterRegistry::Instance().Sum(m_slot);
+            }
+            return m_overflow.load(std::memory_order_relaxed);
+        }
+    private:
+        size_t                  m_slot;
+        std::atomic<uint64_t>   m_overflow{0};
+    };
+
+    /**
+     * @brief 以2为底对数分桶的直方图，按条带分散写入。用于记录耗时(纳秒)等跨越多个数量级的数值。
+     *
+     */
+    class StripedHistogram{
+    public:
+        static size_t BucketOf(uint64_t value){
+            size_t bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+            return bucket < DYSV_HISTOGRAM_BUCKETS ? bucket : DYSV_HISTOGRAM_BUCKETS - 1;
+        }
+
+        // 第bucket桶的上界(不含)
+        static uint64_t BucketUpperBound(size_t bucket){
+            return bucket >= DYSV_HISTOGRAM_BUCKETS - 1 ? UINT64_MAX : (1ULL << bucket);
+        }
+
+        void Record(uint64_t value){
+            Cell& cell = m_cells[ThreadStripe()];
+            cell.buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            uint64_t max = cell.max.load(std::memory_order_relaxed);
+            if(value > max){
+                // 条带内通常只有一个写线程，偶发的竞争最多丢掉一次最大值更新
+                cell.max.store(value, std::memory_order_relaxed);
+            }
+        }
+
+        // 汇总各桶计数到buckets[DYSV_HISTOGRAM_BUCKETS]，返回记录过的最大值
+        uint64_t Collect(uint64_t* buckets) const{
+            uint64_t max = 0;
+            for(size_t i = 0; i < DYSV_HISTOGRAM_BUCKETS; i++){
+                buckets[i] = 0;
+            }
+            for(const Cell& cell : m_cells){
+                for(size_t i = 0; i < DYSV_HISTOGRAM_BUCKETS; i++){
+                    buckets[i] += cell.buckets[i].load(std::memory_order_relaxed);
+                }
+                uint64_t m = cell.max.load(std::memory_order_relaxed);
+                max = m > max ? m : max;
+            }
+            return max;
+        }
+    private:
+        struct alignas(DYSV_CACHE_LINE_SIZE) Cell{
+            std::atomic<uint64_t> buckets[DYSV_HISTOGRAM_BUCKETS] = {};
+            std::atomic<uint64_t> max{0};
+        };
+        Cell m_cells[DYSV_COUNTER_STRIPES];
+    };
+} // namespace dysv
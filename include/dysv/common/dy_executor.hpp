@@ -0,0 +1,527 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include "dy_ws_deque.hpp"
+
+/**
+ * @brief 工作窃取线程池。
+ * @feature 每个工作线程一个Chase-Lev双端队列(dy_ws_deque.hpp)：工作线程内提交的任务压入自己队列的底部(后进先出)，
+ *          空闲时依次从外部注入队列、其他线程队列的顶部窃取; 外部线程提交的任务进入一个加锁的注入队列;
+ *          找不到任务时短暂空转后休眠，提交时只在有线程休眠时才加锁唤醒;
+ *          可选按CPU绑定工作线程; Post提交不关心结果的任务，Submit返回Future，Future::Then挂接后续任务。
+ * @note Post的任务抛出的异常被忽略，Submit/Then的异常保存在Future中，Get时重新抛出;
+ *       Future上挂接的后续任务提交到产生它的线程池，线程池须比尚未完成的Future活得久。
+ * @example
+ *      dysv::Executor ex;                                  // 线程数默认取硬件并发数
+ *      ex.Post([]{ ... });
+ *      auto f = ex.Submit([]{ return 6 * 7; })
+ *                 .Then([](int v){ return std::to_string(v); });
+ *      std::string s = f.Get();                            // "42"
+ */
+
+namespace dysv{
+#define EXECUTOR_DEQUE_CAPACITY     256     // 每个工作线程队列的初始容量
+#define EXECUTOR_SPIN_ROUNDS        64      // 找不到任务时休眠前的空转轮数
+#define EXECUTOR_THREAD_NAME_LEN    15      // 线程名的最大长度(不含'\0')
+
+    struct ExecutorConfig{
+        size_t      threads = 0;            // 工作线程数，0表示取硬件并发数
+        bool        pin_cpus = false;       // 第i个工作线程绑定到进程可用的第(i % N)个CPU
+        std::string name = "dysv-exec";     // 线程名前缀，工作线程显示为name-i
+    };
+
+    class Executor;
+    template<class T> class Future;
+    template<class T> class Promise;
+
+    namespace detail{
+        // 类型擦除的任务，提交时一次堆分配
+        struct ExecutorTask{
+            virtual ~ExecutorTask() = default;
+            virtual void Run() = 0;
+        };
+
+        template<class F>
+        struct ExecutorTaskImpl : ExecutorTask{
+            template<class G>
+            explicit ExecutorTaskImpl(G&& g) : fn(std::forward<G>(g)){}
+            void Run() override{
+                fn();
+            }
+            F fn;
+        };
+
+        template<class F>
+        ExecutorTask* MakeTask(F&& f){
+            return new ExecutorTaskImpl<std::decay_t<F>>(std::forward<F>(f));
+        }
+
+        struct Unit{};
+        template<class T>
+        using FutureStorage = std::conditional_t<std::is_void<T>::value, Unit, T>;
+
+        template<class T>
+        struct FutureState{
+            std::mutex                                  mutex;
+            std::condition_variable                     cv;
+            bool                                        ready = false;
+            std::optional<FutureStorage<T>>             value;
+            std::exception_ptr                          error;
+            std::vector<std::unique_ptr<ExecutorTask>>  continuations;  // 完成时提交
+            Executor*                                   executor = nullptr;
+        };
+
+        // 后续任务交给线程池执行，没有线程池时在完成的线程上直接执行
+        inline void Dispatch(Executor* executor, std::unique_ptr<ExecutorTask> task);
+
+        // Then的回调以前一个结果为参数(void时无参数)
+        template<class F, class T, bool = std::is_void<T>::value>
+        struct ThenResult{
+            using type = std::invoke_result_t<F&, T>;
+        };
+        template<class F, class T>
+        struct ThenResult<F, T, true>{
+            using type = std::invoke_result_t<F&>;
+        };
+
+        // 调用fn并把结果或异常写入promise
+        template<class R, class Fn>
+        void Fulfill(Promise<R>& promise, Fn&& fn){
+            try{
+                if constexpr(std::is_void<R>::value){
+                    fn();
+                    promise.SetValue();
+                }else{
+                    promise.SetValue(fn());
+                }
+            }catch(...){
+                promise.SetException(std::current_exception());
+            }
+        }
+    } // namespace detail
+
+    /**
+     * @brief 异步结果。可移动不可拷贝; Get只能调用一次(取走结果)。
+     *
+     */
+    template<class T>
+    class Future{
+    public:
+        Future() = default;
+        Future(Future&&) = default;
+        Future& operator=(Future&&) = default;
+        Future(const Future&) = delete;
+        Future& operator=(const Future&) = delete;
+
+        bool Valid() const{
+            return m_state != nullptr;
+        }
+
+        bool IsReady() const{
+            std::lock_guard<std::mutex> lk(m_state->mutex);
+            return m_state->ready;
+        }
+
+        void Wait() const{
+            std::unique_lock<std::mutex> lk(m_state->mutex);
+            m_state->cv.wait(lk, [this]{ return m_state->ready; });
+        }
+
+        // 超时返回false
+        bool WaitFor(uint32_t timeout_ms) const{
+            std::unique_lock<std::mutex> lk(m_state->mutex);
+            return m_state->cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this]{ return m_state->ready; });
+        }
+
+        // 等待并取走结果; 任务抛出的异常在此重新抛出
+        T Get(){
+            Wait();
+            std::shared_ptr<detail::FutureState<T>> state = std::move(m_state);
+            if(state->error){
+                std::rethrow_exception(state->error);
+            }
+            if constexpr(!std::is_void<T>::value){
+                return std::move(*state->value);
+            }
+        }
+
+        /**
+         * @brief 挂接后续任务：本结果就绪后以结果为参数调用f(T为void时无参数)，返回f结果的Future。
+         *        本结果为异常时不调用f，异常传给返回的Future。调用后本对象失效。
+         *
+         */
+        template<class F>
+        Future<typename detail::ThenResult<std::decay_t<F>, T>::type> Then(F&& f){
+            using R = typename detail::ThenResult<std::decay_t<F>, T>::type;
+            std::shared_ptr<detail::FutureState<T>> state = std::move(m_state);
+            Promise<R> next(state->executor);
+            Future<R> result = next.GetFuture();
+            auto continuation = [state, next, fn = std::forward<F>(f)]() mutable{
+                if(state->error){
+                    next.SetException(state->error);
+                    return;
+                }
+                detail::Fulfill(next, [&]() -> R{
+                    if constexpr(std::is_void<T>::value){
+                        return fn();
+                    }else{
+                        return fn(std::move(*state->value));
+                    }
+                });
+            };
+            std::unique_ptr<detail::ExecutorTask> task(detail::MakeTask(std::move(continuation)));
+            {
+                std::lock_guard<std::mutex> lk(state->mutex);
+                if(!state->ready){
+                    state->continuations.push_back(std::move(task));
+                    return result;
+                }
+            }
+            detail::Dispatch(state->executor, std::move(task));
+            return result;
+        }
+    private:
+        friend class Promise<T>;
+        explicit Future(std::shared_ptr<detail::FutureState<T>> state) : m_state(std::move(state)){}
+
+        std::shared_ptr<detail::FutureState<T>> m_state;
+    };
+
+    /**
+     * @brief 异步结果的写入端。可拷贝(共享同一结果)，只有第一次SetValue/SetException生效。
+     *
+     */
+    template<class T>
+    class Promise{
+    public:
+        // executor为后续任务的执行者，为空时后续任务在完成的线程上直接执行
+        explicit Promise(Executor* executor = nullptr) : m_state(std::make_shared<detail::FutureState<T>>()){
+            m_state->executor = executor;
+        }
+
+        Future<T> GetFuture() const{
+            return Future<T>(m_state);
+        }
+
+        template<class... V>
+        void SetValue(V&&... value){
+            std::vector<std::unique_ptr<detail::ExecutorTask>> continuations;
+            {
+                std::lock_guard<std::mutex> lk(m_state->mutex);
+                if(m_state->ready){
+                    return;
+                }
+                m_state->value.emplace(std::forward<V>(value)...);
+                m_state->ready = true;
+                continuations.swap(m_state->continuations);
+            }
+            Complete(continuations);
+        }
+
+        void SetException(std::exception_ptr error){
+            std::vector<std::unique_ptr<detail::ExecutorTask>> continuations;
+            {
+                std::lock_guard<std::mutex> lk(m_state->mutex);
+                if(m_state->ready){
+                    return;
+                }
+                m_state->error = error;
+                m_state->ready = true;
+                continuations.swap(m_state->continuations);
+            }
+            Complete(continuations);
+        }
+    private:
+        void Complete(std::vector<std::unique_ptr<detail::ExecutorTask>>& continuations){
+            m_state->cv.notify_all();
+            for(auto& task : continuations){
+                detail::Dispatch(m_state->executor, std::move(task));
+            }
+        }
+
+        std::shared_ptr<detail::FutureState<T>> m_state;
+    };
+
+    /**
+     * @brief 工作窃取线程池。工作线程按序号各有一个双端队列; 当前线程所属的线程池与序号缓存在线程局部变量中，
+     *        工作线程内的Post不加锁、不经过共享队列，没有线程休眠时也不写任何共享变量。
+     *        休眠与唤醒：工作线程先登记m_sleeping，经顺序一致的栅栏后读m_epoch并复查一遍所有队列; 提交方先入队，
+     *        经顺序一致的栅栏后读m_sleeping，只在有线程休眠时才递增m_epoch并加锁唤醒。两道栅栏保证双方至少有一方看到对方:
+     *        提交方读到0时，登记晚于它的工作线程在复查中必能看到新任务。
+     *
+     */
+    class Executor
+    {
+    public:
+        using ptr = std::shared_ptr<Executor>;
+
+        explicit Executor(const ExecutorConfig& config = ExecutorConfig())
+                            : m_config(config), m_stop(false), m_joined(false), m_injected_count(0),
+                              m_sleeping(0), m_epoch(0){
+            size_t threads = m_config.threads;
+            if(threads == 0){
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            if(m_config.pin_cpus){
+                cpu_set_t allowed;
+                CPU_ZERO(&allowed);
+                if(sched_getaffinity(0, sizeof(allowed), &allowed) == 0){
+                    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+                        if(CPU_ISSET(cpu, &allowed)){
+                            m_cpus.push_back(cpu);
+                        }
+                    }
+                }
+            }
+            for(size_t i = 0; i < threads; i++){
+                m_workers.emplace_back(new Worker());
+            }
+            // 所有队列就绪后再启动线程，工作线程可以立即窃取任意队列
+            for(size_t i = 0; i < threads; i++){
+                m_workers[i]->thread = std::thread(&Executor::WorkerLoop, this, i);
+            }
+        }
+
+        ~Executor(){
+            Shutdown();
+        }
+
+        Executor(const Executor&) = delete;
+        Executor& operator=(const Executor&) = delete;
+
+        // 提交不关心结果的任务
+        template<class F>
+        void Post(F&& f){
+            PostTask(detail::MakeTask(std::forward<F>(f)));
+        }
+
+        // 提交任务，返回其结果的Future
+        template<class F>
+        Future<std::invoke_result_t<std::decay_t<F>&>> Submit(F&& f){
+            using R = std::invoke_result_t<std::decay_t<F>&>;
+            Promise<R> promise(this);
+            Future<R> result = promise.GetFuture();
+            Post([promise, fn = std::forward<F>(f)]() mutable{
+                detail::Fulfill(promise, fn);
+            });
+            return result;
+        }
+
+        // 提交已构造的任务，取得其所有权
+        void PostTask(detail::ExecutorTask* task){
+            ThreadContext& ctx = Context();
+            if(ctx.executor == this){
+                m_workers[ctx.index]->deque.Push(task);
+            }else{
+                std::unique_lock<std::mutex> lk(m_inject_mutex);
+                if(m_joined){
+                    // 已停止：在调用线程上直接执行，保证后续任务不丢失
+                    lk.unlock();
+                    RunTask(task);
+                    return;
+                }
+                m_injected.push_back(task);
+                m_injected_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            Wake();
+        }
+
+        /**
+         * @brief 执行完已提交的任务(包括执行中派生的任务)后停止并回收工作线程，可重复调用。
+         *        之后提交的任务在调用线程上直接执行。不能在工作线程中调用。
+         *
+         */
+        void Shutdown(){
+            {
+                std::lock_guard<std::mutex> lk(m_sleep_mutex);
+                m_stop.store(true);
+                m_epoch.fetch_add(1);
+            }
+            m_sleep_cv.notify_all();
+            for(auto& worker : m_workers){
+                if(worker->thread.joinable()){
+                    worker->thread.join();
+                }
+            }
+            std::deque<detail::ExecutorTask*> rest;
+            {
+                std::lock_guard<std::mutex> lk(m_inject_mutex);
+                m_joined = true;
+                rest.swap(m_injected);
+            }
+            for(detail::ExecutorTask* task : rest){
+                RunTask(task);
+            }
+        }
+
+        size_t GetThreadCount() const{
+            return m_workers.size();
+        }
+
+        // 累计窃取成功的次数
+        uint64_t GetStealCount() const{
+            uint64_t steals = 0;
+            for(const auto& worker : m_workers){
+                steals += worker->steals.load(std::memory_order_relaxed);
+            }
+            return steals;
+        }
+
+        // 当前线程所属的线程池，非工作线程返回nullptr
+        static Executor* Current(){
+            return Context().executor;
+        }
+    private:
+        struct ThreadContext{
+            Executor*   executor = nullptr;
+            size_t      index = 0;
+        };
+
+        struct Worker{
+            Worker() : deque(EXECUTOR_DEQUE_CAPACITY), steals(0){}
+
+            WorkStealingDeque<detail::ExecutorTask*>    deque;
+            std::thread                                 thread;
+            std::atomic<uint64_t>                       steals;
+        };
+
+        static ThreadContext& Context(){
+            thread_local ThreadContext t_context;
+            return t_context;
+        }
+
+        static void RunTask(detail::ExecutorTask* task){
+            try{
+                task->Run();
+            }catch(...){
+            }
+            delete task;
+        }
+
+        void Wake(){
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(m_sleeping.load(std::memory_order_relaxed) > 0){
+                m_epoch.fetch_add(1);
+                std::lock_guard<std::mutex> lk(m_sleep_mutex);
+                m_sleep_cv.notify_one();
+            }
+        }
+
+        // 依次：自己的队列底部、注入队列、其他队列顶部(从随机位置开始)
+        detail::ExecutorTask* FindTask(size_t index, uint64_t& rng){
+            detail::ExecutorTask* task = nullptr;
+            if(m_workers[index]->deque.Pop(task)){
+                return task;
+            }
+            if(m_injected_count.load(std::memory_order_relaxed) > 0){
+                std::lock_guard<std::mutex> lk(m_inject_mutex);
+                if(!m_injected.empty()){
+                    task = m_injected.front();
+                    m_injected.pop_front();
+                    m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+                    return task;
+                }
+            }
+            size_t count = m_workers.size();
+            rng ^= rng << 13;
+            rng ^= rng >> 7;
+            rng ^= rng << 17;
+            size_t start = (size_t)(rng % count);
+            for(size_t i = 0; i < count; i++){
+                size_t victim = (start + i) % count;
+                if(victim != index && m_workers[victim]->deque.Steal(task)){
+                    m_workers[index]->steals.fetch_add(1, std::memory_order_relaxed);
+                    return task;
+                }
+            }
+            return nullptr;
+        }
+
+        void SetupThread(size_t index){
+            std::string name = m_config.name + "-" + std::to_string(index);
+            if(name.size() > EXECUTOR_THREAD_NAME_LEN){
+                name.resize(EXECUTOR_THREAD_NAME_LEN);
+            }
+            pthread_setname_np(pthread_self(), name.c_str());
+            if(!m_cpus.empty()){
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(m_cpus[index % m_cpus.size()], &set);
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+        }
+
+        void WorkerLoop(size_t index){
+            SetupThread(index);
+            Context().executor = this;
+            Context().index = index;
+            uint64_t rng = (index + 1) * 0x9E3779B97F4A7C15ull;
+            for(;;){
+                detail::ExecutorTask* task = FindTask(index, rng);
+                for(int spin = 0; task == nullptr && spin < EXECUTOR_SPIN_ROUNDS; spin++){
+                    std::this_thread::yield();
+                    task = FindTask(index, rng);
+                }
+                if(task == nullptr){
+                    m_sleeping.fetch_add(1);
+                    // 与Wake中的栅栏配对
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    uint64_t epoch = m_epoch.load();
+                    task = FindTask(index, rng);
+                    if(task == nullptr){
+                        if(m_stop.load()){
+                            m_sleeping.fetch_sub(1);
+                            break;
+                        }
+                        std::unique_lock<std::mutex> lk(m_sleep_mutex);
+                        m_sleep_cv.wait(lk, [&]{ return m_epoch.load() != epoch || m_stop.load(); });
+                    }
+                    m_sleeping.fetch_sub(1);
+                    if(task == nullptr){
+                        continue;
+                    }
+                }
+                RunTask(task);
+            }
+            Context() = ThreadContext();
+        }
+
+        ExecutorConfig                          m_config;
+        std::vector<int>                        m_cpus;         // 绑定用的CPU列表，为空表示不绑定
+        std::vector<std::unique_ptr<Worker>>    m_workers;
+        std::atomic<bool>                       m_stop;
+        bool                                    m_joined;       // 工作线程已全部退出(受m_inject_mutex保护)
+
+        std::mutex                              m_inject_mutex;
+        std::deque<detail::ExecutorTask*>       m_injected;     // 外部线程提交的任务
+        std::atomic<size_t>                     m_injected_count;
+
+        std::mutex                              m_sleep_mutex;
+        std::condition_variable                 m_sleep_cv;
+        std::atomic<size_t>                     m_sleeping;     // 正在(或准备)休眠的工作线程数
+        std::atomic<uint64_t>                   m_epoch;        // 有线程休眠时每次提交递增，休眠的线程据此判断是否有新任务
+    };
+
+    namespace detail{
+        inline void Dispatch(Executor* executor, std::unique_ptr<ExecutorTask> task){
+            if(executor != nullptr){
+                executor->PostTask(task.release());
+            }else{
+                task->Run();
+            }
+        }
+    } // namespace detail
+} // namespace dysv
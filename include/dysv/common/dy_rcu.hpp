@@ -0,0 +1,205 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dy_cache_line.hpp"
+
+namespace dysv{
+    /**
+     * @brief 基于epoch的延迟回收(RCU风格)。
+     *        读者用RcuReadGuard标记临界区：进入时把全局epoch登记到本线程的记录上，退出时清零，均无锁;
+     *        写者原子替换指针后Retire旧对象，待所有在替换前进入临界区的读者退出后才真正析构。
+     *        写者之间的互斥由调用方负责。
+     *
+     */
+    class RcuDomain{
+    public:
+        // 全局唯一实例，有意不析构，保证进程退出阶段仍可安全使用
+        static RcuDomain& Instance(){
+            static RcuDomain* domain = new RcuDomain();
+            return *domain;
+        }
+
+        void ReadLock(){
+            ThreadState& state = GetThreadState();
+            if(state.nesting++ == 0){
+                // seq_cst写保证登记对写者可见后才读取受保护的指针
+                state.record->epoch.store(m_global_epoch.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+            }
+        }
+
+        void ReadUnlock(){
+            ThreadState& state = GetThreadState();
+            if(--state.nesting == 0){
+                state.record->epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        // 延迟析构ptr。调用前ptr须已对新的读者不可见
+        template<class T>
+        void Retire(T* ptr){
+            std::vector<Retired> expired;
+            {
+                std::lock_guard<std::mutex> lk(m_retire_mutex);
+                uint64_t epoch = m_global_epoch.fetch_add(1, std::memory_order_seq_cst);
+                m_retired.push_back(Retired{ptr, [](void* p){ delete static_cast<T*>(p); }, epoch});
+                CollectLocked(expired);
+            }
+            Destroy(expired);
+        }
+
+        // 阻塞直到当前已进入临界区的读者全部退出，并回收所有已退休的对象。不可在读临界区内调用
+        void Synchronize(){
+            uint64_t epoch = m_global_epoch.fetch_add(1, std::memory_order_seq_cst);
+            for(Record* rec = m_records.load(std::memory_order_acquire); rec != nullptr; rec = rec->next){
+                for(;;){
+                    uint64_t e = rec->epoch.load(std::memory_order_seq_cst);
+                    if(e == 0 || e > epoch){
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            std::vector<Retired> expired;
+            {
+                std::lock_guard<std::mutex> lk(m_retire_mutex);
+                CollectLocked(expired);
+            }
+            Destroy(expired);
+        }
+
+        // 尚未析构的对象个数
+        size_t GetRetiredCount(){
+            std::lock_guard<std::mutex> lk(m_retire_mutex);
+            return m_retired.size();
+        }
+    private:
+        /**
+         * @brief 每个线程一条记录，epoch为0表示不在临界区。记录只追加不释放，线程退出后供新线程复用。
+         *
+         */
+        struct alignas(DYSV_CACHE_LINE_SIZE) Record{
+            std::atomic<uint64_t>   epoch{0};
+            std::atomic<bool>       in_use{true};
+            Record*                 next = nullptr;
+        };
+
+        struct Retired{
+            void*       ptr;
+            void        (*deleter)(void*);
+            uint64_t    epoch;      // 退休时的全局epoch，登记值不大于它的读者可能仍持有ptr
+        };
+
+        struct ThreadState{
+            Record*     record = nullptr;
+            uint32_t    nesting = 0;
+            ~ThreadState(){
+                if(record != nullptr){
+                    record->epoch.store(0, std::memory_order_release);
+                    record->in_use.store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        RcuDomain() = default;
+
+        ThreadState& GetThreadState(){
+            static thread_local ThreadState t_state;
+            if(t_state.record == nullptr){
+                t_state.record = AcquireRecord();
+            }
+            return t_state;
+        }
+
+        Record* AcquireRecord(){
+            for(Record* rec = m_records.load(std::memory_order_acquire); rec != nullptr; rec = rec->next){
+                bool expected = false;
+                if(!rec->in_use.load(std::memory_order_relaxed)
+                    && rec->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+                    return rec;
+                }
+            }
+            Record* rec = new Record();
+            Record* head = m_records.load(std::memory_order_relaxed);
+            do{
+                rec->next = head;
+            }while(!m_records.compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+            return rec;
+        }
+
+        // 取出已无读者引用的对象。析构放到锁外，对象析构时可以再次Retire
+        void CollectLocked(std::vector<Retired>& expired){
+            uint64_t min_active = UINT64_MAX;
+            for(Record* rec = m_records.load(std::memory_order_acquire); rec != nullptr; rec = rec->next){
+                uint64_t e = rec->epoch.load(std::memory_order_seq_cst);
+                if(e != 0 && e < min_active){
+                    min_active = e;
+                }
+            }
+            size_t kept = 0;
+            for(size_t i = 0; i < m_retired.size(); i++){
+                if(m_retired[i].epoch < min_active){
+                    expired.push_back(m_retired[i]);
+                }else{
+                    m_retired[kept++] = m_retired[i];
+                }
+            }
+            m_retired.resize(kept);
+        }
+
+        static void Destroy(const std::vector<Retired>& expired){
+            for(const Retired& item : expired){
+                item.deleter(item.ptr);
+            }
+        }
+
+        std::atomic<uint64_t>   m_global_epoch{1};
+        std::atomic<Record*>    m_records{nullptr};
+        std::mutex              m_retire_mutex;
+        std::vector<Retired>    m_retired;
+    };
+
+    /**
+     * @brief 读临界区，可嵌套。临界区内不得调用Synchronize。
+     *
+     */
+    class RcuReadGuard{
+    public:
+        RcuReadGuard(){ RcuDomain::Instance().ReadLock(); }
+        ~RcuReadGuard(){ RcuDomain::Instance().ReadUnlock(); }
+        RcuReadGuard(const RcuReadGuard&) = delete;
+        RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+    };
+
+    /**
+     * @brief 受RCU保护的指针。读者在RcuReadGuard内Read，写者(需自行互斥)以写时复制的新对象Update。
+     *
+     * @tparam T 被保护的对象类型
+     */
+    template<class T>
+    class RcuPtr{
+    public:
+        explicit RcuPtr(T* init = nullptr) : m_ptr(init){}
+        // 析构时调用方须保证已没有读者
+        ~RcuPtr(){ delete m_ptr.load(std::memory_order_relaxed); }
+        RcuPtr(const RcuPtr&) = delete;
+        RcuPtr& operator=(const RcuPtr&) = delete;
+
+        // 返回的指针仅在当前读临界区内有效。持有写者互斥时也可直接读取
+        const T* Read() const{
+            return m_ptr.load(std::memory_order_seq_cst);
+        }
+
+        // 发布next，旧对象延迟析构
+        void Update(T* next){
+            T* old = m_ptr.exchange(next, std::memory_order_seq_cst);
+            if(old != nullptr){
+                RcuDomain::Instance().Retire(old);
+            }
+        }
+    private:
+        std::atomic<T*> m_ptr;
+    };
+} // namespace dysv
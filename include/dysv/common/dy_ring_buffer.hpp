@@ -0,0 +1,239 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "dy_cache_line.hpp"
+
+namespace dysv{
+    /**
+     * @brief 有界无锁多生产者单消费者环形队列(Vyukov序号槽算法)。
+     *        槽位在构造时一次性分配，之后入队/出队均不再申请内存；
+     *        生产者通过CAS抢占写位置，再将数据写入槽位并发布序号，消费者按序号取出。
+     *
+     * @tparam T 槽位类型，需可默认构造。
+     */
+    template<class T>
+    class MpscRingBuffer{
+    public:
+        /**
+         * @brief 构造队列。
+         *
+         * @param capacity 容量，向上取整为2的幂。
+         */
+        explicit MpscRingBuffer(size_t capacity)
+                                : m_cells(RoundUpPow2(capacity)), m_mask(m_cells.size() - 1){
+            for(size_t i = 0; i < m_cells.size(); i++){
+                m_cells[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+        MpscRingBuffer(const MpscRingBuffer&) = delete;
+        MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+        /**
+         * @brief 尝试入队。抢占到槽位后调用 fill(T&) 就地写入数据。
+         *
+         * @param fill 写入槽位的回调
+         * @return true 入队成功; false 队列已满
+         */
+        template<class Fill>
+        bool TryPush(Fill&& fill){
+            size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            Cell* cell;
+            for(;;){
+                cell = &m_cells[pos & m_mask];
+                size_t seq = cell->seq.load(std::memory_order_acquire);
+                intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+                if(dif == 0){
+                    if(m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)){
+                        break;
+                    }
+                }else if(dif < 0){
+                    return false;
+                }else{
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+            fill(cell->data);
+            cell->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief 尝试出队(仅限唯一的消费者线程调用)。队首数据通过 consume(T&) 就地处理。
+         *
+         * @param consume 处理槽位的回调
+         * @return true 取出一条; false 队列为空(或队首尚未发布)
+         */
+        template<class Consume>
+        bool TryPop(Consume&& consume){
+            size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            Cell* cell = &m_cells[pos & m_mask];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            if((intptr_t)seq - (intptr_t)(pos + 1) < 0){
+                return false;
+            }
+            consume(cell->data);
+            cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+            m_dequeue_pos.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief 不出队地按序访问已发布而尚未取出的槽位，遇到尚未发布的槽位即停止。
+         *        不与消费者同步，仅供崩溃处理尽力读取。
+         *
+         * @param visit 访问槽位的回调 visit(const T&)
+         */
+        template<class Visit>
+        void Peek(Visit&& visit) const{
+            size_t end = m_enqueue_pos.load(std::memory_order_acquire);
+            for(size_t pos = m_dequeue_pos.load(std::memory_order_acquire); pos != end; pos++){
+                const Cell& cell = m_cells[pos & m_mask];
+                if(cell.seq.load(std::memory_order_acquire) != pos + 1){
+                    break;
+                }
+                visit(cell.data);
+            }
+        }
+
+        // 已被生产者抢占的位置总数(含尚未发布的)
+        size_t EnqueuedCount() const { return m_enqueue_pos.load(std::memory_order_acquire); }
+        // 已被消费者取出的位置总数
+        size_t DequeuedCount() const { return m_dequeue_pos.load(std::memory_order_acquire); }
+        // 当前近似深度
+        size_t Size() const {
+            size_t enq = EnqueuedCount();
+            size_t deq = DequeuedCount();
+            return enq > deq ? enq - deq : 0;
+        }
+        size_t Capacity() const { return m_cells.size(); }
+
+    private:
+        static size_t RoundUpPow2(size_t n){
+            size_t ans = 2;
+            while(ans < n){
+                ans <<= 1;
+            }
+            return ans;
+        }
+
+        struct alignas(DYSV_CACHE_LINE_SIZE) Cell{
+            std::atomic<size_t> seq;
+            T                   data;
+        };
+
+        std::vector<Cell>   m_cells;
+        const size_t        m_mask;
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<size_t> m_enqueue_pos{0};
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<size_t> m_dequeue_pos{0};
+    };
+
+    /**
+     * @brief 有界无锁单生产者单消费者环形队列。
+     *        两端各自缓存对端的位置，只有看似满/空时才读取对端的原子变量，稳定状态下没有缓存行争用。
+     *        生产者可以更换(如线程退出后由新线程接管)，但交接须经过acquire/release同步。
+     *
+     * @tparam T 槽位类型，需可默认构造。
+     */
+    template<class T>
+    class SpscRingBuffer{
+    public:
+        /**
+         * @brief 构造队列。
+         *
+         * @param capacity 容量，向上取整为2的幂。
+         */
+        explicit SpscRingBuffer(size_t capacity)
+                                : m_cells(RoundUpPow2(capacity)), m_mask(m_cells.size() - 1){}
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        /**
+         * @brief 尝试入队(仅限生产者)。调用 fill(T&) 就地写入队尾槽位。
+         *
+         * @return true 入队成功; false 队列已满
+         */
+        template<class Fill>
+        bool TryPush(Fill&& fill){
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            if(pos - m_head_cache > m_mask){
+                m_head_cache = m_head.load(std::memory_order_acquire);
+                if(pos - m_head_cache > m_mask){
+                    return false;
+                }
+            }
+            fill(m_cells[pos & m_mask]);
+            m_tail.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 队首元素(仅限消费者)，为空时返回nullptr。处理完后调用Pop
+        T* Front(){
+            size_t pos = m_head.load(std::memory_order_relaxed);
+            if(pos == m_tail_cache){
+                m_tail_cache = m_tail.load(std::memory_order_acquire);
+                if(pos == m_tail_cache){
+                    return nullptr;
+                }
+            }
+            return &m_cells[pos & m_mask];
+        }
+
+        // 释放队首槽位(仅限消费者，且Front()非空)
+        void Pop(){
+            m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // 尝试出队(仅限消费者)，队首数据通过 consume(T&) 就地处理
+        template<class Consume>
+        bool TryPop(Consume&& consume){
+            T* front = Front();
+            if(front == nullptr){
+                return false;
+            }
+            consume(*front);
+            Pop();
+            return true;
+        }
+
+        // 不出队地按序访问尚未取出的槽位。不与消费者同步，仅供崩溃处理尽力读取
+        template<class Visit>
+        void Peek(Visit&& visit) const{
+            size_t end = m_tail.load(std::memory_order_acquire);
+            for(size_t pos = m_head.load(std::memory_order_acquire); pos != end; pos++){
+                visit(m_cells[pos & m_mask]);
+            }
+        }
+
+        // 已入队的总数
+        size_t EnqueuedCount() const { return m_tail.load(std::memory_order_acquire); }
+        // 已出队的总数
+        size_t DequeuedCount() const { return m_head.load(std::memory_order_acquire); }
+        // 当前近似深度
+        size_t Size() const {
+            size_t deq = DequeuedCount();
+            size_t enq = EnqueuedCount();
+            return enq > deq ? enq - deq : 0;
+        }
+        size_t Capacity() const { return m_cells.size(); }
+
+    private:
+        static size_t RoundUpPow2(size_t n){
+            size_t ans = 2;
+            while(ans < n){
+                ans <<= 1;
+            }
+            return ans;
+        }
+
+        std::vector<T>      m_cells;
+        const size_t        m_mask;
+        // 生产者独占的缓存行
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<size_t> m_tail{0};
+        size_t              m_head_cache = 0;
+        // 消费者独占的缓存行
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<size_t> m_head{0};
+        size_t              m_tail_cache = 0;
+    };
+} // namespace dysv
@@ -0,0 +1,485 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+
+/**
+ * @brief 分层时间轮定时器。
+ * @feature 4层、每层256个槽，tick默认1ms(可覆盖约49天，更远的定时器先放在最高层，逐层下放时重新计算);
+ *          添加/取消为O(1)：定时器节点链在槽的侵入式双向链表上，取消时直接摘下;
+ *          节点(含回调)取自按块分配的节点池，释放后回到空闲链表，大量定时器的增删不触发逐个的堆分配;
+ *          第0层用位图标记非空槽，推进时跳过空槽，可据此给出下一次到期的时间;
+ *          两种驱动方式：Start()启动一个驱动线程; 或由事件循环调用NextTimeoutMs()作为等待超时、醒来后调用Advance()。
+ * @note 回调在驱动线程(或调用Advance的线程)中执行，执行时不持有时间轮的锁，回调中可以添加/取消定时器;
+ *       Cancel在其他线程调用且回调正在执行时，等待回调返回，调用者不要持有回调中会获取的锁。
+ * @example
+ *      dysv::TimingWheel& wheel = dysv::TimingWheel::Global();     // 带驱动线程的全局时间轮
+ *      dysv::TimerId id = wheel.AddPeriodic(100, []{ ... });       // 每100ms一次
+ *      wheel.Add(5000, []{ ... });                                 // 5s后一次
+ *      wheel.Cancel(id);
+ */
+
+namespace dysv{
+#define TIMER_WHEEL_LEVELS      4       // 层数
+#define TIMER_WHEEL_BITS        8       // 每层槽数为2^TIMER_WHEEL_BITS
+#define TIMER_DEFAULT_TICK_MS   1       // 默认tick长度
+#define TIMER_POOL_CHUNK        1024    // 节点池每次分配的节点数
+#define TIMER_THREAD_NAME_LEN   15      // 线程名的最大长度(不含'\0')
+
+    // 定时器标识，0表示无效。低32位为节点下标+1，高32位为节点的分配序号，节点复用后旧标识自动失效
+    using TimerId = uint64_t;
+
+    class TimingWheel
+    {
+    public:
+        using Callback = std::function<void()>;
+
+        explicit TimingWheel(uint32_t tick_ms = TIMER_DEFAULT_TICK_MS)
+                            : m_tick_ms(tick_ms == 0 ? 1 : tick_ms), m_start_ms(NowMs()), m_now(0), m_size(0),
+                              m_free(nullptr), m_stop(false), m_driver_deadline(UINT64_MAX){
+            for(auto& level : m_slots){
+                for(auto& head : level){
+                    head = nullptr;
+                }
+            }
+            for(auto& word : m_bitmap){
+                word = 0;
+            }
+        }
+
+        ~TimingWheel(){
+            Stop();
+        }
+
+        TimingWheel(const TimingWheel&) = delete;
+        TimingWheel& operator=(const TimingWheel&) = delete;
+
+        // 带驱动线程的全局时间轮，供日志刷新/轮转等使用。有意不析构，静态对象析构阶段仍可安全地取消定时器
+        static TimingWheel& Global(){
+            static TimingWheel* wheel = []{
+                TimingWheel* w = new TimingWheel();
+                w->Start("dysv-timer");
+                return w;
+            }();
+            return *wheel;
+        }
+
+        // 单调时钟的毫秒数
+        static int64_t NowMs(){
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // delay_ms后执行一次
+        TimerId Add(uint32_t delay_ms, Callback cb){
+            return Schedule(delay_ms, 0, std::move(cb));
+        }
+
+        // 每隔interval_ms执行一次(首次在interval_ms后)，直到Cancel
+        TimerId AddPeriodic(uint32_t interval_ms, Callback cb){
+            return Schedule(interval_ms, interval_ms == 0 ? 1 : interval_ms, std::move(cb));
+        }
+
+        /**
+         * @brief 取消定时器。返回后回调不会再开始执行; 回调正在其他线程执行时等待其返回。
+         *
+         * @return 定时器尚存在(未执行完的一次性定时器或周期定时器)时返回true
+         */
+        bool Cancel(TimerId id){
+            std::unique_lock<std::mutex> lk(m_mutex);
+            Node* node = Resolve(id);
+            if(node == nullptr){
+                return false;
+            }
+            Callback cb;
+            switch(node->state){
+            case NODE_PENDING:
+                Unlink(node);
+                m_size--;
+                cb = Release(node);
+                lk.unlock();    // 回调持有的资源在锁外析构
+                return true;
+            case NODE_FIRED:
+                node->cancelled = true;
+                return true;
+            case NODE_RUNNING:
+                node->cancelled = true;
+                if(m_running_thread != std::this_thread::get_id()){
+                    uint32_t seq = node->seq;
+                    m_done_cv.wait(lk, [node, seq]{ return node->seq != seq || node->state != NODE_RUNNING; });
+                }
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        /**
+         * @brief 推进到now_ms并在当前线程执行到期的回调。同一时间只应有一个线程调用(驱动线程或事件循环)。
+         *
+         * @return 执行的回调数
+         */
+        size_t Advance(int64_t now_ms){
+            std::vector<Node*> expired;
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                uint64_t target = ToTick(now_ms);
+                CollectExpiredLocked(target, expired);
+                if(expired.empty()){
+                    return 0;
+                }
+                m_running_thread = std::this_thread::get_id();
+            }
+            size_t count = 0;
+            for(Node* node : expired){
+                std::unique_lock<std::mutex> lk(m_mutex);
+                if(node->cancelled){
+                    Callback cb = Release(node);
+                    lk.unlock();
+                    continue;
+                }
+                node->state = NODE_RUNNING;
+                lk.unlock();
+                node->cb();
+                count++;
+                lk.lock();
+                Callback cb;
+                if(node->interval > 0 && !node->cancelled){
+                    // 周期定时器按原定节拍续期，落后时从当前tick算起，不补执行
+                    node->expire += node->interval;
+                    if(node->expire < m_now){
+                        node->expire = m_now;
+                    }
+                    node->state = NODE_PENDING;
+                    Link(node);
+                    m_size++;
+                }else{
+                    cb = Release(node);
+                }
+                m_done_cv.notify_all();
+                lk.unlock();
+            }
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                m_running_thread = std::thread::id();
+            }
+            return count;
+        }
+
+        /**
+         * @brief 距下一次需要调用Advance的毫秒数，供事件循环作为等待超时; 没有定时器时返回-1。
+         *        下一个到期的定时器不在第0层时返回到下次下放(第0层转完一圈)的时间。
+         *
+         */
+        int64_t NextTimeoutMs(int64_t now_ms){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if(m_size == 0){
+                return -1;
+            }
+            uint64_t next = NextTickLocked();
+            uint64_t current = ToTick(now_ms);
+            if(next <= current){
+                return 0;
+            }
+            return (int64_t)((next - current) * m_tick_ms) - (now_ms - m_start_ms) % m_tick_ms;
+        }
+
+        // 尚未到期的定时器个数
+        size_t Size(){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            return m_size;
+        }
+
+        // 启动驱动线程。重复调用无效
+        void Start(const std::string& name = "dysv-timer"){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            if(m_driver.joinable()){
+                return;
+            }
+            m_stop = false;
+            m_driver = std::thread([this, name]{
+                std::string thread_name = name.substr(0, TIMER_THREAD_NAME_LEN);
+                pthread_setname_np(pthread_self(), thread_name.c_str());
+                DriverLoop();
+            });
+        }
+
+        // 停止驱动线程，尚未到期的定时器保留(可再Start)
+        void Stop(){
+            std::thread driver;
+            {
+                std::lock_guard<std::mutex> lk(m_mutex);
+                m_stop = true;
+                driver.swap(m_driver);
+            }
+            m_driver_cv.notify_all();
+            if(driver.joinable()){
+                driver.join();
+            }
+        }
+    private:
+        enum NodeState{
+            NODE_FREE = 0,
+            NODE_PENDING,       // 在某个槽中等待到期
+            NODE_FIRED,         // 已到期取出，尚未开始执行
+            NODE_RUNNING,       // 回调执行中
+        };
+
+        struct Node{
+            Node*       prev = nullptr;
+            Node*       next = nullptr;     // 空闲时串成空闲链表
+            uint64_t    expire = 0;         // 到期的tick
+            uint64_t    interval = 0;       // 周期(tick)，0表示一次性
+            uint32_t    index = 0;          // 在节点池中的下标
+            uint32_t    seq = 0;            // 每次分配加一
+            uint8_t     level = 0;
+            uint8_t     slot = 0;
+            uint8_t     state = NODE_FREE;
+            bool        cancelled = false;
+            Callback    cb;
+        };
+
+        static constexpr uint64_t SLOTS = 1u << TIMER_WHEEL_BITS;
+        static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+        // 最高层能表示的最远距离
+        static constexpr uint64_t MAX_DELTA = (1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+
+        uint64_t ToTick(int64_t now_ms) const{
+            return now_ms <= m_start_ms ? 0 : (uint64_t)(now_ms - m_start_ms) / m_tick_ms;
+        }
+
+        TimerId Schedule(uint32_t delay_ms, uint32_t interval_ms, Callback cb){
+            std::unique_lock<std::mutex> lk(m_mutex);
+            Node* node = Allocate();
+            // 向上取整，保证不早于delay_ms执行
+            uint64_t delay = (delay_ms + m_tick_ms - 1) / m_tick_ms;
+            uint64_t base = std::max(m_now, ToTick(NowMs()));
+            node->expire = base + delay;
+            node->interval = (interval_ms + m_tick_ms - 1) / m_tick_ms;
+            node->cb = std::move(cb);
+            node->state = NODE_PENDING;
+            Link(node);
+            m_size++;
+            TimerId id = ((uint64_t)node->seq << 32) | (node->index + 1);
+            bool wake = m_driver.joinable() && node->expire < m_driver_deadline;
+            lk.unlock();
+            if(wake){
+                m_driver_cv.notify_one();
+            }
+            return id;
+        }
+
+        Node* Resolve(TimerId id){
+            uint32_t index = (uint32_t)id;
+            if(index == 0 || index > m_chunks.size() * TIMER_POOL_CHUNK){
+                return nullptr;
+            }
+            index--;
+            Node* node = &m_chunks[index / TIMER_POOL_CHUNK][index % TIMER_POOL_CHUNK];
+            if(node->seq != (uint32_t)(id >> 32) || node->state == NODE_FREE){
+                return nullptr;
+            }
+            return node;
+        }
+
+        Node* Allocate(){
+            if(m_free == nullptr){
+                uint32_t first = (uint32_t)(m_chunks.size() * TIMER_POOL_CHUNK);
+                m_chunks.emplace_back(new Node[TIMER_POOL_CHUNK]);
+                Node* chunk = m_chunks.back().get();
+                for(uint32_t i = TIMER_POOL_CHUNK; i-- > 0; ){
+                    chunk[i].index = first + i;
+                    chunk[i].next = m_free;
+                    m_free = &chunk[i];
+                }
+            }
+            Node* node = m_free;
+            m_free = node->next;
+            node->prev = nullptr;
+            node->next = nullptr;
+            node->seq++;
+            node->cancelled = false;
+            return node;
+        }
+
+        // 归还节点，返回其回调由调用者在锁外析构
+        Callback Release(Node* node){
+            Callback cb = std::move(node->cb);
+            node->cb = nullptr;
+            node->state = NODE_FREE;
+            node->seq++;
+            node->prev = nullptr;
+            node->next = m_free;
+            m_free = node;
+            return cb;
+        }
+
+        void Link(Node* node){
+            uint64_t expire = node->expire < m_now ? m_now : node->expire;
+            uint64_t delta = expire - m_now;
+            if(delta > MAX_DELTA){
+                expire = m_now + MAX_DELTA;
+                delta = MAX_DELTA;
+            }
+            uint8_t level = 0;
+            while(level + 1 < TIMER_WHEEL_LEVELS && delta >= (1ull << (TIMER_WHEEL_BITS * (level + 1)))){
+                level++;
+            }
+            uint8_t slot = (uint8_t)((expire >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK);
+            node->level = level;
+            node->slot = slot;
+            Node*& head = m_slots[level][slot];
+            node->prev = nullptr;
+            node->next = head;
+            if(head != nullptr){
+                head->prev = node;
+            }
+            head = node;
+            if(level == 0){
+                m_bitmap[slot / 64] |= 1ull << (slot % 64);
+            }
+        }
+
+        void Unlink(Node* node){
+            Node*& head = m_slots[node->level][node->slot];
+            if(node->prev != nullptr){
+                node->prev->next = node->next;
+            }else{
+                head = node->next;
+            }
+            if(node->next != nullptr){
+                node->next->prev = node->prev;
+            }
+            node->prev = nullptr;
+            node->next = nullptr;
+            if(node->level == 0 && head == nullptr){
+                m_bitmap[node->slot / 64] &= ~(1ull << (node->slot % 64));
+            }
+        }
+
+        // 把level层slot槽中的定时器按剩余时间重新放入较低的层
+        void CascadeLocked(int level, uint64_t slot){
+            Node* node = m_slots[level][slot];
+            m_slots[level][slot] = nullptr;
+            while(node != nullptr){
+                Node* next = node->next;
+                Link(node);
+                node = next;
+            }
+        }
+
+        // 第0层从当前槽起(到本圈结束)第一个非空槽，没有时返回SLOTS
+        uint64_t FindSlotLocked(uint64_t from) const{
+            for(uint64_t word = from / 64; word < SLOTS / 64; word++){
+                uint64_t bits = m_bitmap[word];
+                if(word == from / 64){
+                    bits &= ~0ull << (from % 64);
+                }
+                if(bits != 0){
+                    return word * 64 + __builtin_ctzll(bits);
+                }
+            }
+            return SLOTS;
+        }
+
+        uint64_t NextTickLocked() const{
+            uint64_t slot = FindSlotLocked(m_now & SLOT_MASK);
+            return (m_now & ~SLOT_MASK) + slot;   // slot为SLOTS时即下次下放的tick
+        }
+
+        // 推进到target(含)，到期的节点标记为FIRED后放入expired
+        void CollectExpiredLocked(uint64_t target, std::vector<Node*>& expired){
+            while(m_now <= target){
+                if(m_size == 0){
+                    m_now = target + 1;
+                    break;
+                }
+                uint64_t index = m_now & SLOT_MASK;
+                if(index == 0){
+                    for(int level = 1; level < TIMER_WHEEL_LEVELS; level++){
+                        uint64_t slot = (m_now >> (TIMER_WHEEL_BITS * level)) & SLOT_MASK;
+                        CascadeLocked(level, slot);
+                        if(slot != 0){
+                            break;
+                        }
+                    }
+                }
+                // 跳过空槽，最多到本圈结束或target
+                uint64_t slot = FindSlotLocked(index);
+                uint64_t round_end = (m_now & ~SLOT_MASK) + SLOTS;
+                uint64_t next = slot == SLOTS ? round_end : (m_now & ~SLOT_MASK) + slot;
+                if(next > target){
+                    m_now = std::min(round_end, target + 1);
+                    continue;
+                }
+                if(next != m_now){
+                    m_now = next;
+                    continue;   // 可能恰好到了下一圈，需先下放
+                }
+                Node* node = m_slots[0][slot];
+                m_slots[0][slot] = nullptr;
+                m_bitmap[slot / 64] &= ~(1ull << (slot % 64));
+                while(node != nullptr){
+                    Node* next_node = node->next;
+                    node->prev = nullptr;
+                    node->next = nullptr;
+                    node->state = NODE_FIRED;
+                    m_size--;
+                    expired.push_back(node);
+                    node = next_node;
+                }
+                m_now++;
+            }
+        }
+
+        void DriverLoop(){
+            std::unique_lock<std::mutex> lk(m_mutex);
+            while(!m_stop){
+                if(m_size == 0){
+                    m_driver_deadline = UINT64_MAX;
+                    m_driver_cv.wait(lk, [this]{ return m_stop || m_size > 0; });
+                    continue;
+                }
+                uint64_t next = NextTickLocked();
+                uint64_t current = ToTick(NowMs());
+                if(next > current){
+                    m_driver_deadline = next;
+                    auto deadline = std::chrono::steady_clock::time_point(
+                                        std::chrono::milliseconds(m_start_ms + (int64_t)(next * m_tick_ms)));
+                    m_driver_cv.wait_until(lk, deadline);
+                    continue;   // 醒来后重新计算：可能有更早的定时器加入
+                }
+                m_driver_deadline = UINT64_MAX;
+                lk.unlock();
+                Advance(NowMs());
+                lk.lock();
+            }
+        }
+
+        uint32_t                                m_tick_ms;
+        int64_t                                 m_start_ms;
+        uint64_t                                m_now;          // 下一个待处理的tick
+        size_t                                  m_size;
+        Node*                                   m_slots[TIMER_WHEEL_LEVELS][SLOTS];
+        uint64_t                                m_bitmap[SLOTS / 64];   // 第0层的非空槽
+        std::vector<std::unique_ptr<Node[]>>    m_chunks;
+        Node*                                   m_free;
+        std::mutex                              m_mutex;
+        std::condition_variable                 m_done_cv;      // 回调执行完毕，唤醒等待中的Cancel
+        std::thread::id                         m_running_thread;
+
+        std::thread                             m_driver;
+        std::condition_variable                 m_driver_cv;
+        bool                                    m_stop;
+        uint64_t                                m_driver_deadline;  // 驱动线程等待到的tick，更早的定时器加入时唤醒
+    };
+} // namespace dysv
@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "dy_cache_line.hpp"
+
+namespace dysv{
+    /**
+     * @brief 无界工作窃取双端队列(Chase-Lev，按Lê等人的C11内存模型版本)。
+     *        所有者线程在底部Push/Pop(后进先出，缓存友好)，其他线程在顶部Steal(先进先出)，
+     *        只有队列仅剩一个元素时所有者与窃取者才会竞争同一个CAS。
+     *        数组写满时所有者换成两倍大小的新数组；旧数组可能仍被窃取者读取，保留到析构时释放。
+     *
+     * @tparam T 元素类型，需可平凡拷贝(通常为任务指针)。
+     */
+    template<class T>
+    class WorkStealingDeque{
+    public:
+        /**
+         * @brief 构造队列。
+         *
+         * @param capacity 初始容量，向上取整为2的幂。
+         */
+        explicit WorkStealingDeque(size_t capacity = 256) : m_top(0), m_bottom(0){
+            size_t cap = 1;
+            while(cap < capacity){
+                cap <<= 1;
+            }
+            m_arrays.emplace_back(new Array(cap));
+            m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+        }
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        // 仅所有者线程调用
+        void Push(T item){
+            int64_t b = m_bottom.load(std::memory_order_relaxed);
+            int64_t t = m_top.load(std::memory_order_acquire);
+            Array* a = m_array.load(std::memory_order_relaxed);
+            if(b - t > (int64_t)a->mask){
+                a = Grow(a, t, b);
+            }
+            a->Put(b, item);
+            // 发布元素：窃取者以acquire读到新的bottom后必能读到元素及其指向的内容
+            m_bottom.store(b + 1, std::memory_order_release);
+        }
+
+        // 仅所有者线程调用。队列为空时返回false
+        bool Pop(T& item){
+            int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+            Array* a = m_array.load(std::memory_order_relaxed);
+            // 先公开"要取b"，再读top：与Steal中先读top再读bottom构成对称的全序
+            m_bottom.store(b, std::memory_order_seq_cst);
+            int64_t t = m_top.load(std::memory_order_seq_cst);
+            if(t > b){
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            item = a->Get(b);
+            if(t == b){
+                // 最后一个元素，与窃取者竞争
+                bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        // 任意线程调用。队列为空或与他人竞争失败时返回false
+        bool Steal(T& item){
+            int64_t t = m_top.load(std::memory_order_seq_cst);
+            int64_t b = m_bottom.load(std::memory_order_seq_cst);
+            if(t >= b){
+                return false;
+            }
+            Array* a = m_array.load(std::memory_order_acquire);
+            item = a->Get(t);
+            return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        }
+
+        // 近似的元素个数
+        size_t Size() const{
+            int64_t b = m_bottom.load(std::memory_order_relaxed);
+            int64_t t = m_top.load(std::memory_order_relaxed);
+            return b > t ? (size_t)(b - t) : 0;
+        }
+
+        bool Empty() const{
+            return Size() == 0;
+        }
+    private:
+        struct Array{
+            explicit Array(size_t cap) : mask(cap - 1), slots(new std::atomic<T>[cap]){}
+
+            T Get(int64_t i) const{
+                return slots[i & mask].load(std::memory_order_relaxed);
+            }
+            void Put(int64_t i, T item){
+                slots[i & mask].store(item, std::memory_order_relaxed);
+            }
+
+            size_t                              mask;
+            std::unique_ptr<std::atomic<T>[]>   slots;
+        };
+
+        Array* Grow(Array* old, int64_t t, int64_t b){
+            m_arrays.emplace_back(new Array((old->mask + 1) * 2));
+            Array* a = m_arrays.back().get();
+            for(int64_t i = t; i < b; i++){
+                a->Put(i, old->Get(i));
+            }
+            m_array.store(a, std::memory_order_release);
+            return a;
+        }
+
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<int64_t>  m_top;
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<int64_t>  m_bottom;
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<Array*>   m_array;
+        std::vector<std::unique_ptr<Array>>                 m_arrays;   // 当前及历次扩容前的数组(仅所有者修改)
+    };
+} // namespace dysv
@@ -0,0 +1,678 @@
+#include "dysv/dy_async_log.hpp"
+#include "dysv/dy_crash_handler.hpp"
+
+namespace dysv{
+    #define ASYNC_BACKEND_BATCH_SIZE    256     // 后台线程每轮最多处理的记录数
+    #define SHARD_INFLIGHT_IDLE         0       // 分片没有正在入队的记录
+    #define SHARD_INFLIGHT_PENDING      1       // 分片已登记入队，尚未取得时间戳
+
+    // 当前线程作为后台线程服务的日志器。后台线程自身打印的FATAL不能等待自己落地
+    static thread_local const Logger* t_backend_logger = nullptr;
+
+    /*********************class Backpressure**************************************/
+    Backpressure::Backpressure(const BackpressureConfig& config){
+        Set(config);
+    }
+
+    void Backpressure::Set(const BackpressureConfig& config){
+        m_keep_level.store(config.keep_level, std::memory_order_relaxed);
+        m_high_watermark.store(config.high_watermark, std::memory_order_relaxed);
+        m_sample_rate.store(config.sample_rate > 0 ? config.sample_rate : 1, std::memory_order_relaxed);
+        m_policy.store(config.policy, std::memory_order_relaxed);
+    }
+
+    BackpressureConfig Backpressure::Get() const{
+        BackpressureConfig config;
+        config.policy = m_policy.load(std::memory_order_relaxed);
+        config.keep_level = m_keep_level.load(std::memory_order_relaxed);
+        config.high_watermark = m_high_watermark.load(std::memory_order_relaxed);
+        config.sample_rate = m_sample_rate.load(std::memory_order_relaxed);
+        return config;
+    }
+
+    bool Backpressure::DropBeforePush(level::LevelEnum lv, size_t depth, size_t capacity) const{
+        if(!UsesWatermark() || lv >= m_keep_level.load(std::memory_order_relaxed)
+            || depth * 100 < capacity * m_high_watermark.load(std::memory_order_relaxed)){
+            return false;
+        }
+        if(m_policy.load(std::memory_order_relaxed) == BACKPRESSURE_DROP_LOW_PRIORITY){
+            return true;
+        }
+        // 线程内计数，生产者之间不共享状态
+        static thread_local uint32_t t_sample_seq = 0;
+        return (t_sample_seq++ % m_sample_rate.load(std::memory_order_relaxed)) != 0;
+    }
+
+    bool Backpressure::DropWhenFull(level::LevelEnum lv) const{
+        switch(m_policy.load(std::memory_order_relaxed)){
+            case BACKPRESSURE_DROP_NEWEST:
+                return true;
+            case BACKPRESSURE_SAMPLE:
+                return lv < m_keep_level.load(std::memory_order_relaxed);
+            default:
+                return false;
+        }
+    }
+
+    const char* Backpressure::PolicyName() const{
+        return PolicyName(m_policy.load(std::memory_order_relaxed));
+    }
+
+    const char* Backpressure::PolicyName(BackpressurePolicy policy){
+        switch(policy){
+            case BACKPRESSURE_BLOCK: return "block";
+            case BACKPRESSURE_DROP_NEWEST: return "drop newest";
+            case BACKPRESSURE_DROP_LOW_PRIORITY: return "drop low priority";
+            case BACKPRESSURE_SAMPLE: return "sample";
+            default: return "unknown";
+        }
+    }
+
+    /*********************class AsyncLogger**************************************/
+    AsyncLogger::AsyncLogger(const std::string &name, size_t queue_size)
+                            : Logger(name), m_queue(queue_size){
+        Start();
+    }
+
+    AsyncLogger::AsyncLogger(const std::string &name, level::LevelEnum lv, const std::string& pt, size_t queue_size)
+                            : Logger(name, lv, pt), m_queue(queue_size){
+        Start();
+    }
+
+    AsyncLogger::~AsyncLogger(){
+        Stop();
+        // 队列在本函数返回后析构，此前注销
+        CrashHandler::Unregister(this);
+    }
+
+    void AsyncLogger::Start(){
+        m_stop = false;
+        m_backend_sleeping = false;
+        m_flush_target = 0;
+        m_flushed = 0;
+        m_pushing = 0;
+        m_running = true;
+        m_backend = std::thread(&AsyncLogger::BackendLoop, this);
+    }
+
+    void AsyncLogger::Stop(){
+        if(!m_running.exchange(false)){
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_backend_cv.notify_one();
+        if(m_backend.joinable()){
+            m_backend.join();
+        }
+        // 与Stop并发的生产者可能在后台线程退出后才完成入队：等已登记的生产者全部离开，再兜底落地。
+        // 此后登记的生产者必然看到m_running为false，改为同步落地
+        while(m_pushing.load(std::memory_order_acquire) != 0){
+            std::this_thread::yield();
+        }
+        while(m_queue.TryPop([this](Record& rec){
+            SinkImpl(rec.has_info ? &rec.info : nullptr, rec.lv, rec.content);
+        })){}
+        ReportDropped(m_backpressure.PolicyName());
+        Logger::Flush();
+    }
+
+    void AsyncLogger::LogImpl(const LogAdditionInfo* other_info,
+                                level::LevelEnum lv,
+                                std::string_view org_str){
+        // 先登记再检查m_running(与Stop中的exchange构成Dekker式配对)：Stop要么等到本次入队结束，要么本次看到已停止
+        m_pushing.fetch_add(1, std::memory_order_seq_cst);
+        if(!m_running.load(std::memory_order_seq_cst)){
+            m_pushing.fetch_sub(1, std::memory_order_release);
+            Logger::LogImpl(other_info, lv, org_str);
+            return;
+        }
+
+        if(m_backpressure.UsesWatermark() && m_backpressure.DropBeforePush(lv, m_queue.Size(), m_queue.Capacity())){
+            m_pushing.fetch_sub(1, std::memory_order_release);
+            CountDropped();
+            return;
+        }
+
+        auto fill = [&](Record& rec){
+            rec.has_info = (other_info != nullptr);
+            if(rec.has_info){
+                rec.info = *other_info;
+            }
+            rec.lv = lv;
+            rec.content.assign(org_str);
+        };
+        while(!m_queue.TryPush(fill)){
+            // 队列已满：按背压策略丢弃，或唤醒后台线程并让出CPU直到腾出槽位
+            if(!m_running.load(std::memory_order_acquire)){
+                m_pushing.fetch_sub(1, std::memory_order_release);
+                Logger::LogImpl(other_info, lv, org_str);
+                return;
+            }
+            if(m_backpressure.DropWhenFull(lv)){
+                m_pushing.fetch_sub(1, std::memory_order_release);
+                CountDropped();
+                return;
+            }
+            WakeBackend();
+            std::this_thread::yield();
+        }
+        m_pushing.fetch_sub(1, std::memory_order_release);
+        CountAccepted();
+        if(m_backend_sleeping.load()){
+            WakeBackend();
+        }
+        // FATAL在返回前落地
+        if(lv == level::FATAL && CrashHandler::FlushOnFatal() && t_backend_logger != this){
+            Flush();
+        }
+    }
+
+    void AsyncLogger::Flush(){
+        if(!m_running.load(std::memory_order_acquire)){
+            Logger::Flush();
+            return;
+        }
+        std::unique_lock<std::mutex> lk(m_mutex);
+        size_t target = m_queue.EnqueuedCount();
+        if(target > m_flush_target){
+            m_flush_target = target;
+        }
+        m_backend_cv.notify_one();
+        m_flush_cv.wait(lk, [&]{ return m_flushed >= target || m_stop; });
+    }
+
+    size_t AsyncLogger::GetQueueDepth() const{
+        return m_queue.Size();
+    }
+
+    void AsyncLogger::EmergencyDrain(){
+        Logger::EmergencyDrain();
+        m_queue.Peek([this](const Record& rec){
+            EmergencySink(rec.has_info ? &rec.info : nullptr, rec.lv, rec.content);
+        });
+    }
+
+    void AsyncLogger::SetBackpressure(const BackpressureConfig& config){
+        m_backpressure.Set(config);
+    }
+
+    BackpressureConfig AsyncLogger::GetBackpressure() const{
+        return m_backpressure.Get();
+    }
+
+    void AsyncLogger::WakeBackend(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_backend_cv.notify_one();
+    }
+
+    void AsyncLogger::BackendLoop(){
+        t_backend_logger = this;
+        auto consume = [this](Record& rec){
+            SinkImpl(rec.has_info ? &rec.info : nullptr, rec.lv, rec.content);
+        };
+        bool dirty = false;     // 自上次刷新后是否写过sink
+        for(;;){
+            if(CrashHandler::IsDraining()){
+                // 崩溃处理正在排空队列，停止消费以免重复写出，等待进程终止
+                std::this_thread::sleep_for(std::chrono::milliseconds(ASYNC_BACKEND_IDLE_WAIT_MS));
+                continue;
+            }
+            size_t n = 0;
+            while(n < ASYNC_BACKEND_BATCH_SIZE && !CrashHandler::IsDraining() && m_queue.TryPop(consume)){
+                n++;
+            }
+            if(n > 0){
+                dirty = true;
+            }
+            // 队列已排空，背压解除后报告期间丢弃的条数
+            if(n < ASYNC_BACKEND_BATCH_SIZE && ReportDropped(m_backpressure.PolicyName())){
+                dirty = true;
+            }
+
+            std::unique_lock<std::mutex> lk(m_mutex);
+            size_t done = m_queue.DequeuedCount();
+            if(m_flush_target > m_flushed && done >= m_flush_target){
+                Logger::Flush();
+                dirty = false;
+                m_flushed = done;
+                m_flush_cv.notify_all();
+            }
+            if(n == ASYNC_BACKEND_BATCH_SIZE){
+                continue;
+            }
+            if(m_queue.EnqueuedCount() == done){
+                if(m_stop){
+                    break;
+                }
+                // 空闲：顺带把sink的缓冲落盘，再休眠等待新记录
+                if(dirty){
+                    Logger::Flush();
+                    dirty = false;
+                }
+                m_backend_sleeping = true;
+                if(m_queue.EnqueuedCount() == done){
+                    m_backend_cv.wait_for(lk, std::chrono::milliseconds(ASYNC_BACKEND_IDLE_WAIT_MS));
+                }
+                m_backend_sleeping = false;
+            }else if(n == 0){
+                // 有生产者已抢占槽位但尚未发布
+                lk.unlock();
+                std::this_thread::yield();
+            }
+        }
+
+        Logger::Flush();
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_flushed = m_queue.DequeuedCount();
+        m_flush_cv.notify_all();
+    }
+
+    /*********************class ShardedAsyncLogger**************************************/
+    static std::atomic<uint64_t> s_next_sharded_logger_id{1};
+
+    /**
+     * @brief 线程内缓存的分片。线程退出时归还独占分片；日志器已析构的条目在下次认领时清理。
+     *
+     */
+    struct ThreadShardRef{
+        uint64_t                    logger_id;
+        void*                       shard;
+        std::weak_ptr<void>         holder;     // 判断分片(及其日志器)是否仍存在
+        std::atomic<bool>*          owned;      // 共用分片为nullptr
+    };
+
+    struct ThreadShardCache{
+        std::vector<ThreadShardRef> refs;
+        ~ThreadShardCache(){
+            for(const auto& ref : refs){
+                std::shared_ptr<void> alive = ref.holder.lock();
+                if(alive && ref.owned != nullptr){
+                    ref.owned->store(false, std::memory_order_release);
+                }
+            }
+        }
+    };
+
+    static thread_local ThreadShardCache t_shard_cache;
+
+    // 归并键与水位线用单调时钟，系统时间回拨不会让分片停滞或破坏分片内的有序性; 墙上时间只用于显示
+    static uint64_t MonotonicNs(){
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    ShardedAsyncLogger::ShardedAsyncLogger(const std::string &name, size_t shard_queue_size, size_t max_shards)
+                                        : Logger(name), m_id(s_next_sharded_logger_id++),
+                                          m_shard_queue_size(shard_queue_size), m_max_shards(max_shards),
+                                          m_shards(max_shards + 1){
+        Start();
+    }
+
+    ShardedAsyncLogger::ShardedAsyncLogger(const std::string &name, level::LevelEnum lv, const std::string& pt,
+                                            size_t shard_queue_size, size_t max_shards)
+                                        : Logger(name, lv, pt), m_id(s_next_sharded_logger_id++),
+                                          m_shard_queue_size(shard_queue_size), m_max_shards(max_shards),
+                                          m_shards(max_shards + 1){
+        Start();
+    }
+
+    ShardedAsyncLogger::~ShardedAsyncLogger(){
+        Stop();
+        // 分片在本函数返回后析构，此前注销
+        CrashHandler::Unregister(this);
+    }
+
+    void ShardedAsyncLogger::Start(){
+        for(auto& shard : m_shards){
+            shard.store(nullptr, std::memory_order_relaxed);
+        }
+        m_shard_count = 0;
+        m_shared_index = SIZE_MAX;
+        m_heap.reserve(m_shards.size());
+        m_flush_targets.assign(m_shards.size(), 0);
+        m_flush_gen = 0;
+        m_flushed_gen = 0;
+        m_stop = false;
+        m_backend_sleeping = false;
+        m_running = true;
+        m_backend = std::thread(&ShardedAsyncLogger::BackendLoop, this);
+    }
+
+    void ShardedAsyncLogger::Stop(){
+        if(!m_running.exchange(false)){
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_stop = true;
+        }
+        m_backend_cv.notify_one();
+        if(m_backend.joinable()){
+            m_backend.join();
+        }
+        // 与Stop并发的生产者可能在后台线程退出后才完成入队：等各分片上已登记的入队结束，再兜底落地。
+        // 持m_claim_mutex读分片数：此后才认领分片的生产者必然看到m_running为false
+        size_t count;
+        {
+            std::lock_guard<std::mutex> lk(m_claim_mutex);
+            count = m_shard_count.load(std::memory_order_acquire);
+        }
+        for(size_t i = 0; i < count; i++){
+            Shard* shard = m_shards[i].load(std::memory_order_acquire);
+            while(shard->inflight.load(std::memory_order_seq_cst) != SHARD_INFLIGHT_IDLE){
+                std::this_thread::yield();
+            }
+        }
+        while(MergeRound(ASYNC_BACKEND_BATCH_SIZE, true) > 0){}
+        ReportDropped(m_backpressure.PolicyName());
+        Logger::Flush();
+    }
+
+    void ShardedAsyncLogger::LogImpl(const LogAdditionInfo* other_info,
+                                        level::LevelEnum lv,
+                                        std::string_view org_str){
+        if(!m_running.load(std::memory_order_acquire)){
+            Logger::LogImpl(other_info, lv, org_str);
+            return;
+        }
+        Shard* shard = GetThreadShard();
+        if(m_backpressure.UsesWatermark()
+            && m_backpressure.DropBeforePush(lv, shard->queue.Size(), shard->queue.Capacity())){
+            CountDropped();
+            return;
+        }
+        if(shard->shared){
+            std::lock_guard<std::mutex> lk(m_shared_mutex);
+            Push(shard, other_info, lv, org_str);
+        }else{
+            Push(shard, other_info, lv, org_str);
+        }
+        if(m_backend_sleeping.load()){
+            WakeBackend();
+        }
+        // FATAL在返回前落地
+        if(lv == level::FATAL && CrashHandler::FlushOnFatal() && t_backend_logger != this){
+            Flush();
+        }
+    }
+
+    void ShardedAsyncLogger::Push(Shard* shard, const LogAdditionInfo* other_info,
+                                    level::LevelEnum lv, std::string_view org_str){
+        // 先登记再取时间戳：后台看到IDLE时，此后入队的记录时间戳不早于它本轮取的当前时间。
+        // 登记后再检查m_running(与Stop中的exchange构成Dekker式配对)：Stop要么等到本次入队结束，要么本次看到已停止
+        shard->inflight.store(SHARD_INFLIGHT_PENDING, std::memory_order_seq_cst);
+        if(!m_running.load(std::memory_order_seq_cst)){
+            shard->inflight.store(SHARD_INFLIGHT_IDLE, std::memory_order_release);
+            Logger::LogImpl(other_info, lv, org_str);
+            return;
+        }
+        uint64_t now_ns = MonotonicNs();
+        shard->inflight.store(now_ns, std::memory_order_seq_cst);
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        auto fill = [&](Record& rec){
+            rec.time_ns = now_ns;
+            rec.has_info = (other_info != nullptr);
+            if(rec.has_info){
+                rec.info = *other_info;
+                rec.info.SetTime(now);
+            }
+            rec.lv = lv;
+            rec.content.assign(org_str);
+        };
+        while(!shard->queue.TryPush(fill)){
+            // 分片已满：按背压策略丢弃或等待。其中的记录都早于now_ns，不受水位限制，后台线程总能腾出槽位
+            if(!m_running.load(std::memory_order_acquire)){
+                shard->inflight.store(SHARD_INFLIGHT_IDLE, std::memory_order_release);
+                Logger::LogImpl(other_info, lv, org_str);
+                return;
+            }
+            if(m_backpressure.DropWhenFull(lv)){
+                shard->inflight.store(SHARD_INFLIGHT_IDLE, std::memory_order_release);
+                CountDropped();
+                return;
+            }
+            WakeBackend();
+            std::this_thread::yield();
+        }
+        shard->inflight.store(SHARD_INFLIGHT_IDLE, std::memory_order_release);
+        CountAccepted();
+    }
+
+    ShardedAsyncLogger::Shard* ShardedAsyncLogger::GetThreadShard(){
+        for(const auto& ref : t_shard_cache.refs){
+            if(ref.logger_id == m_id){
+                return static_cast<Shard*>(ref.shard);
+            }
+        }
+        return ClaimShard();
+    }
+
+    ShardedAsyncLogger::Shard* ShardedAsyncLogger::ClaimShard(){
+        auto& refs = t_shard_cache.refs;
+        refs.erase(std::remove_if(refs.begin(), refs.end(),
+                                    [](const ThreadShardRef& ref){ return ref.holder.expired(); }),
+                    refs.end());
+
+        std::lock_guard<std::mutex> lk(m_claim_mutex);
+        std::shared_ptr<Shard> claimed;
+        // 优先复用已退出线程归还的分片
+        for(const auto& holder : m_shard_holders){
+            bool expected = false;
+            if(!holder->shared && !holder->owned.load(std::memory_order_relaxed)
+                && holder->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+                claimed = holder;
+                break;
+            }
+        }
+        size_t exclusive = m_shard_holders.size() - (m_shared_index == SIZE_MAX ? 0 : 1);
+        if(!claimed && exclusive < m_max_shards){
+            claimed = std::make_shared<Shard>(m_shard_queue_size);
+            claimed->owned.store(true, std::memory_order_relaxed);
+        }else if(!claimed){
+            if(m_shared_index == SIZE_MAX){
+                claimed = std::make_shared<Shard>(m_shard_queue_size);
+                claimed->shared = true;
+                m_shared_index = m_shard_holders.size();
+            }else{
+                claimed = m_shard_holders[m_shared_index];
+            }
+        }
+        if(std::find(m_shard_holders.begin(), m_shard_holders.end(), claimed) == m_shard_holders.end()){
+            size_t index = m_shard_holders.size();
+            m_shard_holders.push_back(claimed);
+            m_shards[index].store(claimed.get(), std::memory_order_release);
+            m_shard_count.store(index + 1, std::memory_order_release);
+        }
+        refs.push_back(ThreadShardRef{m_id, claimed.get(), claimed,
+                                        claimed->shared ? nullptr : &claimed->owned});
+        return claimed.get();
+    }
+
+    void ShardedAsyncLogger::Flush(){
+        if(!m_running.load(std::memory_order_acquire)){
+            Logger::Flush();
+            return;
+        }
+        std::unique_lock<std::mutex> lk(m_mutex);
+        if(m_stop){
+            lk.unlock();
+            Logger::Flush();
+            return;
+        }
+        size_t count = m_shard_count.load(std::memory_order_acquire);
+        for(size_t i = 0; i < count; i++){
+            size_t target = m_shards[i].load(std::memory_order_acquire)->queue.EnqueuedCount();
+            m_flush_targets[i] = std::max(m_flush_targets[i], target);
+        }
+        uint64_t gen = ++m_flush_gen;
+        m_backend_cv.notify_one();
+        m_flush_cv.wait(lk, [&]{ return m_flushed_gen >= gen; });
+    }
+
+    size_t ShardedAsyncLogger::GetQueueDepth() const{
+        size_t depth = 0;
+        size_t count = m_shard_count.load(std::memory_order_acquire);
+        for(size_t i = 0; i < count; i++){
+            depth += m_shards[i].load(std::memory_order_acquire)->queue.Size();
+        }
+        return depth;
+    }
+
+    size_t ShardedAsyncLogger::GetShardCount() const{
+        return m_shard_count.load(std::memory_order_acquire);
+    }
+
+    void ShardedAsyncLogger::EmergencyDrain(){
+        Logger::EmergencyDrain();
+        size_t count = m_shard_count.load(std::memory_order_acquire);
+        for(size_t i = 0; i < count; i++){
+            Shard* shard = m_shards[i].load(std::memory_order_acquire);
+            if(shard == nullptr){
+                continue;
+            }
+            shard->queue.Peek([this](const Record& rec){
+                EmergencySink(rec.has_info ? &rec.info : nullptr, rec.lv, rec.content);
+            });
+        }
+    }
+
+    void ShardedAsyncLogger::SetBackpressure(const BackpressureConfig& config){
+        m_backpressure.Set(config);
+    }
+
+    BackpressureConfig ShardedAsyncLogger::GetBackpressure() const{
+        return m_backpressure.Get();
+    }
+
+    void ShardedAsyncLogger::WakeBackend(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_backend_cv.notify_one();
+    }
+
+    bool ShardedAsyncLogger::AllShardsEmpty() const{
+        return GetQueueDepth() == 0;
+    }
+
+    bool ShardedAsyncLogger::FlushTargetsReachedLocked() const{
+        size_t count = m_shard_count.load(std::memory_order_acquire);
+        for(size_t i = 0; i < count; i++){
+            if(m_shards[i].load(std::memory_order_acquire)->queue.DequeuedCount() < m_flush_targets[i]){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t ShardedAsyncLogger::MergeRound(size_t max_records, bool unbounded){
+        uint64_t limit = UINT64_MAX;
+        if(!unbounded){
+            limit = MonotonicNs();
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        size_t count = m_shard_count.load(std::memory_order_acquire);
+        for(size_t i = 0; i < count && !unbounded; i++){
+            Shard* shard = m_shards[i].load(std::memory_order_acquire);
+            uint64_t inflight = shard->inflight.load(std::memory_order_seq_cst);
+            while(inflight == SHARD_INFLIGHT_PENDING){
+                // 生产者正在取时间戳，等它发布
+                std::this_thread::yield();
+                inflight = shard->inflight.load(std::memory_order_seq_cst);
+            }
+            if(inflight != SHARD_INFLIGHT_IDLE && inflight < limit){
+                limit = inflight;
+            }
+        }
+
+        // 各分片内部时间戳递增，取各队首建小顶堆做k路归并
+        auto later = std::greater<std::pair<uint64_t, Shard*>>();
+        m_heap.clear();
+        for(size_t i = 0; i < count; i++){
+            Shard* shard = m_shards[i].load(std::memory_order_acquire);
+            Record* rec = shard->queue.Front();
+            if(rec != nullptr && rec->time_ns <= limit){
+                m_heap.emplace_back(rec->time_ns, shard);
+            }
+        }
+        std::make_heap(m_heap.begin(), m_heap.end(), later);
+
+        size_t n = 0;
+        while(!m_heap.empty() && n < max_records && !CrashHandler::IsDraining()){
+            std::pop_heap(m_heap.begin(), m_heap.end(), later);
+            Shard* shard = m_heap.back().second;
+            m_heap.pop_back();
+
+            Record* rec = shard->queue.Front();
+            SinkImpl(rec->has_info ? &rec->info : nullptr, rec->lv, rec->content);
+            shard->queue.Pop();
+            n++;
+
+            rec = shard->queue.Front();
+            if(rec != nullptr && rec->time_ns <= limit){
+                m_heap.emplace_back(rec->time_ns, shard);
+                std::push_heap(m_heap.begin(), m_heap.end(), later);
+            }
+        }
+        return n;
+    }
+
+    void ShardedAsyncLogger::BackendLoop(){
+        t_backend_logger = this;
+        bool dirty = false;     // 自上次刷新后是否写过sink
+        for(;;){
+            if(CrashHandler::IsDraining()){
+                // 崩溃处理正在排空分片，停止消费以免重复写出，等待进程终止
+                std::this_thread::sleep_for(std::chrono::milliseconds(ASYNC_BACKEND_IDLE_WAIT_MS));
+                continue;
+            }
+            size_t n = MergeRound(ASYNC_BACKEND_BATCH_SIZE, false);
+            if(n > 0){
+                dirty = true;
+            }
+            // 各分片均已排空，背压解除后报告期间丢弃的条数
+            if(n < ASYNC_BACKEND_BATCH_SIZE && AllShardsEmpty()
+                && ReportDropped(m_backpressure.PolicyName())){
+                dirty = true;
+            }
+
+            std::unique_lock<std::mutex> lk(m_mutex);
+            if(m_flushed_gen < m_flush_gen && FlushTargetsReachedLocked()){
+                Logger::Flush();
+                dirty = false;
+                m_flushed_gen = m_flush_gen;
+                m_flush_cv.notify_all();
+            }
+            if(n == ASYNC_BACKEND_BATCH_SIZE){
+                continue;
+            }
+            if(AllShardsEmpty()){
+                if(m_stop){
+                    break;
+                }
+                if(dirty){
+                    Logger::Flush();
+                    dirty = false;
+                }
+                m_backend_sleeping = true;
+                if(AllShardsEmpty()){
+                    m_backend_cv.wait_for(lk, std::chrono::milliseconds(ASYNC_BACKEND_IDLE_WAIT_MS));
+                }
+                m_backend_sleeping = false;
+            }else if(n == 0){
+                // 队首记录晚于水位，或生产者正在入队
+                lk.unlock();
+                std::this_thread::yield();
+            }
+        }
+
+        Logger::Flush();
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_flushed_gen = m_flush_gen;
+        m_flush_cv.notify_all();
+    }
+} // namespace dysv
@@ -0,0 +1,619 @@
+#include "dysv/dy_binary_log.hpp"
+
+namespace dysv{
+    #define BINARY_RECORD_HEAD_SIZE     (1 + 4 + 8 + 4 + 4)     // 记录帧中参数之前的字节数
+    #define BINARY_PRINTF_SPEC_SIZE     32                      // 单个printf转换说明的最大长度
+    #define BINARY_PRINTF_BUFFER_SIZE   1024                    // 单个printf转换结果的最大长度
+    #define BINARY_BUFFER_RESERVE_EXTRA 4096                    // 缓冲在写出阈值之外预留的字节数
+
+    static std::atomic<uint32_t> s_next_site_id{1};
+
+    // 与记录时间戳同一时钟，m_first_pending_ms取自记录的时间戳
+    static int64_t RealtimeMs(){
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    template<class T>
+    static inline bool ReadPod(const char*& p, const char* end, T& val){
+        if((size_t)(end - p) < sizeof(T)){
+            return false;
+        }
+        memcpy(&val, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    static inline bool ReadBytes(const char*& p, const char* end, std::string_view& val){
+        uint32_t len;
+        if(!ReadPod(p, end, len) || (size_t)(end - p) < len){
+            return false;
+        }
+        val = std::string_view(p, len);
+        p += len;
+        return true;
+    }
+
+    // 仅用于编码的类型写入文件时对应的类型
+    static BinaryArgType WireType(BinaryArgType type){
+        switch(type){
+            case BIN_CSTR:
+            case BIN_STD_STRING:
+            case BIN_STRING_VIEW:
+            case BIN_CUSTOM:
+                return BIN_STRING;
+            case BIN_LONG_DOUBLE:
+                return BIN_F64;
+            default:
+                return type;
+        }
+    }
+
+    /*********************struct LogSite**************************************/
+    LogSite::LogSite(level::LevelEnum level, FormatStyle format_style, const char* file, uint64_t line,
+                        const char* func, const char* format)
+                        : id(s_next_site_id.fetch_add(1, std::memory_order_relaxed)), lv(level), style(format_style),
+                          file_name(file), line_num(line), func_name(func), fmt(format){}
+
+    /*********************class BinaryLogWriter**************************************/
+    BinaryLogWriter::BinaryLogWriter(const std::string& file_name, const FileFlushPolicy& policy)
+                                    : m_fd(-1), m_used(0), m_header_written(false), m_first_pending_ms(-1),
+                                      m_latency_timer(0), m_timers_closed(false),
+                                      m_file_name(file_name), m_pattern(DEFAULT_PATTERN_STR), m_policy(policy)
+    {
+        m_buffer.resize(m_policy.buffer_size + BINARY_BUFFER_RESERVE_EXTRA);
+        Reopen();
+    }
+
+    BinaryLogWriter::~BinaryLogWriter(){
+        TimerId timer;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_timers_closed = true;
+            timer = m_latency_timer;
+            m_latency_timer = 0;
+        }
+        // 不持有m_mutex：回调可能正等待该锁
+        TimingWheel::Global().Cancel(timer);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        WriteBufferLocked();
+        if(m_fd >= 0){
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    inline char* BinaryLogWriter::ReserveLocked(size_t len){
+        if(m_used + len > m_buffer.size()){
+            m_buffer.resize(std::max(m_buffer.size() * 2, m_used + len));
+        }
+        return &m_buffer[m_used];
+    }
+
+    template<class T>
+    inline void BinaryLogWriter::PutLocked(const T& val){
+        memcpy(ReserveLocked(sizeof(T)), &val, sizeof(T));
+        m_used += sizeof(T);
+    }
+
+    inline void BinaryLogWriter::PutBytesLocked(const char* data, size_t len){
+        PutLocked((uint32_t)len);
+        memcpy(ReserveLocked(len), data, len);
+        m_used += len;
+    }
+
+    void BinaryLogWriter::Write(const LogSite& site, const BinaryArg* args, size_t nargs){
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        uint64_t time_ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+        uint32_t thread_id = GetCurrentThreadId();
+
+        std::lock_guard<std::mutex> lk(m_mutex);
+        // 文件头与调用点定义也会先写进缓冲，须在追加它们之前判断缓冲是否为空
+        if(m_used == 0){
+            m_first_pending_ms = m_policy.max_latency_ms > 0 ? (int64_t)(time_ns / 1000000) : -1;
+        }
+        if(!m_header_written){
+            AppendHeaderLocked();
+        }
+        if(site.id >= m_defined.size()){
+            m_defined.resize(site.id * 2 + 1, 0);
+        }
+        if(!m_defined[site.id]){
+            AppendSiteLocked(site, args, nargs);
+            m_defined[site.id] = 1;
+        }
+
+        // 定长的帧头一次写入，参数字节数最后回填
+        char* head = ReserveLocked(BINARY_RECORD_HEAD_SIZE);
+        head[0] = BINARY_FRAME_RECORD;
+        memcpy(head + 1, &site.id, 4);
+        memcpy(head + 5, &time_ns, 8);
+        memcpy(head + 13, &thread_id, 4);
+        size_t len_pos = m_used + 17;
+        m_used += BINARY_RECORD_HEAD_SIZE;
+        for(size_t i = 0; i < nargs; i++){
+            AppendArgLocked(args[i]);
+        }
+        uint32_t args_len = m_used - len_pos - sizeof(uint32_t);
+        memcpy(&m_buffer[len_pos], &args_len, sizeof(args_len));
+
+        bool need_write = m_used >= m_policy.buffer_size || site.lv >= m_policy.flush_level;
+        if(!need_write && m_first_pending_ms >= 0){
+            need_write = (int64_t)(time_ns / 1000000) - m_first_pending_ms >= (int64_t)m_policy.max_latency_ms;
+        }
+        if(need_write){
+            WriteBufferLocked();
+        }else if(m_first_pending_ms >= 0 && m_latency_timer == 0){
+            ArmLatencyTimerLocked(m_policy.max_latency_ms);
+        }
+    }
+
+    void BinaryLogWriter::ArmLatencyTimerLocked(int64_t delay_ms){
+        if(m_timers_closed){
+            return;
+        }
+        m_latency_timer = TimingWheel::Global().Add((uint32_t)std::max<int64_t>(delay_ms, 1), [this]{ OnLatencyTimer(); });
+    }
+
+    void BinaryLogWriter::OnLatencyTimer(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_latency_timer = 0;
+        if(m_used == 0 || m_first_pending_ms < 0){
+            return;
+        }
+        int64_t age = RealtimeMs() - m_first_pending_ms;
+        if(age >= (int64_t)m_policy.max_latency_ms){
+            WriteBufferLocked();
+        }else{
+            ArmLatencyTimerLocked(m_policy.max_latency_ms - age);
+        }
+    }
+
+    void BinaryLogWriter::AppendArgLocked(const BinaryArg& arg){
+        switch(arg.type){
+            case BIN_BOOL: case BIN_CHAR: case BIN_I8: case BIN_U8:
+                PutLocked(*static_cast<const uint8_t*>(arg.ptr));
+                break;
+            case BIN_I16: case BIN_U16:
+                PutLocked(*static_cast<const uint16_t*>(arg.ptr));
+                break;
+            case BIN_I32: case BIN_U32: case BIN_F32:
+                PutLocked(*static_cast<const uint32_t*>(arg.ptr));
+                break;
+            case BIN_I64: case BIN_U64: case BIN_F64:
+                PutLocked(*static_cast<const uint64_t*>(arg.ptr));
+                break;
+            case BIN_PTR:
+                PutLocked((uint64_t)(uintptr_t)arg.ptr);
+                break;
+            case BIN_CSTR:{
+                const char* str = arg.ptr != nullptr ? static_cast<const char*>(arg.ptr) : "(null)";
+                PutBytesLocked(str, strlen(str));
+                break;
+            }
+            case BIN_STD_STRING:{
+                const std::string* str = static_cast<const std::string*>(arg.ptr);
+                PutBytesLocked(str->data(), str->size());
+                break;
+            }
+            case BIN_STRING_VIEW:{
+                const std::string_view* str = static_cast<const std::string_view*>(arg.ptr);
+                PutBytesLocked(str->data(), str->size());
+                break;
+            }
+            case BIN_LONG_DOUBLE:
+                PutLocked((double)*static_cast<const long double*>(arg.ptr));
+                break;
+            case BIN_CUSTOM:
+                m_scratch.clear();
+                arg.render(m_scratch, arg.ptr);
+                PutBytesLocked(m_scratch.data(), m_scratch.size());
+                break;
+            default:
+                break;
+        }
+    }
+
+    void BinaryLogWriter::AppendHeaderLocked(){
+        PutLocked((char)BINARY_FRAME_HEADER);
+        memcpy(ReserveLocked(4), BINARY_LOG_MAGIC, 4);
+        m_used += 4;
+        PutLocked((uint16_t)BINARY_LOG_VERSION);
+        PutBytesLocked(m_pattern.data(), m_pattern.size());
+        PutBytesLocked(m_logger_name.data(), m_logger_name.size());
+        m_header_written = true;
+    }
+
+    void BinaryLogWriter::AppendSiteLocked(const LogSite& site, const BinaryArg* args, size_t nargs){
+        PutLocked((char)BINARY_FRAME_SITE);
+        PutLocked(site.id);
+        PutLocked((uint8_t)site.lv);
+        PutLocked((uint8_t)site.style);
+        PutLocked((uint32_t)site.line_num);
+        PutLocked((uint8_t)nargs);
+        for(size_t i = 0; i < nargs; i++){
+            PutLocked((uint8_t)WireType(args[i].type));
+        }
+        PutBytesLocked(site.file_name, strlen(site.file_name));
+        PutBytesLocked(site.func_name, strlen(site.func_name));
+        PutBytesLocked(site.fmt, strlen(site.fmt));
+    }
+
+    void BinaryLogWriter::Flush(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        WriteBufferLocked();
+    }
+
+    void BinaryLogWriter::EmergencyFlush(){
+        // 不加锁：崩溃的线程可能正持有m_mutex。已写出的部分此后由m_used = 0保证不重复
+        size_t used = m_used;
+        if(m_fd >= 0 && used > 0 && used <= m_buffer.size()){
+            WriteFully(m_fd, m_buffer.data(), used);
+            m_used = 0;
+        }
+    }
+
+    void BinaryLogWriter::WriteBufferLocked(){
+        if(m_used > 0 && m_fd >= 0){
+            WriteFully(m_fd, m_buffer.data(), m_used);
+        }
+        m_used = 0;
+        m_first_pending_ms = -1;
+    }
+
+    bool BinaryLogWriter::Reopen(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        WriteBufferLocked();
+        if(m_fd >= 0){
+            close(m_fd);
+        }
+        m_fd = open(m_file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        // 新文件需重新写入文件头与调用点定义
+        m_header_written = false;
+        std::fill(m_defined.begin(), m_defined.end(), 0);
+        return m_fd >= 0;
+    }
+
+    void BinaryLogWriter::SetSource(const std::string& logger_name, const std::string& pattern){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_logger_name = logger_name;
+        m_pattern = pattern;
+    }
+
+    const std::string& BinaryLogWriter::GetFileName() const{
+        return m_file_name;
+    }
+
+    /*********************class BinaryLogDecoder**************************************/
+    /**
+     * @brief 按printf规则渲染已解码的参数。长度修饰符被忽略，按参数记录的实际类型输出。
+     *
+     */
+    template<class Value>
+    static void FormatPrintf(std::string& out, const char* fmt, const Value* args, size_t nargs){
+        size_t idx = 0;
+        auto is_unsigned = [](const Value& v){ return v.type >= BIN_U8 && v.type <= BIN_U64; };
+        auto next_int = [&](long long& val){
+            if(idx < nargs){
+                const Value& v = args[idx++];
+                val = is_unsigned(v) ? (long long)v.u : v.i;
+            }
+        };
+        char buf[BINARY_PRINTF_BUFFER_SIZE];
+        const char* p = fmt;
+        while(*p != '\0'){
+            const char* pct = strchr(p, '%');
+            if(pct == nullptr){
+                out.append(p);
+                break;
+            }
+            out.append(p, pct - p);
+            if(pct[1] == '%'){
+                out.push_back('%');
+                p = pct + 2;
+                continue;
+            }
+
+            // %[flags][width][.precision][length]conversion
+            const char* q = pct + 1;
+            const char* flags = q;
+            while(*q != '\0' && strchr("-+ #0", *q) != nullptr){
+                q++;
+            }
+            int flags_len = std::min<int>(q - flags, 5);
+            long long width = 0, precision = -1;
+            if(*q == '*'){
+                next_int(width);
+                q++;
+            }else{
+                while(*q >= '0' && *q <= '9'){
+                    width = width * 10 + (*q++ - '0');
+                }
+            }
+            if(*q == '.'){
+                q++;
+                precision = 0;
+                if(*q == '*'){
+                    next_int(precision);
+                    q++;
+                }else{
+                    while(*q >= '0' && *q <= '9'){
+                        precision = precision * 10 + (*q++ - '0');
+                    }
+                }
+            }
+            while(*q != '\0' && strchr("hlLqjzt", *q) != nullptr){
+                q++;
+            }
+            char conv = *q;
+            if(conv == '\0' || idx >= nargs){
+                // 不完整的转换说明或缺少参数，原样输出
+                const char* stop = conv == '\0' ? q : q + 1;
+                out.append(pct, stop - pct);
+                p = stop;
+                continue;
+            }
+            p = q + 1;
+
+            // 重新拼出不含长度修饰符的转换说明，字符串统一用".*s"限定长度
+            const Value& v = args[idx++];
+            const char* suffix = nullptr;
+            switch(conv){
+                case 'd': case 'i':     suffix = "lld"; break;
+                case 'u':               suffix = "llu"; break;
+                case 'o':               suffix = "llo"; break;
+                case 'x':               suffix = "llx"; break;
+                case 'X':               suffix = "llX"; break;
+                case 's':               suffix = ".*s"; break;
+                default:                suffix = nullptr; break;
+            }
+            char spec[BINARY_PRINTF_SPEC_SIZE];
+            char conv_str[2] = {conv, '\0'};
+            if(conv == 's' || precision < 0){
+                snprintf(spec, sizeof(spec), "%%%.*s%lld%s", flags_len, flags, width, suffix ? suffix : conv_str);
+            }else{
+                snprintf(spec, sizeof(spec), "%%%.*s%lld.%lld%s", flags_len, flags, width, precision, suffix ? suffix : conv_str);
+            }
+
+            int len = -1;
+            switch(conv){
+                case 'd': case 'i':
+                    len = snprintf(buf, sizeof(buf), spec, is_unsigned(v) ? (long long)v.u : (long long)v.i);
+                    break;
+                case 'u': case 'o': case 'x': case 'X':
+                    len = snprintf(buf, sizeof(buf), spec, is_unsigned(v) ? (unsigned long long)v.u : (unsigned long long)v.i);
+                    break;
+                case 'c':
+                    len = snprintf(buf, sizeof(buf), spec, v.type == BIN_CHAR ? (int)v.c : (int)v.i);
+                    break;
+                case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                    len = snprintf(buf, sizeof(buf), spec, v.f);
+                    break;
+                case 'p':
+                    len = snprintf(buf, sizeof(buf), spec, v.p);
+                    break;
+                case 's':{
+                    if(v.type != BIN_STRING){
+                        out.append("{?}");
+                        break;
+                    }
+                    size_t str_len = v.s.size();
+                    if(precision >= 0 && (size_t)precision < str_len){
+                        str_len = precision;
+                    }
+                    if((size_t)width <= str_len){
+                        // 无需填充，直接追加
+                        out.append(v.s.data(), str_len);
+                        break;
+                    }
+                    len = snprintf(buf, sizeof(buf), spec, (int)str_len, v.s.data());
+                    break;
+                }
+                default:
+                    out.append(pct, q + 1 - pct);
+                    break;
+            }
+            if(len > 0){
+                out.append(buf, std::min<size_t>(len, sizeof(buf) - 1));
+            }
+        }
+    }
+
+    BinaryLogDecoder::BinaryLogDecoder(const std::string& pattern)
+                                        : m_fixed_pattern(pattern), m_pattern(pattern.empty() ? DEFAULT_PATTERN_STR : pattern),
+                                          m_broken(false), m_records(0){}
+
+    bool BinaryLogDecoder::IsBroken() const{
+        return m_broken;
+    }
+
+    uint64_t BinaryLogDecoder::GetRecordCount() const{
+        return m_records;
+    }
+
+    size_t BinaryLogDecoder::Decode(const char* data, size_t len, std::string& out){
+        size_t consumed = 0;
+        while(!m_broken && consumed < len){
+            const char* frame = data + consumed;
+            size_t left = len - consumed;
+            size_t n = 0;
+            switch(*frame){
+                case BINARY_FRAME_HEADER:
+                    n = DecodeHeader(frame, left);
+                    break;
+                case BINARY_FRAME_SITE:
+                    n = DecodeSite(frame, left);
+                    break;
+                case BINARY_FRAME_RECORD:
+                    n = DecodeRecord(frame, left, out);
+                    break;
+                default:
+                    m_broken = true;
+                    break;
+            }
+            if(n == 0){
+                break;
+            }
+            consumed += n;
+        }
+        return consumed;
+    }
+
+    size_t BinaryLogDecoder::DecodeHeader(const char* data, size_t len){
+        const char* p = data + 1;
+        const char* end = data + len;
+        uint16_t version;
+        std::string_view pattern, logger_name;
+        if((size_t)(end - p) < 4){
+            return 0;
+        }
+        if(memcmp(p, BINARY_LOG_MAGIC, 4) != 0){
+            m_broken = true;
+            return 0;
+        }
+        p += 4;
+        if(!ReadPod(p, end, version) || !ReadBytes(p, end, pattern) || !ReadBytes(p, end, logger_name)){
+            return 0;
+        }
+        if(version != BINARY_LOG_VERSION){
+            m_broken = true;
+            return 0;
+        }
+        // 新的一段写入，调用点id可能已被重新分配
+        m_sites.clear();
+        if(m_fixed_pattern.empty()){
+            m_pattern.SetPatternStr(std::string(pattern));
+        }
+        return p - data;
+    }
+
+    size_t BinaryLogDecoder::DecodeSite(const char* data, size_t len){
+        const char* p = data + 1;
+        const char* end = data + len;
+        uint32_t id, line;
+        uint8_t lv, style, nargs;
+        if(!ReadPod(p, end, id) || !ReadPod(p, end, lv) || !ReadPod(p, end, style)
+            || !ReadPod(p, end, line) || !ReadPod(p, end, nargs) || (size_t)(end - p) < nargs){
+            return 0;
+        }
+        std::unique_ptr<Site> site(new Site());
+        site->lv = (level::LevelEnum)lv;
+        site->style = (LogSite::FormatStyle)style;
+        site->line_num = line;
+        for(uint8_t i = 0; i < nargs; i++){
+            BinaryArgType type = (BinaryArgType)*p++;
+            if(type >= BIN_WIRE_TYPE_COUNT){
+                m_broken = true;
+                return 0;
+            }
+            site->types.push_back(type);
+        }
+        std::string_view file_name, func_name, fmt;
+        if(!ReadBytes(p, end, file_name) || !ReadBytes(p, end, func_name) || !ReadBytes(p, end, fmt)){
+            return 0;
+        }
+        site->file_name.assign(file_name);
+        site->func_name.assign(func_name);
+        site->fmt.assign(fmt);
+        if(id >= m_sites.size()){
+            m_sites.resize(id + 1);
+        }
+        m_sites[id] = std::move(site);
+        return p - data;
+    }
+
+    size_t BinaryLogDecoder::DecodeRecord(const char* data, size_t len, std::string& out){
+        if(len < BINARY_RECORD_HEAD_SIZE){
+            return 0;
+        }
+        const char* p = data + 1;
+        const char* end = data + len;
+        uint32_t id, thread_id, args_len;
+        uint64_t time_ns;
+        ReadPod(p, end, id);
+        ReadPod(p, end, time_ns);
+        ReadPod(p, end, thread_id);
+        ReadPod(p, end, args_len);
+        if((size_t)(end - p) < args_len){
+            return 0;
+        }
+
+        const Site* site = id < m_sites.size() ? m_sites[id].get() : nullptr;
+        if(site == nullptr || !DecodeArgs(*site, p, args_len)){
+            out.append("[dysv_log_decode: undecodable record of site ").append(std::to_string(id)).append("]\n");
+            return BINARY_RECORD_HEAD_SIZE + args_len;
+        }
+        m_content.clear();
+        RenderContent(*site, m_content);
+
+        timespec ts;
+        ts.tv_sec = time_ns / 1000000000ull;
+        ts.tv_nsec = time_ns % 1000000000ull;
+        LogAdditionInfo info(site->file_name.c_str(), site->line_num, site->func_name.c_str(), thread_id, ts);
+        m_pattern.PatternLog(info, site->lv, m_content, out);
+        out.push_back('\n');
+        m_records++;
+        return BINARY_RECORD_HEAD_SIZE + args_len;
+    }
+
+    bool BinaryLogDecoder::DecodeArgs(const Site& site, const char* data, size_t len){
+        const char* p = data;
+        const char* end = data + len;
+        m_values.resize(site.types.size());
+        for(size_t i = 0; i < site.types.size(); i++){
+            Value& v = m_values[i];
+            v = Value();
+            v.type = site.types[i];
+            bool ok = true;
+            switch(v.type){
+                case BIN_BOOL:{ uint8_t x; ok = ReadPod(p, end, x); v.b = x != 0; break; }
+                case BIN_CHAR:  ok = ReadPod(p, end, v.c); break;
+                case BIN_I8:{   int8_t x; ok = ReadPod(p, end, x); v.i = x; break; }
+                case BIN_I16:{  int16_t x; ok = ReadPod(p, end, x); v.i = x; break; }
+                case BIN_I32:{  int32_t x; ok = ReadPod(p, end, x); v.i = x; break; }
+                case BIN_I64:   ok = ReadPod(p, end, v.i); break;
+                case BIN_U8:{   uint8_t x; ok = ReadPod(p, end, x); v.u = x; break; }
+                case BIN_U16:{  uint16_t x; ok = ReadPod(p, end, x); v.u = x; break; }
+                case BIN_U32:{  uint32_t x; ok = ReadPod(p, end, x); v.u = x; break; }
+                case BIN_U64:   ok = ReadPod(p, end, v.u); break;
+                case BIN_F32:{  float x; ok = ReadPod(p, end, x); v.f = x; break; }
+                case BIN_F64:   ok = ReadPod(p, end, v.f); break;
+                case BIN_PTR:{  uint64_t x; ok = ReadPod(p, end, x); v.p = (const void*)(uintptr_t)x; break; }
+                case BIN_STRING: ok = ReadBytes(p, end, v.s); break;
+                default: ok = false; break;
+            }
+            if(!ok){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void BinaryLogDecoder::RenderContent(const Site& site, std::string& out){
+        if(site.style == LogSite::PRINTF){
+            FormatPrintf(out, site.fmt.c_str(), m_values.data(), m_values.size());
+            return;
+        }
+        // 还原为与调用处一致的参数类别，复用"{}"格式化引擎
+        std::vector<fmt::ArgRef>& refs = m_refs;
+        refs.resize(m_values.size());
+        for(size_t i = 0; i < m_values.size(); i++){
+            const Value& v = m_values[i];
+            switch(v.type){
+                case BIN_BOOL:      refs[i] = fmt::ArgRef{&v.b, &fmt::WriteErased<bool>}; break;
+                case BIN_CHAR:      refs[i] = fmt::ArgRef{&v.c, &fmt::WriteErased<char>}; break;
+                case BIN_I8: case BIN_I16: case BIN_I32: case BIN_I64:
+                                    refs[i] = fmt::ArgRef{&v.i, &fmt::WriteErased<int64_t>}; break;
+                case BIN_U8: case BIN_U16: case BIN_U32: case BIN_U64:
+                                    refs[i] = fmt::ArgRef{&v.u, &fmt::WriteErased<uint64_t>}; break;
+                case BIN_F32: case BIN_F64:
+                                    refs[i] = fmt::ArgRef{&v.f, &fmt::WriteErased<double>}; break;
+                case BIN_PTR:       refs[i] = fmt::ArgRef{&v.p, &fmt::WriteErased<const void*>}; break;
+                default:            refs[i] = fmt::ArgRef{&v.s, &fmt::WriteErased<std::string_view>}; break;
+            }
+        }
+        fmt::VFormatTo(out, site.fmt, refs.data(), refs.size());
+    }
+} // namespace dysv
@@ -0,0 +1,296 @@
+#include <cerrno>
+#include <cstring>
+#include "dysv/dy_crash_handler.hpp"
+
+namespace dysv{
+    #define CRASH_SIGNAL_COUNT      5
+    #define SECONDS_PER_DAY         86400
+
+    static const int s_crash_signals[CRASH_SIGNAL_COUNT] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL};
+
+    /**
+     * @brief 固定槽位的登记表。静态存储期、零初始化，登记与遍历均为原子操作，可在信号处理函数中遍历。
+     *
+     */
+    template<class T, size_t N>
+    struct CrashRegistry{
+        std::atomic<T*> slots[N];
+
+        void Add(T* item){
+            for(size_t i = 0; i < N; i++){
+                T* expected = nullptr;
+                if(slots[i].compare_exchange_strong(expected, item, std::memory_order_acq_rel)){
+                    return;
+                }
+            }
+        }
+
+        void Remove(T* item){
+            for(size_t i = 0; i < N; i++){
+                T* expected = item;
+                if(slots[i].compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)){
+                    return;
+                }
+            }
+        }
+
+        template<class Visit>
+        void ForEach(Visit&& visit){
+            for(size_t i = 0; i < N; i++){
+                T* item = slots[i].load(std::memory_order_acquire);
+                if(item != nullptr){
+                    visit(item);
+                }
+            }
+        }
+    };
+
+    static CrashRegistry<Logger, CRASH_MAX_LOGGERS>                 s_loggers;
+    static CrashRegistry<LoggerSinkInterface, CRASH_MAX_SINKS>      s_sinks;
+
+    static std::atomic<bool>    s_installed{false};
+    static std::atomic<bool>    s_handling{false};      // 已有线程进入信号处理
+    static std::atomic<bool>    s_drained{false};       // 信号处理中的排空已完成
+    static struct sigaction     s_old_actions[CRASH_SIGNAL_COUNT];
+    static long                 s_utc_offset = 0;       // 本地时区相对UTC的偏移(秒)，Install时取得
+    static char*                s_alt_stack = nullptr;  // 备用信号栈，进程内只分配一次
+
+    std::atomic<bool> CrashHandler::s_flush_on_fatal{false};
+    std::atomic<bool> CrashHandler::s_draining{false};
+
+    /**
+     * @brief 定长缓冲上的追加写，超出容量的部分丢弃。只做内存拷贝，可在信号处理函数中使用。
+     *
+     */
+    class FixedWriter
+    {
+    public:
+        FixedWriter(char* buf, size_t cap) : m_buf(buf), m_cap(cap), m_size(0){}
+
+        void Append(const char* data, size_t len){
+            size_t n = std::min(len, m_cap - m_size);
+            memcpy(m_buf + m_size, data, n);
+            m_size += n;
+        }
+        void Append(const char* str){
+            Append(str, strlen(str));
+        }
+        void Push(char c){
+            if(m_size < m_cap){
+                m_buf[m_size++] = c;
+            }
+        }
+        // 十进制，不足width位时左侧补0
+        void AppendUInt(uint64_t val, int width = 0){
+            char digits[24];
+            int n = 0;
+            do{
+                digits[n++] = (char)('0' + val % 10);
+                val /= 10;
+            }while(val > 0);
+            for(int pad = width - n; pad > 0; pad--){
+                Push('0');
+            }
+            while(n > 0){
+                Push(digits[--n]);
+            }
+        }
+        size_t Size() const{ return m_size; }
+    private:
+        char*       m_buf;
+        size_t      m_cap;
+        size_t      m_size;
+    };
+
+    /**
+     * @brief 自1970-01-01起的天数转为年月日(公历)，纯算术，不经过localtime。
+     *
+     */
+    static void CivilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day){
+        days += 719468;
+        const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned doe = (unsigned)(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        day = doy - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = (int64_t)yoe + era * 400 + (month <= 2 ? 1 : 0);
+    }
+
+    /*********************class CrashHandler**************************************/
+    bool CrashHandler::Install(const CrashHandlerConfig& config){
+        tzset();
+        time_t now = time(nullptr);
+        struct tm local;
+        if(localtime_r(&now, &local) != nullptr){
+            s_utc_offset = local.tm_gmtoff;
+        }
+        s_flush_on_fatal.store(config.flush_on_fatal, std::memory_order_relaxed);
+
+        if(config.alt_stack_size > 0 && s_alt_stack == nullptr){
+            s_alt_stack = new char[config.alt_stack_size];
+            stack_t ss;
+            ss.ss_sp = s_alt_stack;
+            ss.ss_size = config.alt_stack_size;
+            ss.ss_flags = 0;
+            sigaltstack(&ss, nullptr);
+        }
+
+        if(!config.handle_signals){
+            if(s_installed.exchange(false)){
+                for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++){
+                    sigaction(s_crash_signals[i], &s_old_actions[i], nullptr);
+                }
+            }
+            return true;
+        }
+        if(s_installed.exchange(true)){
+            return true;
+        }
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_sigaction = &CrashHandler::SignalHandler;
+        sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        // 处理期间屏蔽所有崩溃信号：排空时再次崩溃由内核直接按默认方式终止，不会重入
+        sigemptyset(&sa.sa_mask);
+        for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++){
+            sigaddset(&sa.sa_mask, s_crash_signals[i]);
+        }
+        bool ok = true;
+        for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++){
+            if(sigaction(s_crash_signals[i], &sa, &s_old_actions[i]) != 0){
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    void CrashHandler::Uninstall(){
+        s_flush_on_fatal.store(false, std::memory_order_relaxed);
+        if(!s_installed.exchange(false)){
+            return;
+        }
+        for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++){
+            sigaction(s_crash_signals[i], &s_old_actions[i], nullptr);
+        }
+    }
+
+    bool CrashHandler::IsInstalled(){
+        return s_installed.load(std::memory_order_relaxed);
+    }
+
+    void CrashHandler::Drain(){
+        s_draining.store(true);
+        // 日志器先于sink：队列中的记录经EmergencyWrite写出前，sink会先写出自己的缓冲
+        s_loggers.ForEach([](Logger* logger){
+            logger->EmergencyDrain();
+        });
+        s_sinks.ForEach([](LoggerSinkInterface* sink){
+            sink->EmergencyFlush();
+        });
+    }
+
+    void CrashHandler::Register(Logger* logger){
+        s_loggers.Add(logger);
+    }
+
+    void CrashHandler::Unregister(Logger* logger){
+        s_loggers.Remove(logger);
+    }
+
+    void CrashHandler::Register(LoggerSinkInterface* sink){
+        s_sinks.Add(sink);
+    }
+
+    void CrashHandler::Unregister(LoggerSinkInterface* sink){
+        s_sinks.Remove(sink);
+    }
+
+    size_t CrashHandler::FormatRecord(char* buf, size_t cap, const LogAdditionInfo* other_info,
+                                        level::LevelEnum lv, std::string_view content){
+        if(cap == 0){
+            return 0;
+        }
+        // 留出换行的位置
+        FixedWriter out(buf, cap - 1);
+        if(other_info == nullptr){
+            out.Append(content.data(), content.size());
+            buf[out.Size()] = '\n';
+            return out.Size() + 1;
+        }
+
+        uint32_t fields_offset = other_info->m_fields_offset;
+        if(fields_offset != LOG_NO_FIELDS && fields_offset <= content.size()){
+            content = content.substr(0, fields_offset);
+        }
+        // 与DEFAULT_PATTERN_STR一致："[%D %H:%M:%S:%s][%T][%F][%L][%P][%C]"
+        int64_t local = (int64_t)other_info->m_time.tv_sec + s_utc_offset;
+        int64_t days = local / SECONDS_PER_DAY;
+        int64_t secs = local % SECONDS_PER_DAY;
+        if(secs < 0){
+            secs += SECONDS_PER_DAY;
+            days--;
+        }
+        int64_t year;
+        unsigned month, day;
+        CivilFromDays(days, year, month, day);
+
+        out.Push('[');
+        out.AppendUInt((uint64_t)year, 4);
+        out.Push('/');
+        out.AppendUInt(month, 2);
+        out.Push('/');
+        out.AppendUInt(day, 2);
+        out.Push(' ');
+        out.AppendUInt(secs / 3600, 2);
+        out.Push(':');
+        out.AppendUInt(secs / 60 % 60, 2);
+        out.Push(':');
+        out.AppendUInt(secs % 60, 2);
+        out.Push(':');
+        out.AppendUInt(other_info->m_time.tv_nsec / 1000, 6);
+        out.Append("][");
+        out.AppendUInt((uint64_t)other_info->m_thread_id);
+        out.Append("][");
+        out.Append(other_info->m_file_name != nullptr ? other_info->m_file_name : "");
+        out.Append("][");
+        out.AppendUInt(other_info->m_line_num);
+        out.Append("][");
+        out.Append(level::to_c_str(lv));
+        out.Append("][");
+        out.Append(content.data(), content.size());
+        out.Push(']');
+        buf[out.Size()] = '\n';
+        return out.Size() + 1;
+    }
+
+    void CrashHandler::SignalHandler(int sig, siginfo_t*, void*){
+        int saved_errno = errno;
+        if(!s_handling.exchange(true)){
+            char banner[64];
+            FixedWriter out(banner, sizeof(banner));
+            out.Append("dysv: caught signal ");
+            out.AppendUInt((uint64_t)sig);
+            out.Append(", draining logs\n");
+            WriteFully(STDERR_FILENO, banner, out.Size());
+            Drain();
+            s_drained.store(true);
+        }else{
+            // 其他线程正在排空，等它完成后随之终止
+            timespec interval = {0, 1000000};
+            while(!s_drained.load()){
+                nanosleep(&interval, nullptr);
+            }
+        }
+
+        // 恢复原先的处理方式并重新发出：信号当前被屏蔽，本函数返回后照常递送(产生core或交给原处理函数)
+        for(size_t i = 0; i < CRASH_SIGNAL_COUNT; i++){
+            if(s_crash_signals[i] == sig){
+                sigaction(sig, &s_old_actions[i], nullptr);
+            }
+        }
+        raise(sig);
+        errno = saved_errno;
+    }
+} // namespace dysv
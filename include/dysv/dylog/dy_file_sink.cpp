@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <cerrno>
+#include <sys/mman.h>
+#include "dysv/dy_file_sink.hpp"
+
+namespace dysv{
+    #define ROTATE_PREPARE_RETRY_MS     1000    // 预备文件打开失败后的重试间隔
+    #define MMAP_TAIL_SCAN_CHUNK        4096    // 查找崩溃遗留'\0'时每次读取的字节数
+    #define MMAP_REMAP_RETRY_MS         1000    // 段映射失败(如磁盘已满)后Sink的重试间隔
+
+    static int64_t RealtimeMs(){
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    /*********************class RotatingFileLoggerSink**************************************/
+    RotatingFileLoggerSink::RotatingFileLoggerSink(const std::string& name, const std::string& base_file,
+                                                    const RotatePolicy& rotate_policy,
+                                                    const FileFlushPolicy& flush_policy)
+                                                    : FileLoggerSink(name, base_file, flush_policy),
+                                                      m_rotate_policy(rotate_policy), m_base_file(base_file),
+                                                      m_next_file(base_file + ROTATE_NEXT_SEGMENT_SUFFIX),
+                                                      m_prepared_fd(-1), m_next_rotate_time(0), m_rotate_count(0),
+                                                      m_rotate_timer(0), m_need_prepare(true), m_stop(false)
+    {
+        m_backend = std::thread(&RotatingFileLoggerSink::BackendLoop, this);
+        if(m_rotate_policy.interval_sec > 0){
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_next_rotate_time = NextRotateTime(RealtimeMs() / 1000);
+            ArmRotateTimerLocked();
+        }
+    }
+
+    RotatingFileLoggerSink::~RotatingFileLoggerSink(){
+        TimerId timer;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_timers_closed = true;
+            timer = m_rotate_timer;
+            m_rotate_timer = 0;
+        }
+        TimingWheel::Global().Cancel(timer);
+        {
+            std::lock_guard<std::mutex> lk(m_backend_mutex);
+            m_stop = true;
+        }
+        m_backend_cv.notify_one();
+        if(m_backend.joinable()){
+            m_backend.join();
+        }
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if(m_prepared_fd >= 0){
+            close(m_prepared_fd);
+            unlink(m_next_file.c_str());
+            m_prepared_fd = -1;
+        }
+    }
+
+    uint64_t RotatingFileLoggerSink::GetRotateCount(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_rotate_count;
+    }
+
+    void RotatingFileLoggerSink::BeforeAppendLocked(size_t record_size){
+        uint64_t pending = m_file_bytes + m_buffer.size();
+        if(m_rotate_policy.max_file_size > 0 && pending > 0 && pending + record_size > m_rotate_policy.max_file_size){
+            // 后台尚未准备好下一个文件时继续写当前文件，下一条记录再尝试
+            RotateLocked();
+        }
+    }
+
+    bool RotatingFileLoggerSink::RotateLocked(){
+        if(m_prepared_fd < 0){
+            return false;
+        }
+        // 旧文件的缓冲写完后直接交换fd
+        WriteBufferLocked();
+        int old_fd = m_fd;
+        m_fd = m_prepared_fd;
+        m_prepared_fd = -1;
+        m_file_bytes = 0;
+        m_rotate_count++;
+        {
+            std::lock_guard<std::mutex> lk(m_backend_mutex);
+            m_retired_fds.push_back(old_fd);
+            m_need_prepare = true;
+        }
+        m_backend_cv.notify_one();
+        return true;
+    }
+
+    void RotatingFileLoggerSink::ArmRotateTimerLocked(){
+        if(m_timers_closed){
+            return;
+        }
+        int64_t delay = (int64_t)m_next_rotate_time * 1000 - RealtimeMs();
+        // 超出定时器范围的周期分段等待，到点后重新计算
+        delay = std::min<int64_t>(std::max<int64_t>(delay, 1), UINT32_MAX);
+        m_rotate_timer = TimingWheel::Global().Add((uint32_t)delay, [this]{ OnRotateTimer(); });
+    }
+
+    void RotatingFileLoggerSink::OnRotateTimer(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_rotate_timer = 0;
+        if(m_timers_closed){
+            return;
+        }
+        int64_t now_ms = RealtimeMs();
+        if(now_ms < (int64_t)m_next_rotate_time * 1000){
+            // 实时时钟被往回调整，或等待被分段
+            ArmRotateTimerLocked();
+            return;
+        }
+        // 本周期没有写入任何内容时不轮转，避免空闲期间用空文件挤掉历史文件
+        bool empty = m_file_bytes + m_buffer.size() == 0;
+        if(!empty && !RotateLocked()){
+            // 后台尚未准备好，稍后重试
+            m_rotate_timer = TimingWheel::Global().Add(ROTATE_PREPARE_RETRY_MS, [this]{ OnRotateTimer(); });
+            return;
+        }
+        m_next_rotate_time = NextRotateTime(now_ms / 1000);
+        ArmRotateTimerLocked();
+    }
+
+    void RotatingFileLoggerSink::BackendLoop(){
+        for(;;){
+            int old_fd = -1;
+            bool prepare = false;
+            {
+                std::unique_lock<std::mutex> lk(m_backend_mutex);
+                m_backend_cv.wait(lk, [this]{ return m_stop || m_need_prepare || !m_retired_fds.empty(); });
+                if(!m_retired_fds.empty()){
+                    // 必须先完成改名(base.next -> base)，再创建新的base.next
+                    old_fd = m_retired_fds.front();
+                    m_retired_fds.pop_front();
+                }else if(m_need_prepare && !m_stop){
+                    m_need_prepare = false;
+                    prepare = true;
+                }else if(m_stop){
+                    break;
+                }
+            }
+
+            if(old_fd >= 0){
+                RetireSegment(old_fd);
+                continue;
+            }
+            if(!prepare){
+                continue;
+            }
+            int fd = PrepareSegment();
+            if(fd < 0){
+                std::unique_lock<std::mutex> lk(m_backend_mutex);
+                m_backend_cv.wait_for(lk, std::chrono::milliseconds(ROTATE_PREPARE_RETRY_MS), [this]{ return m_stop; });
+                m_need_prepare = true;
+                continue;
+            }
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_prepared_fd = fd;
+        }
+    }
+
+    void RotatingFileLoggerSink::RetireSegment(int old_fd){
+        // 预分配使用了FALLOC_FL_KEEP_SIZE，截断到实际大小以释放多余的块
+        struct stat st;
+        if(fstat(old_fd, &st) == 0){
+            if(ftruncate(old_fd, st.st_size) != 0){
+                // 截断失败只影响磁盘占用
+            }
+        }
+        close(old_fd);
+
+        uint32_t max_files = m_rotate_policy.max_files;
+        if(max_files == 0){
+            unlink(m_base_file.c_str());
+        }else{
+            for(uint32_t i = max_files - 1; i >= 1; i--){
+                std::string from = m_base_file + "." + std::to_string(i);
+                std::string to = m_base_file + "." + std::to_string(i + 1);
+                rename(from.c_str(), to.c_str());
+            }
+            std::string first = m_base_file + ".1";
+            rename(m_base_file.c_str(), first.c_str());
+        }
+        rename(m_next_file.c_str(), m_base_file.c_str());
+    }
+
+    int RotatingFileLoggerSink::PrepareSegment(){
+        int fd = open(m_next_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+        if(fd < 0){
+            return -1;
+        }
+        uint64_t size = m_rotate_policy.prealloc_size > 0 ? m_rotate_policy.prealloc_size : m_rotate_policy.max_file_size;
+        if(size > ROTATE_MAX_PREALLOC_SIZE){
+            size = ROTATE_MAX_PREALLOC_SIZE;
+        }
+        if(size > 0){
+            // 预留磁盘块但不改变文件大小，O_APPEND仍从0开始写。文件系统不支持时忽略
+            if(fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, size) != 0){
+            }
+        }
+        return fd;
+    }
+
+    time_t RotatingFileLoggerSink::NextRotateTime(time_t now) const{
+        tm local;
+        localtime_r(&now, &local);
+        time_t interval = m_rotate_policy.interval_sec;
+        time_t local_sec = now + local.tm_gmtoff;
+        return (local_sec / interval + 1) * interval - local.tm_gmtoff;
+    }
+
+    /*********************class MmapFileLoggerSink**************************************/
+    MmapFileLoggerSink::MmapFileLoggerSink(const std::string& name, const std::string& file_name, size_t segment_size)
+                                            : LoggerSinkInterface(name), m_file_name(file_name),
+                                              m_fd(-1), m_current(nullptr), m_map_failed(false),
+                                              m_resume_end(0), m_next_remap_ms(INT64_MAX){
+        size_t page = sysconf(_SC_PAGESIZE);
+        segment_size = std::max<size_t>(segment_size, MMAP_MIN_SEGMENT_SIZE);
+        m_segment_size = (segment_size + page - 1) / page * page;
+
+        m_fd = open(m_file_name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(m_fd < 0){
+            return;
+        }
+        struct stat st;
+        if(fstat(m_fd, &st) != 0){
+            return;
+        }
+        std::lock_guard<std::mutex> lk(m_roll_mutex);
+        uint64_t data_end = FindDataEnd(st.st_size);
+        Segment* seg = MapSegmentLocked(data_end);
+        if(seg == nullptr){
+            MapFailedLocked(data_end);
+        }
+        m_current.store(seg);
+    }
+
+    MmapFileLoggerSink::~MmapFileLoggerSink(){
+        Segment* seg = m_current.load();
+        if(seg != nullptr){
+            size_t end = std::min(seg->offset.load(), seg->size);
+            munmap(seg->base, seg->size);
+            // 去掉预先扩展但未写入的部分
+            if(ftruncate(m_fd, seg->file_offset + end) != 0){
+            }
+        }else if(m_map_failed){
+            // 失败的映射可能已扩展了文件
+            if(ftruncate(m_fd, m_resume_end) != 0){
+            }
+        }
+        if(m_fd >= 0){
+            close(m_fd);
+        }
+    }
+
+    void MmapFileLoggerSink::Sink(const std::string& content){
+        Segment* seg = m_current.load(std::memory_order_acquire);
+        if(seg == nullptr){
+            seg = TryRemap();
+        }
+        size_t len = std::min(content.size() + 1, m_segment_size / 2);
+        while(seg != nullptr){
+            seg->writers.fetch_add(1, std::memory_order_acq_rel);
+            size_t off = seg->offset.fetch_add(len, std::memory_order_acq_rel);
+            if(off + len <= seg->size){
+                memcpy(seg->base + off, content.data(), len - 1);
+                seg->base[off + len - 1] = '\n';
+                seg->writers.fetch_sub(1, std::memory_order_release);
+                return;
+            }
+            seg->writers.fetch_sub(1, std::memory_order_release);
+
+            if(off <= seg->size){
+                // 恰好越过段尾的只有一个写线程，由它切换；[off, size)留空，新段从off处接着写
+                RollSegment(seg, off);
+            }else{
+                while(m_current.load(std::memory_order_acquire) == seg){
+                    std::this_thread::yield();
+                }
+            }
+            seg = m_current.load(std::memory_order_acquire);
+        }
+        // 映射失败，记录被丢弃
+        CountDropped();
+    }
+
+    void MmapFileLoggerSink::Flush(){
+        std::lock_guard<std::mutex> lk(m_roll_mutex);
+        Segment* seg = m_current.load();
+        if(seg == nullptr){
+            RemapLocked(true);
+            return;
+        }
+        size_t end = std::min(seg->offset.load(), seg->size);
+        if(end > 0){
+            msync(seg->base, end, MS_ASYNC);
+        }
+    }
+
+    const std::string& MmapFileLoggerSink::GetFileName() const{
+        return m_file_name;
+    }
+
+    size_t MmapFileLoggerSink::GetSegmentCount(){
+        std::lock_guard<std::mutex> lk(m_roll_mutex);
+        return m_segments.size();
+    }
+
+    MmapFileLoggerSink::Segment* MmapFileLoggerSink::MapSegmentLocked(uint64_t data_end){
+        size_t page = sysconf(_SC_PAGESIZE);
+        uint64_t file_offset = data_end / page * page;
+        // 映射区间必须完全落在文件内，否则访问时SIGBUS。优先fallocate真正分配磁盘块；
+        // 仅在文件系统不支持时退回ftruncate，磁盘已满(ENOSPC)时稀疏扩展会让之后的写入触发SIGBUS，放弃本次映射
+        if(fallocate(m_fd, 0, file_offset, m_segment_size) != 0){
+            if(errno != EOPNOTSUPP && errno != ENOSYS){
+                return nullptr;
+            }
+            struct stat st;
+            if(fstat(m_fd, &st) != 0){
+                return nullptr;
+            }
+            if((uint64_t)st.st_size < file_offset + m_segment_size
+                && ftruncate(m_fd, file_offset + m_segment_size) != 0){
+                return nullptr;
+            }
+        }
+        void* addr = mmap(nullptr, m_segment_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, file_offset);
+        if(addr == MAP_FAILED){
+            return nullptr;
+        }
+        m_segments.emplace_back(new Segment());
+        Segment* seg = m_segments.back().get();
+        seg->base = static_cast<char*>(addr);
+        seg->file_offset = file_offset;
+        seg->size = m_segment_size;
+        seg->offset.store(data_end - file_offset);
+        return seg;
+    }
+
+    void MmapFileLoggerSink::MapFailedLocked(uint64_t data_end){
+        m_map_failed = true;
+        m_resume_end = data_end;
+        m_next_remap_ms.store(RealtimeMs() + MMAP_REMAP_RETRY_MS, std::memory_order_relaxed);
+    }
+
+    MmapFileLoggerSink::Segment* MmapFileLoggerSink::RemapLocked(bool force){
+        Segment* seg = m_current.load();
+        if(seg != nullptr || !m_map_failed){
+            return seg;
+        }
+        if(!force && RealtimeMs() < m_next_remap_ms.load(std::memory_order_relaxed)){
+            return nullptr;
+        }
+        seg = MapSegmentLocked(m_resume_end);
+        if(seg == nullptr){
+            MapFailedLocked(m_resume_end);
+            return nullptr;
+        }
+        m_map_failed = false;
+        m_next_remap_ms.store(INT64_MAX, std::memory_order_relaxed);
+        m_current.store(seg, std::memory_order_release);
+        return seg;
+    }
+
+    MmapFileLoggerSink::Segment* MmapFileLoggerSink::TryRemap(){
+        if(RealtimeMs() < m_next_remap_ms.load(std::memory_order_relaxed)){
+            return nullptr;
+        }
+        std::unique_lock<std::mutex> lk(m_roll_mutex, std::try_to_lock);
+        if(!lk.owns_lock()){
+            return m_current.load(std::memory_order_acquire);
+        }
+        return RemapLocked(false);
+    }
+
+    void MmapFileLoggerSink::RollSegment(Segment* seg, size_t end){
+        std::lock_guard<std::mutex> lk(m_roll_mutex);
+        uint64_t data_end = seg->file_offset + end;
+        Segment* next = MapSegmentLocked(data_end);
+        if(next == nullptr){
+            // 暂时发布nullptr，期间的记录被丢弃，之后的Sink/Flush从data_end处重新映射
+            MapFailedLocked(data_end);
+        }
+        m_current.store(next, std::memory_order_release);
+        UnmapSegment(seg);
+    }
+
+    void MmapFileLoggerSink::UnmapSegment(Segment* seg){
+        while(seg->writers.load(std::memory_order_acquire) != 0){
+            std::this_thread::yield();
+        }
+        munmap(seg->base, seg->size);
+        seg->base = nullptr;
+    }
+
+    uint64_t MmapFileLoggerSink::FindDataEnd(uint64_t file_size){
+        // 崩溃遗留的'\0'最多一整段
+        uint64_t limit = file_size > m_segment_size ? file_size - m_segment_size : 0;
+        uint64_t end = file_size;
+        char buf[MMAP_TAIL_SCAN_CHUNK];
+        while(end > limit){
+            size_t n = std::min<uint64_t>(sizeof(buf), end - limit);
+            if(pread(m_fd, buf, n, end - n) != (ssize_t)n){
+                return file_size;
+            }
+            size_t i = n;
+            while(i > 0 && buf[i - 1] == '\0'){
+                i--;
+            }
+            if(i > 0){
+                return end - n + i;
+            }
+            end -= n;
+        }
+        return end;
+    }
+} // namespace dysv
@@ -1,12 +1,29 @@
 #include "dysv/dy_log.hpp"
+#include "dysv/dy_binary_log.hpp"
+#include "dysv/dy_crash_handler.hpp"
+#include "../common/dy_executor.hpp"
 
 namespace dysv{
     #define FOMATE_STR_BUFFER_SIZE  4096
     #define MICROSECONDS_PER_MILLISECONDS 1000
+    #define DATE_TIME_STR_LEN       19      // "YYYY/MM/DD HH:MM:SS"
+
+    /**
+     * @brief 将整数以十进制追加到out末尾，不足width位时左侧补0。
+     * 
+     */
+    static void AppendInteger(std::string& out, int64_t val, int width = 0){
+        char buf[24];
+        char* end = std::to_chars(buf, buf + sizeof(buf), val).ptr;
+        for(int pad = width - (int)(end - buf); pad > 0; pad--){
+            out.push_back('0');
+        }
+        out.append(buf, end - buf);
+    }
 
     /*********************namespace level**************************************/
     namespace level{
-        const std::string to_string(level::LevelEnum lv){
+        const char* to_c_str(level::LevelEnum lv){
             switch(lv){
                 case TRACE:
                     return "TRACE";
@@ -24,6 +41,10 @@ namespace dysv{
             return "UNKNOW";
         }
 
+        const std::string to_string(level::LevelEnum lv){
+            return to_c_str(lv);
+        }
+
         level::LevelEnum to_enum(const std::string &lv){
             if (lv == "TRACE" || lv == "trace"){
                 return level::TRACE;
@@ -72,6 +93,8 @@ namespace dysv{
                     return 'S';
                 case placeholder::s_MILLISECOND:
                     return 's';
+                case placeholder::f_FUNC_NAME:
+                    return 'f';
                 default:
                     return ' ';
             }
@@ -104,6 +127,8 @@ namespace dysv{
                     return placeholder::S_SECOND;
                 case 's':
                     return placeholder::s_MILLISECOND;
+                case 'f':
+                    return placeholder::f_FUNC_NAME;
                 default:
                     return placeholder::MAX_PATTERN;
             }
@@ -111,82 +136,145 @@ namespace dysv{
         }
     } // end of namespace placeholder
 
-    /*******************class LogAdditionInfo***********************************/
-    LogAdditionInfo::LogAdditionInfo(const std::string& file, uint64_t line)
-                                    : m_file_name(file), m_line_num(line){
-        m_thread_id = syscall(SYS_gettid);
-        timespec_get(&m_time, TIME_UTC);
+    pid_t GetCurrentThreadId(){
+        static thread_local pid_t t_thread_id = syscall(SYS_gettid);
+        return t_thread_id;
+    }
 
-        // 格式化秒级时间
-        m_tm = localtime(&m_time.tv_sec);
+    /**
+     * @brief 线程内缓存的秒级时间渲染结果"YYYY/MM/DD HH:MM:SS"，仅在秒数变化时重新localtime_r并渲染。
+     * 
+     */
+    struct SecondTimeCache{
+        time_t  sec = -1;
+        char    buf[DATE_TIME_STR_LEN + 1];
+    };
 
-        m_elapse = clock();
-    }
-    std::string LogAdditionInfo::GetFileName() const {return m_file_name;}
-    std::string LogAdditionInfo::GetLineNumber() const{ return std::to_string(m_line_num);}
-    std::string LogAdditionInfo::GetThreadId() const{
-        std::stringstream ss;
-        ss << m_thread_id;
-        return ss.str();
-    }
-    std::string LogAdditionInfo::GetDate() const{
-        char tmp_buf[FOMATE_STR_BUFFER_SIZE];
-        sprintf(tmp_buf, "%04d/%02d/%02d", m_tm->tm_year + 1900, m_tm->tm_mon + 1, m_tm->tm_mday);
-        return std::string(tmp_buf);
-    }
-    std::string LogAdditionInfo::GetHours() const{
-        return std::to_string(m_tm->tm_hour);
-    }
-    std::string LogAdditionInfo::GetMinutes() const{
-        return std::to_string(m_tm->tm_min);
+    // 写入恰好width位十进制数字(val不为负，超出的高位截去)，左侧补0，返回写入结束的位置
+    static char* WriteFixedDigits(char* p, int val, int width){
+        for(int i = width - 1; i >= 0; i--){
+            p[i] = (char)('0' + val % 10);
+            val /= 10;
+        }
+        return p + width;
     }
-    std::string LogAdditionInfo::GetSeconds() const{
-        return std::to_string(m_tm->tm_sec);
+
+    static const char* RenderSecond(time_t sec){
+        static thread_local SecondTimeCache t_cache;
+        if(t_cache.sec != sec){
+            tm t;
+            localtime_r(&sec, &t);
+            // 各字段定长，直接写数字(snprintf在-Wall下会报-Wformat-truncation)
+            char* p = t_cache.buf;
+            p = WriteFixedDigits(p, t.tm_year + 1900, 4);
+            *p++ = '/';
+            p = WriteFixedDigits(p, t.tm_mon + 1, 2);
+            *p++ = '/';
+            p = WriteFixedDigits(p, t.tm_mday, 2);
+            *p++ = ' ';
+            p = WriteFixedDigits(p, t.tm_hour, 2);
+            *p++ = ':';
+            p = WriteFixedDigits(p, t.tm_min, 2);
+            *p++ = ':';
+            p = WriteFixedDigits(p, t.tm_sec, 2);
+            *p = '\0';
+            t_cache.sec = sec;
+        }
+        return t_cache.buf;
     }
-    std::string LogAdditionInfo::GetMilliseconds() const{
-        return std::to_string(m_time.tv_nsec / MICROSECONDS_PER_MILLISECONDS);
+
+    /*******************class LogAdditionInfo***********************************/
+    LogAdditionInfo::LogAdditionInfo() : m_file_name(""), m_func_name(""), m_line_num(0), m_thread_id(0),
+                                        m_fields_offset(LOG_NO_FIELDS), m_time{}{}
+
+    LogAdditionInfo::LogAdditionInfo(const char* file, uint64_t line, const char* func)
+                                    : m_file_name(file), m_func_name(func), m_line_num(line), m_fields_offset(LOG_NO_FIELDS){
+        m_thread_id = GetCurrentThreadId();
+        clock_gettime(CLOCK_REALTIME, &m_time);
     }
 
+    LogAdditionInfo::LogAdditionInfo(const char* file, uint64_t line, const char* func, pid_t thread_id, const timespec& time)
+                                    : m_file_name(file), m_func_name(func), m_line_num(line),
+                                      m_thread_id(thread_id), m_fields_offset(LOG_NO_FIELDS), m_time(time){}
+
+    const timespec& LogAdditionInfo::GetTime() const{ return m_time;}
+    void LogAdditionInfo::SetTime(const timespec& time){ m_time = time;}
+    uint32_t LogAdditionInfo::GetFieldsOffset() const{ return m_fields_offset;}
+    void LogAdditionInfo::SetFieldsOffset(uint32_t offset){ m_fields_offset = offset;}
+    std::string LogAdditionInfo::GetFileName() const {return m_file_name;}
+    std::string LogAdditionInfo::GetFuncName() const {return m_func_name;}
+    std::string LogAdditionInfo::GetLineNumber() const{ return std::to_string(m_line_num);}
+    std::string LogAdditionInfo::GetThreadId() const{ return GetAdditionInfoByPlaceholder(placeholder::T_THREAD_ID);}
+    std::string LogAdditionInfo::GetDate() const{ return GetAdditionInfoByPlaceholder(placeholder::D_DATE);}
+    std::string LogAdditionInfo::GetHours() const{ return GetAdditionInfoByPlaceholder(placeholder::H_HOUR);}
+    std::string LogAdditionInfo::GetMinutes() const{ return GetAdditionInfoByPlaceholder(placeholder::M_MINUTE);}
+    std::string LogAdditionInfo::GetSeconds() const{ return GetAdditionInfoByPlaceholder(placeholder::S_SECOND);}
+    std::string LogAdditionInfo::GetMilliseconds() const{ return GetAdditionInfoByPlaceholder(placeholder::s_MILLISECOND);}
+
     std::string LogAdditionInfo::GetAdditionInfoByPlaceholder(char plchld) const{
         return GetAdditionInfoByPlaceholder(placeholder::to_enum(plchld));
     }
 
     std::string LogAdditionInfo::GetAdditionInfoByPlaceholder(placeholder::PlaceholderType plchld) const{
-        using PlcFunc = std::function<std::string(const LogAdditionInfo*)>;
-        using PairOfHoldAndFunc = std::pair<placeholder::PlaceholderType, PlcFunc>;
-        static std::vector<PairOfHoldAndFunc> s_placeholder2func = {
-            std::make_pair(placeholder::n_NEW_LINE,       [](const LogAdditionInfo* pLgInfo) -> std::string {return "\n";}),
-            std::make_pair(placeholder::t_TAB,            [](const LogAdditionInfo* pLgInfo) -> std::string {return "\t";}),
-            std::make_pair(placeholder::T_THREAD_ID,      [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetThreadId();}),
-            std::make_pair(placeholder::F_FILE_NAME,      [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetFileName();}),
-            std::make_pair(placeholder::L_LINE,           [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetLineNumber();}),
-            std::make_pair(placeholder::P_PRIORITY,       [](const LogAdditionInfo* pLgInfo) -> std::string {return "Unsupported";}),
-            std::make_pair(placeholder::C_CONTENT,        [](const LogAdditionInfo* pLgInfo) -> std::string {return "Unsupported";}),
-            std::make_pair(placeholder::D_DATE,           [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetDate();}),
-            std::make_pair(placeholder::H_HOUR,           [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetHours();}), 
-            std::make_pair(placeholder::M_MINUTE,         [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetMinutes();}), 
-            std::make_pair(placeholder::S_SECOND,         [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetSeconds();}), 
-            std::make_pair(placeholder::s_MILLISECOND,    [](const LogAdditionInfo* pLgInfo) -> std::string {return pLgInfo->GetMilliseconds();}), 
-            std::make_pair(placeholder::MAX_PATTERN,      [](const LogAdditionInfo* pLgInfo) -> std::string {return "Unsupported";}),
-        };
-        auto target = std::lower_bound(s_placeholder2func.begin(), s_placeholder2func.end(), 
-                                        plchld, 
-                                        [](const PairOfHoldAndFunc& a, placeholder::PlaceholderType b)->bool{
-                                            return a.first < b;
-                                        });
-        if(target == s_placeholder2func.end() || target->first != plchld){
-            std::cout << ("Unspported type" + std::string(1, placeholder::to_char(plchld)));
-            return "Unsupported";
+        std::string ans;
+        AppendAdditionInfo(plchld, ans);
+        return ans;
+    }
+
+    void LogAdditionInfo::AppendDateTime(std::string& out) const{
+        out.append(RenderSecond(m_time.tv_sec), DATE_TIME_STR_LEN);
+    }
+
+    void LogAdditionInfo::AppendAdditionInfo(placeholder::PlaceholderType plchld, std::string& out) const{
+        switch(plchld){
+            case placeholder::n_NEW_LINE:
+                out.push_back('\n');
+                break;
+            case placeholder::t_TAB:
+                out.push_back('\t');
+                break;
+            case placeholder::T_THREAD_ID:
+                AppendInteger(out, m_thread_id);
+                break;
+            case placeholder::F_FILE_NAME:
+                out.append(m_file_name);
+                break;
+            case placeholder::f_FUNC_NAME:
+                out.append(m_func_name);
+                break;
+            case placeholder::L_LINE:
+                AppendInteger(out, m_line_num);
+                break;
+            case placeholder::D_DATE:
+                out.append(RenderSecond(m_time.tv_sec), 10);
+                break;
+            case placeholder::H_HOUR:
+                out.append(RenderSecond(m_time.tv_sec) + 11, 2);
+                break;
+            case placeholder::M_MINUTE:
+                out.append(RenderSecond(m_time.tv_sec) + 14, 2);
+                break;
+            case placeholder::S_SECOND:
+                out.append(RenderSecond(m_time.tv_sec) + 17, 2);
+                break;
+            case placeholder::s_MILLISECOND:
+                AppendInteger(out, m_time.tv_nsec / MICROSECONDS_PER_MILLISECONDS, 6);
+                break;
+            default:
+                // P/C由LoggerPattern处理，其余为未知占位符
+                out.append("Unsupported");
+                break;
         }
-        return (target->second)(this);
     }
 
   /*********************class LoggerPattern**************************************/
-    LoggerPattern::LoggerPattern(){
-        m_pattern_str = LoggerPattern::GetDefaultPatternStr();
+    LoggerPattern::LoggerPattern() : m_encoding(ENCODING_TEXT){
+        SetPatternStr(LoggerPattern::GetDefaultPatternStr());
     }
 
-    LoggerPattern::LoggerPattern(const std::string& pt):m_pattern_str(pt){}
+    LoggerPattern::LoggerPattern(const std::string& pt, LogEncoding encoding) : m_encoding(encoding){
+        SetPatternStr(pt);
+    }
 
     // 格式化+模式化
     std::string LoggerPattern::FmtAndPatternLog(LogAdditionInfo::ptr other_info, 
@@ -200,24 +288,187 @@ namespace dysv{
     std::string LoggerPattern::PatternLog(LogAdditionInfo::ptr other_info, 
                                             level::LevelEnum lv, 
                                             const std::string &content){
-        std::string ans = "";
-        for(int i = 0; i < m_pattern_str.length(); i++){
-            if(m_pattern_str[i] == '%' && i < m_pattern_str.length() - 1){
+        return PatternLog(*other_info, lv, content);
+    }
+
+    std::string LoggerPattern::PatternLog(const LogAdditionInfo& other_info, 
+                                            level::LevelEnum lv, 
+                                            const std::string &content){
+        std::string ans;
+        PatternLog(other_info, lv, content, ans);
+        return ans;
+    }
+
+    void LoggerPattern::PatternLog(const LogAdditionInfo& other_info, 
+                                    level::LevelEnum lv, 
+                                    std::string_view content,
+                                    std::string& out) const{
+        // 拆出结构化字段区
+        std::string_view msg = content;
+        std::string_view fields;
+        uint32_t fields_offset = other_info.GetFieldsOffset();
+        if(fields_offset != LOG_NO_FIELDS && fields_offset <= content.size()){
+            msg = content.substr(0, fields_offset);
+            fields = content.substr(fields_offset);
+        }
+        if(m_encoding != ENCODING_TEXT){
+            PatternStructured(other_info, lv, msg, fields, out);
+            return;
+        }
+
+        const char* pattern = m_pattern_str.data();
+        for(const PatternItem& item : m_items){
+            switch(item.type){
+                case PatternItem::LITERAL:
+                    out.append(pattern + item.offset, item.length);
+                    break;
+                case PatternItem::CONTENT:
+                    out.append(msg);
+                    if(!fields.empty()){
+                        kv::RenderFields(out, ENCODING_TEXT, fields, !msg.empty());
+                    }
+                    break;
+                case PatternItem::PRIORITY:
+                    out.append(level::to_c_str(lv));
+                    break;
+                case PatternItem::DATE_TIME:
+                    other_info.AppendDateTime(out);
+                    break;
+                default:
+                    other_info.AppendAdditionInfo(item.placeholder, out);
+                    break;
+            }
+        }
+    }
+
+    // JSON/logfmt中各占位符的键名，nullptr表示不输出
+    static const char* PlaceholderKey(placeholder::PlaceholderType plchld){
+        switch(plchld){
+            case placeholder::T_THREAD_ID:      return "thread";
+            case placeholder::F_FILE_NAME:      return "file";
+            case placeholder::L_LINE:           return "line";
+            case placeholder::D_DATE:           return "date";
+            case placeholder::H_HOUR:           return "hour";
+            case placeholder::M_MINUTE:         return "minute";
+            case placeholder::S_SECOND:         return "second";
+            case placeholder::s_MILLISECOND:    return "us";
+            case placeholder::f_FUNC_NAME:      return "func";
+            default:                            return nullptr;
+        }
+    }
+
+    void LoggerPattern::PatternStructured(const LogAdditionInfo& other_info, 
+                                            level::LevelEnum lv, 
+                                            std::string_view msg,
+                                            std::string_view fields,
+                                            std::string& out) const{
+        // 附加信息先渲染到线程内缓冲，再按编码转义输出
+        static thread_local std::string t_value_buf;
+        const char sep = (m_encoding == ENCODING_JSON ? ',' : ' ');
+        bool need_sep = false;
+        if(m_encoding == ENCODING_JSON){
+            out.push_back('{');
+        }
+        for(const PatternItem& item : m_items){
+            const char* key = nullptr;
+            std::string_view val;
+            kv::FieldKind kind = kv::FIELD_STRING;
+            switch(item.type){
+                case PatternItem::LITERAL:
+                    continue;
+                case PatternItem::CONTENT:
+                    key = "msg";
+                    val = msg;
+                    break;
+                case PatternItem::PRIORITY:
+                    key = "level";
+                    val = level::to_c_str(lv);
+                    break;
+                case PatternItem::DATE_TIME:
+                    key = "time";
+                    t_value_buf.clear();
+                    other_info.AppendDateTime(t_value_buf);
+                    val = t_value_buf;
+                    break;
+                default:
+                    key = PlaceholderKey(item.placeholder);
+                    if(key == nullptr){
+                        continue;
+                    }
+                    t_value_buf.clear();
+                    other_info.AppendAdditionInfo(item.placeholder, t_value_buf);
+                    val = t_value_buf;
+                    if(item.placeholder == placeholder::T_THREAD_ID || item.placeholder == placeholder::L_LINE){
+                        kind = kv::FIELD_RAW;
+                    }
+                    break;
+            }
+            if(need_sep){
+                out.push_back(sep);
+            }
+            need_sep = true;
+            kv::AppendKeyValue(out, m_encoding, key, val, kind);
+        }
+        kv::RenderFields(out, m_encoding, fields, need_sep);
+        if(m_encoding == ENCODING_JSON){
+            out.push_back('}');
+        }
+    }
+
+    // 将模式串预编译为字面量片段与占位符序列，相邻字面量合并为一段
+    void LoggerPattern::Compile(){
+        m_items.clear();
+        auto add_literal = [this](size_t offset, size_t length){
+            if(!m_items.empty() && m_items.back().type == PatternItem::LITERAL
+                && m_items.back().offset + m_items.back().length == offset){
+                m_items.back().length += length;
+                return;
+            }
+            m_items.push_back({PatternItem::LITERAL, placeholder::MAX_PATTERN, offset, length});
+        };
+
+        size_t len = m_pattern_str.length();
+        for(size_t i = 0; i < len; i++){
+            if(m_pattern_str[i] == '%' && i < len - 1){
                 placeholder::PlaceholderType plType = placeholder::to_enum(m_pattern_str[i+1]);
                 if(plType == placeholder::C_CONTENT){
-                    ans += content;
+                    m_items.push_back({PatternItem::CONTENT, plType, 0, 0});
                 }else if(plType == placeholder::P_PRIORITY){
-                    ans += level::to_string(lv);
-                }
-                else{
-                    ans += other_info->GetAdditionInfoByPlaceholder(plType);
+                    m_items.push_back({PatternItem::PRIORITY, plType, 0, 0});
+                }else{
+                    m_items.push_back({PatternItem::ADDITION_INFO, plType, 0, 0});
                 }
                 i++;
             }else{
-                ans += m_pattern_str[i];
+                add_literal(i, 1);
             }
         }
-        return ans;
+
+        // 将"%D %H:%M:%S"融合为一项，直接拷贝线程内缓存的整段秒级时间
+        static const std::vector<std::pair<placeholder::PlaceholderType, char>> s_date_time_seq = {
+            {placeholder::D_DATE, ' '}, {placeholder::H_HOUR, ':'}, {placeholder::M_MINUTE, ':'}, {placeholder::S_SECOND, 0},
+        };
+        const size_t seq_items = s_date_time_seq.size() * 2 - 1;
+        std::vector<PatternItem> fused;
+        for(size_t i = 0; i < m_items.size(); i++){
+            bool match = (i + seq_items <= m_items.size());
+            for(size_t j = 0; match && j < s_date_time_seq.size(); j++){
+                const PatternItem& field = m_items[i + j * 2];
+                match = (field.type == PatternItem::ADDITION_INFO && field.placeholder == s_date_time_seq[j].first);
+                if(match && s_date_time_seq[j].second != 0){
+                    const PatternItem& sep = m_items[i + j * 2 + 1];
+                    match = (sep.type == PatternItem::LITERAL && sep.length == 1
+                                && m_pattern_str[sep.offset] == s_date_time_seq[j].second);
+                }
+            }
+            if(match){
+                fused.push_back({PatternItem::DATE_TIME, placeholder::MAX_PATTERN, 0, 0});
+                i += seq_items - 1;
+            }else{
+                fused.push_back(m_items[i]);
+            }
+        }
+        m_items.swap(fused);
     }
 
     // 格式化
@@ -230,14 +481,27 @@ namespace dysv{
     }
 
     std::string LoggerPattern::FormatLog(const std::string &org_str, va_list strArgs){
+        std::string content;
+        FormatLog(content, org_str.c_str(), strArgs);
+        return content;
+    }
+
+    void LoggerPattern::FormatLog(std::string& out, const char* org_str, va_list strArgs){
+        // 先写入栈上缓冲，超长时按实际长度扩容out后重新格式化
         char buffer[FOMATE_STR_BUFFER_SIZE];
-        int rc = vsprintf(buffer, org_str.c_str(), strArgs);
+        va_list retry_args;
+        va_copy(retry_args, strArgs);
+        int rc = vsnprintf(buffer, sizeof(buffer), org_str, strArgs);
         if(rc < 0){
             // ERROR. TODO
-            return "";
+        }else if((size_t)rc < sizeof(buffer)){
+            out.append(buffer, rc);
+        }else{
+            size_t old_size = out.size();
+            out.resize(old_size + rc);
+            vsnprintf(&out[old_size], rc + 1, org_str, retry_args);
         }
-        std::string content(buffer);
-        return content;
+        va_end(retry_args);
     }
 
     // (static) 获取默认模式串
@@ -247,6 +511,7 @@ namespace dysv{
 
     void LoggerPattern::SetPatternStr(const std::string & str){
         m_pattern_str = str;
+        Compile();
     }
     
     std::string LoggerPattern::GetPatternStr(){
@@ -254,17 +519,168 @@ namespace dysv{
     }
 
     void LoggerPattern::Reset2Default(){
-        m_pattern_str = LoggerPattern::GetDefaultPatternStr();
+        SetPatternStr(LoggerPattern::GetDefaultPatternStr());
+    }
+
+    void LoggerPattern::SetEncoding(LogEncoding encoding){
+        m_encoding = encoding;
+    }
+
+    LogEncoding LoggerPattern::GetEncoding() const{
+        return m_encoding;
     }
 
     /*********************class LoggerSinkInterface**************************************/
-    LoggerSinkInterface::LoggerSinkInterface(const std::string& name) : m_name(name){}
+    static uint64_t MonotonicNs(){
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /*********************struct SinkStats**************************************/
+    uint64_t SinkStats::LatencyPercentile(double p) const{
+        uint64_t total = 0;
+        for(size_t i = 0; i < DYSV_HISTOGRAM_BUCKETS; i++){
+            total += latency_buckets[i];
+        }
+        if(total == 0){
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(p * total);
+        rank = rank < total ? rank : total - 1;
+        uint64_t seen = 0;
+        for(size_t i = 0; i < DYSV_HISTOGRAM_BUCKETS; i++){
+            seen += latency_buckets[i];
+            if(seen > rank){
+                return std::min(StripedHistogram::BucketUpperBound(i), std::max<uint64_t>(latency_max_ns, 1));
+            }
+        }
+        return latency_max_ns;
+    }
+
+    /*********************struct LogStatsSnapshot**************************************/
+    LogStatsSnapshot LogStatsSnapshot::Since(const LogStatsSnapshot& earlier) const{
+        LogStatsSnapshot delta = *this;
+        for(auto& lg : delta.loggers){
+            auto old_lg = std::find_if(earlier.loggers.begin(), earlier.loggers.end(),
+                                        [&](const LoggerStats& s){ return s.name == lg.name; });
+            if(old_lg == earlier.loggers.end()){
+                continue;
+            }
+            lg.accepted -= std::min(lg.accepted, old_lg->accepted);
+            lg.filtered -= std::min(lg.filtered, old_lg->filtered);
+            lg.dropped -= std::min(lg.dropped, old_lg->dropped);
+            for(auto& sk : lg.sinks){
+                auto old_sk = std::find_if(old_lg->sinks.begin(), old_lg->sinks.end(),
+                                            [&](const SinkStats& s){ return s.name == sk.name; });
+                if(old_sk == old_lg->sinks.end()){
+                    continue;
+                }
+                sk.records -= std::min(sk.records, old_sk->records);
+                sk.bytes -= std::min(sk.bytes, old_sk->bytes);
+                sk.dropped -= std::min(sk.dropped, old_sk->dropped);
+                for(size_t i = 0; i < DYSV_HISTOGRAM_BUCKETS; i++){
+                    sk.latency_buckets[i] -= std::min(sk.latency_buckets[i], old_sk->latency_buckets[i]);
+                }
+            }
+        }
+        return delta;
+    }
+
+    std::string LogStatsSnapshot::ToString() const{
+        char date[32];
+        tm local;
+        localtime_r(&time.tv_sec, &local);
+        strftime(date, sizeof(date), "%Y/%m/%d %H:%M:%S", &local);
+
+        std::string out;
+        for(const auto& lg : loggers){
+            fmt::FormatTo(out, "{} [dysv stats] logger={} accepted={} filtered={} dropped={} queue_depth={}\n",
+                            date, lg.name, lg.accepted, lg.filtered, lg.dropped, lg.queue_depth);
+            for(const auto& sk : lg.sinks){
+                fmt::FormatTo(out, "{} [dysv stats] logger={} sink={} records={} bytes={} dropped={} "
+                                    "sink_p50_ns={} sink_p99_ns={} sink_p999_ns={} sink_max_ns={}\n",
+                                date, lg.name, sk.name, sk.records, sk.bytes, sk.dropped,
+                                sk.LatencyPercentile(0.5), sk.LatencyPercentile(0.99),
+                                sk.LatencyPercentile(0.999), sk.latency_max_ns);
+            }
+        }
+        return out;
+    }
+
+    std::atomic<uint64_t> LoggerSinkInterface::s_level_generation{1};
+
+    LoggerSinkInterface::LoggerSinkInterface(const std::string& name)
+                                            : m_name(name), m_level(level::TRACE), m_pattern(new LoggerPattern::ptr()){}
 
     LoggerSinkInterface::~LoggerSinkInterface(){}
 
+    void LoggerSinkInterface::Sink(level::LevelEnum, const std::string& content){
+        Sink(content);
+    }
+
+    void LoggerSinkInterface::Flush(){}
+
+    void LoggerSinkInterface::EmergencyFlush(){}
+
+    bool LoggerSinkInterface::EmergencyWrite(const char*, size_t){
+        return false;
+    }
+
+    void LoggerSinkInterface::RecordSink(size_t bytes, uint64_t cost_ns){
+        m_stats.Add(STAT_RECORDS);
+        m_stats.Add(STAT_BYTES, bytes);
+        m_latency.Record(cost_ns);
+    }
+
+    void LoggerSinkInterface::CountDropped(uint64_t n){
+        m_stats.Add(STAT_DROPPED, n);
+    }
+
+    SinkStats LoggerSinkInterface::GetStats(){
+        SinkStats stats;
+        stats.name = m_name;
+        stats.records = m_stats.Sum(STAT_RECORDS);
+        stats.bytes = m_stats.Sum(STAT_BYTES);
+        stats.dropped = m_stats.Sum(STAT_DROPPED);
+        stats.latency_max_ns = m_latency.Collect(stats.latency_buckets);
+        return stats;
+    }
+
     std::string LoggerSinkInterface::GetName(){
         return m_name;
     }
+
+    void LoggerSinkInterface::SetLevel(level::LevelEnum lv){
+        m_level.store(lv, std::memory_order_relaxed);
+        BumpLevelGeneration();
+    }
+
+    level::LevelEnum LoggerSinkInterface::GetLevel() const{
+        return m_level.load(std::memory_order_relaxed);
+    }
+
+    void LoggerSinkInterface::SetPattern(LoggerPattern::ptr pattern){
+        // 多个线程同时设置时由RcuPtr::Update的原子交换决定最终值，旧值延迟析构
+        m_pattern.Update(new LoggerPattern::ptr(pattern));
+    }
+
+    void LoggerSinkInterface::SetPattern(const std::string& pattern_str){
+        SetPattern(std::make_shared<LoggerPattern>(pattern_str));
+    }
+
+    LoggerPattern::ptr LoggerSinkInterface::GetPattern(){
+        RcuReadGuard guard;
+        return *m_pattern.Read();
+    }
+
+    const LoggerPattern* LoggerSinkInterface::PeekPattern() const{
+        return m_pattern.Read()->get();
+    }
+
+    void LoggerSinkInterface::BumpLevelGeneration(){
+        s_level_generation.fetch_add(1, std::memory_order_acq_rel);
+    }
     
     StdLoggerSink::~StdLoggerSink(){ m_stream = nullptr; }
 
@@ -287,83 +703,342 @@ namespace dysv{
         (*m_stream) << content << std::endl;
     }
 
+    void StdLoggerSink::Flush(){
+        m_stream->flush();
+    }
+
+    bool StdLoggerSink::EmergencyWrite(const char* data, size_t len){
+        // 每条记录都以std::endl刷新，流中没有待写出的内容，直接写fd不会乱序
+        return WriteFully(m_type == STD_ERROR ? STDERR_FILENO : STDOUT_FILENO, data, len);
+    }
+
     StdLoggerSinkType StdLoggerSink::GetType(){
         return m_type;
     }
 
-    FileLoggerSink::FileLoggerSink(const std::string& name, const std::string& file_name)
-                                    : LoggerSinkInterface(name), m_file_name(file_name) 
+    /**
+     * @brief 粗粒度单调时钟(毫秒)，仅读vDSO，不产生系统调用。
+     * 
+     */
+    static int64_t CoarseMonotonicMs(){
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    /**
+     * @brief 将[data, data+len)完整写入fd，处理EINTR与部分写。
+     * 
+     */
+    bool WriteFully(int fd, const char* data, size_t len){
+        while(len > 0){
+            ssize_t n = write(fd, data, len);
+            if(n < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    FileFlushPolicy FileFlushPolicy::Immediate(){
+        FileFlushPolicy policy;
+        policy.buffer_size = 0;
+        policy.max_latency_ms = 0;
+        policy.flush_level = level::TRACE;
+        return policy;
+    }
+
+    FileLoggerSink::FileLoggerSink(const std::string& name, const std::string& file_name, const FileFlushPolicy& policy)
+                                    : LoggerSinkInterface(name), m_fd(-1), m_first_pending_ms(-1), m_file_bytes(0),
+                                      m_timers_closed(false), m_file_name(file_name), m_policy(policy),
+                                      m_buffer_records(0), m_latency_timer(0)
     {
+        m_buffer.reserve(m_policy.buffer_size + FOMATE_STR_BUFFER_SIZE);
         Reopen();
+        CrashHandler::Register(this);
     }
 
     FileLoggerSink::~FileLoggerSink(){
-        if(m_stream){
-            m_stream.close();
+        // 先注销，崩溃处理不会再写入即将关闭的fd
+        CrashHandler::Unregister(this);
+        TimerId timer;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_timers_closed = true;
+            timer = m_latency_timer;
+            m_latency_timer = 0;
+        }
+        // 不持有m_mutex：回调可能正等待该锁
+        TimingWheel::Global().Cancel(timer);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        WriteBufferLocked();
+        if(m_fd >= 0){
+            close(m_fd);
+            m_fd = -1;
         }
     }
 
     void FileLoggerSink::Sink(const std::string& content){
-        m_stream << content << std::endl;
+        Sink(level::TRACE, content);
+    }
+
+    void FileLoggerSink::Sink(level::LevelEnum lv, const std::string& content){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        BeforeAppendLocked(content.size() + 1);
+        if(m_buffer.empty()){
+            m_first_pending_ms = m_policy.max_latency_ms > 0 ? CoarseMonotonicMs() : -1;
+        }
+        m_buffer.append(content);
+        m_buffer.push_back('\n');
+        m_buffer_records++;
+
+        bool need_write = m_buffer.size() >= m_policy.buffer_size || lv >= m_policy.flush_level;
+        if(!need_write && m_first_pending_ms >= 0){
+            need_write = CoarseMonotonicMs() - m_first_pending_ms >= (int64_t)m_policy.max_latency_ms;
+        }
+        if(need_write){
+            WriteBufferLocked();
+        }else if(m_first_pending_ms >= 0 && m_latency_timer == 0){
+            ArmLatencyTimerLocked(m_policy.max_latency_ms);
+        }
+    }
+
+    void FileLoggerSink::Flush(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        WriteBufferLocked();
+    }
+
+    void FileLoggerSink::EmergencyFlush(){
+        // 只写出一次。队列中的记录经EmergencyWrite写出前先到这里，保证先后顺序
+        if(m_emergency_flushed.exchange(true)){
+            return;
+        }
+        // 不加锁：崩溃的线程可能正持有m_mutex，只按容量校验长度
+        size_t size = m_buffer.size();
+        if(m_fd >= 0 && size > 0 && size <= m_buffer.capacity()){
+            WriteFully(m_fd, m_buffer.data(), size);
+        }
+    }
+
+    bool FileLoggerSink::EmergencyWrite(const char* data, size_t len){
+        EmergencyFlush();
+        return m_fd >= 0 && WriteFully(m_fd, data, len);
+    }
+
+    void FileLoggerSink::WriteBufferLocked(){
+        if(!m_buffer.empty()){
+            if(m_fd >= 0 && WriteFully(m_fd, m_buffer.data(), m_buffer.size())){
+                m_file_bytes += m_buffer.size();
+            }else{
+                CountDropped(m_buffer_records);
+            }
+        }
+        m_buffer.clear();
+        m_buffer_records = 0;
+        m_first_pending_ms = -1;
+    }
+
+    void FileLoggerSink::BeforeAppendLocked(size_t){}
+
+    void FileLoggerSink::ArmLatencyTimerLocked(int64_t delay_ms){
+        if(m_timers_closed){
+            return;
+        }
+        m_latency_timer = TimingWheel::Global().Add((uint32_t)std::max<int64_t>(delay_ms, 1), [this]{ OnLatencyTimer(); });
+    }
+
+    void FileLoggerSink::OnLatencyTimer(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_latency_timer = 0;
+        if(m_buffer.empty() || m_first_pending_ms < 0){
+            return;
+        }
+        int64_t age = CoarseMonotonicMs() - m_first_pending_ms;
+        if(age >= (int64_t)m_policy.max_latency_ms){
+            WriteBufferLocked();
+        }else{
+            // 期间缓冲已写出过，现在是更晚的一批
+            ArmLatencyTimerLocked(m_policy.max_latency_ms - age);
+        }
     }
 
     bool FileLoggerSink::Reopen(){
-        if(m_stream) {
-            m_stream.close();
+        std::lock_guard<std::mutex> lk(m_mutex);
+        WriteBufferLocked();
+        if(m_fd >= 0) {
+            close(m_fd);
         }
-        m_stream.open(m_file_name, std::ios::app);
-        return m_stream.is_open();
+        m_fd = open(m_file_name.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        struct stat st;
+        m_file_bytes = (m_fd >= 0 && fstat(m_fd, &st) == 0) ? st.st_size : 0;
+        return m_fd >= 0;
+    }
+
+    void FileLoggerSink::SetFlushPolicy(const FileFlushPolicy& policy){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_policy = policy;
+        WriteBufferLocked();
+    }
+
+    FileFlushPolicy FileLoggerSink::GetFlushPolicy(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_policy;
+    }
+
+    const std::string& FileLoggerSink::GetFileName() const{
+        return m_file_name;
     }
 
     /*********************class Logger**************************************/
     /// 构造函数、拷贝构造、赋值构造
-    Logger::Logger(const std::string& name){
+    Logger::Logger(const std::string& name) : m_sinks(new SinkMap()){
         m_name = name;
         this->Reset();
+        CrashHandler::Register(this);
     }
 
     Logger::Logger(const std::string &name, level::LevelEnum lv, const std::string& pt)
-                    :m_name(name), m_level(lv)
+                    :m_name(name), m_level(lv), m_sinks(new SinkMap()),
+                    m_pattern(new LoggerPattern::ptr(std::make_shared<LoggerPattern>(pt)))
     {
-        m_pattern = std::make_shared<LoggerPattern>(pt);
+        CrashHandler::Register(this);
+    }
+
+    Logger::~Logger(){
+        CrashHandler::Unregister(this);
     }
 
     /// 落日志
-    void Logger::LogImpl(LogAdditionInfo::ptr other_info, 
+    void Logger::LogImpl(const LogAdditionInfo* other_info, 
                     level::LevelEnum lv, 
-                    const std::string& org_str){
-        if(m_sinks.empty() || lv < m_level){
-            // std::cout << "logger named [" << m_name << "] have no sink!" << std::endl;
-            return;
+                    std::string_view org_str){
+        CountAccepted();
+        SinkImpl(other_info, lv, org_str);
+        if(lv == level::FATAL && CrashHandler::FlushOnFatal()){
+            Logger::Flush();
         }
+    }
 
-        std::string final_str = org_str;
-        if(other_info != nullptr){
-            final_str = m_pattern->PatternLog(other_info, lv, final_str);
+    void Logger::SinkImpl(const LogAdditionInfo* other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view org_str){
+        // 临界区内sink表快照及其中的sink不会被析构
+        RcuReadGuard guard;
+        const SinkMap* sinks = m_sinks.Read();
+        if(sinks->empty()){
+            return;
         }
+        // 每种模式只渲染一次，结果写入线程内复用的缓冲并由使用该模式的sink共享，稳定后不再申请内存
+        struct Rendered{
+            const LoggerPattern*    pattern;
+            std::string             buf;
+        };
+        static thread_local std::vector<Rendered> t_rendered;
+        size_t rendered_count = 0;
 
-        for(const auto& single_sink : m_sinks){
-            (single_sink.second)->Sink(final_str);
+        // 相邻两次读时钟即为一个sink的耗时，渲染新模式后重新起算
+        uint64_t begin = 0;
+        for(const auto& single_sink : *sinks){
+            LoggerSinkInterface* sink = single_sink.second.get();
+            if(!sink->ShouldSink(lv)){
+                continue;
+            }
+            // 不模式化时所有sink共用原始内容(pattern为nullptr)
+            const LoggerPattern* pattern = nullptr;
+            if(other_info != nullptr){
+                pattern = sink->PeekPattern();
+                pattern = (pattern != nullptr ? pattern : m_pattern.Read()->get());
+            }
+            size_t idx = 0;
+            while(idx < rendered_count && t_rendered[idx].pattern != pattern){
+                idx++;
+            }
+            if(idx == rendered_count){
+                if(rendered_count == t_rendered.size()){
+                    t_rendered.emplace_back();
+                }
+                Rendered& rendered = t_rendered[rendered_count++];
+                rendered.pattern = pattern;
+                rendered.buf.clear();
+                if(pattern != nullptr){
+                    pattern->PatternLog(*other_info, lv, org_str, rendered.buf);
+                }else{
+                    rendered.buf.append(org_str);
+                }
+                begin = MonotonicNs();
+            }
+            const std::string& content = t_rendered[idx].buf;
+            sink->Sink(lv, content);
+            uint64_t end = MonotonicNs();
+            sink->RecordSink(content.size(), end - begin);
+            begin = end;
         }
     }
 
-    void Logger::LogImplf(LogAdditionInfo::ptr other_info, 
+    void Logger::LogImplf(const LogAdditionInfo* other_info, 
                     level::LevelEnum lv, 
-                    const std::string& org_str, 
+                    const char* org_str, 
                     va_list vargs){
-        std::string formatted_str = m_pattern->FormatLog(org_str, vargs);
-        LogImpl(other_info, lv, formatted_str);
+        // 格式化结果写入线程内复用的缓冲。LogImpl不会再回到此处，复用安全
+        static thread_local std::string t_format_buf;
+        t_format_buf.clear();
+        LoggerPattern::FormatLog(t_format_buf, org_str, vargs);
+        LogImpl(other_info, lv, t_format_buf);
+    }
+
+    std::string& Logger::GetFormatBuffer(){
+        static thread_local std::string t_format_buf;
+        return t_format_buf;
+    }
+
+    void Logger::FormatPrintf(std::string& out, const char* org_str, ...){
+        va_list str_args;
+        va_start(str_args, org_str);
+        LoggerPattern::FormatLog(out, org_str, str_args);
+        va_end(str_args);
+    }
+
+    void Logger::AppendSuppressed(std::string& out, uint64_t suppressed){
+        out.append(" (");
+        char digits[24];
+        auto res = std::to_chars(digits, digits + sizeof(digits), suppressed);
+        out.append(digits, res.ptr - digits);
+        out.append(" suppressed)");
+    }
+
+    void Logger::LogSuppressed(const LogAdditionInfo& other_info, 
+                                level::LevelEnum lv, 
+                                std::string_view str, uint64_t suppressed){
+        if(suppressed == 0){
+            LogImpl(&other_info, lv, str);
+            return;
+        }
+        std::string& buf = GetFormatBuffer();
+        buf.assign(str.data(), str.size());
+        AppendSuppressed(buf, suppressed);
+        LogImpl(&other_info, lv, buf);
     }
 
     // no format, no pattern
     void Logger::Log(level::LevelEnum lv, 
-                const std::string& str){
-        LogImpl(nullptr, lv, str);
+                std::string_view str){
+        if(CheckLevel(lv)){
+            LogImpl(nullptr, lv, str);
+        }
     }
 
     // format, no pattern
     void Logger::Logf(level::LevelEnum lv, 
-                const std::string& org_str, ...){
+                const char* org_str, ...){
+        // 先过滤级别，被过滤的日志不做格式化
+        if(!CheckLevel(lv)){
+            return;
+        }
         va_list str_args;
         va_start(str_args, org_str);
         LogImplf(nullptr, lv, org_str, str_args);
@@ -371,41 +1046,134 @@ namespace dysv{
     }
 
     // no format, pattern
+    void Logger::Log(const LogAdditionInfo& other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view str){
+        if(CheckLevel(lv)){
+            LogImpl(&other_info, lv, str);
+        }
+    }
+
     void Logger::Log(LogAdditionInfo::ptr other_info, 
                     level::LevelEnum lv, 
-                    const std::string& str){
-        LogImpl(other_info, lv, str);
+                    std::string_view str){
+        if(CheckLevel(lv)){
+            LogImpl(other_info.get(), lv, str);
+        }
     }
 
     // format, pattern
+    void Logger::Logf(const LogAdditionInfo& other_info, 
+                        level::LevelEnum lv, 
+                        const char* org_str, ...){
+        // 先过滤级别，被过滤的日志不做格式化
+        if(!CheckLevel(lv)){
+            return;
+        }
+        va_list str_args;
+        va_start(str_args, org_str);
+        LogImplf(&other_info, lv, org_str, str_args);
+        va_end(str_args);
+    }
+
     void Logger::Logf(LogAdditionInfo::ptr other_info, 
                         level::LevelEnum lv, 
-                        const std::string& org_str, ...){
+                        const char* org_str, ...){
+        // 先过滤级别，被过滤的日志不做格式化
+        if(!CheckLevel(lv)){
+            return;
+        }
         va_list str_args;
         va_start(str_args, org_str);
-        LogImplf(other_info, lv, org_str, str_args);
+        LogImplf(other_info.get(), lv, org_str, str_args);
         va_end(str_args);
     }
 
     /// 辅助函数
     void Logger::Reset(){
         m_level = level::INFO;
-        m_sinks.clear();
-        m_pattern.reset(new LoggerPattern());
-        m_pattern->Reset2Default();
+        CleanSink();
+        LoggerPattern::ptr pattern = std::make_shared<LoggerPattern>();
+        pattern->Reset2Default();
+        SetPattern(pattern);
     }
 
     const std::string Logger::GetName(){
         return m_name;
     }
+
+    void Logger::Flush(){
+        {
+            RcuReadGuard guard;
+            for(const auto& single_sink : *m_sinks.Read()){
+                (single_sink.second)->Flush();
+            }
+        }
+        if(m_binary_writer){
+            m_binary_writer->Flush();
+        }
+    }
+
+    void Logger::SetBinaryWriter(std::shared_ptr<BinaryLogWriter> writer){
+        if(writer){
+            writer->SetSource(m_name, GetPattern()->GetPatternStr());
+        }
+        m_binary_writer = writer;
+        LoggerSinkInterface::BumpLevelGeneration();
+    }
+
+    const std::shared_ptr<BinaryLogWriter>& Logger::GetBinaryWriter() const{
+        return m_binary_writer;
+    }
+
+    void Logger::LogBinary(const LogSite& site, const BinaryArg* args, size_t nargs){
+        CountAccepted();
+        m_binary_writer->Write(site, args, nargs);
+    }
+
+    void Logger::EmergencyDrain(){
+        BinaryLogWriter* writer = m_binary_writer.get();
+        if(writer != nullptr){
+            writer->EmergencyFlush();
+        }
+    }
+
+    void Logger::EmergencySink(const LogAdditionInfo* other_info,
+                                level::LevelEnum lv,
+                                std::string_view org_str){
+        char line[CRASH_RECORD_BUFFER_SIZE];
+        size_t len = CrashHandler::FormatRecord(line, sizeof(line), other_info, lv, org_str);
+        // 不进入RCU读临界区(首次进入可能申请内存)，崩溃时sink表不会再被回收
+        for(const auto& single_sink : *m_sinks.Read()){
+            if(single_sink.second->ShouldSink(lv)){
+                single_sink.second->EmergencyWrite(line, len);
+            }
+        }
+    }
     
     /// 日志模式相关
-    LoggerPattern::ptr Logger::GetPattern() { return m_pattern; }
-    void Logger::SetPattern(const std::string& pattern_str){ 
-        m_pattern->SetPatternStr(pattern_str);
+    LoggerPattern::ptr Logger::GetPattern(){
+        RcuReadGuard guard;
+        return *m_pattern.Read();
     }
-    void Logger::SetPattern(LoggerPattern::ptr pattern_ptr){ 
-        m_pattern = pattern_ptr;
+
+    void Logger::SetPattern(const std::string& pattern_str){
+        // 保留当前的输出编码，只替换模式串
+        std::lock_guard<std::mutex> lk(m_pattern_mutex);
+        m_pattern.Update(new LoggerPattern::ptr(std::make_shared<LoggerPattern>(pattern_str, (*m_pattern.Read())->GetEncoding())));
+    }
+
+    void Logger::SetPattern(LoggerPattern::ptr pattern_ptr){
+        // 后台线程可能正在用旧模式渲染，由RCU延迟析构
+        std::lock_guard<std::mutex> lk(m_pattern_mutex);
+        m_pattern.Update(new LoggerPattern::ptr(pattern_ptr));
+    }
+
+    void Logger::SetEncoding(LogEncoding encoding){
+        std::lock_guard<std::mutex> lk(m_pattern_mutex);
+        LoggerPattern::ptr pattern = std::make_shared<LoggerPattern>(**m_pattern.Read());
+        pattern->SetEncoding(encoding);
+        m_pattern.Update(new LoggerPattern::ptr(pattern));
     }
     
     /// 日志级别相关
@@ -421,21 +1189,95 @@ namespace dysv{
         return m_level;
     }
 
+    /// 运行时统计
+    LoggerStats Logger::GetStats(){
+        LoggerStats stats;
+        stats.name = m_name;
+        stats.accepted = m_stats.Sum(STAT_ACCEPTED);
+        stats.filtered = m_filtered.Sum();
+        stats.dropped = m_stats.Sum(STAT_DROPPED);
+        stats.queue_depth = GetQueueDepth();
+        RcuReadGuard guard;
+        for(const auto& single_sink : *m_sinks.Read()){
+            stats.sinks.push_back(single_sink.second->GetStats());
+        }
+        return stats;
+    }
+
+    size_t Logger::GetQueueDepth() const{
+        return 0;
+    }
+
+    bool Logger::ReportDropped(const char* reason){
+        uint64_t dropped = m_stats.Sum(STAT_DROPPED);
+        if(dropped <= m_reported_drops){
+            return false;
+        }
+        std::string line;
+        fmt::FormatTo(line, "{} records dropped ({})", dropped - m_reported_drops, reason);
+        m_reported_drops = dropped;
+        LogAdditionInfo info(__FILE__, __LINE__, __func__);
+        SinkImpl(&info, level::WARN, line);
+        return true;
+    }
+
+    level::LevelEnum Logger::RefreshSinkMinLevel() const{
+        // 先取代数再读sink级别：期间若有变化，写回的代数已过期，下次调用会再次刷新
+        uint64_t generation = LoggerSinkInterface::GetLevelGeneration();
+        level::LevelEnum min_level = level::TRACE;
+        if(!m_binary_writer){
+            RcuReadGuard guard;
+            const SinkMap* sinks = m_sinks.Read();
+            if(!sinks->empty()){
+                min_level = level::UNKNOW;
+                for(const auto& single_sink : *sinks){
+                    min_level = std::min(min_level, single_sink.second->GetLevel());
+                }
+            }
+        }
+        m_sink_level_cache.store((generation << 8) | (uint64_t)min_level, std::memory_order_relaxed);
+        return min_level;
+    }
+
     /// 日志sink相关
     LoggerSinkInterface::ptr Logger::GetLoggerSink(const std::string &name){
-        return m_sinks[name];
+        RcuReadGuard guard;
+        const SinkMap* sinks = m_sinks.Read();
+        auto it = sinks->find(name);
+        return it == sinks->end() ? nullptr : it->second;
     }
 
     void Logger::AddSink(LoggerSinkInterface::ptr sink){
-        m_sinks.insert(std::make_pair(sink->GetName(), sink));
+        std::lock_guard<std::mutex> lk(m_sink_mutex);
+        const SinkMap* cur = m_sinks.Read();
+        if(cur->count(sink->GetName()) != 0){
+            return;
+        }
+        SinkMap* next = new SinkMap(*cur);
+        next->insert(std::make_pair(sink->GetName(), sink));
+        m_sinks.Update(next);
+        LoggerSinkInterface::BumpLevelGeneration();
     }
 
     void Logger::DelSink(const std::string &name){
-        m_sinks.erase(name);
+        std::lock_guard<std::mutex> lk(m_sink_mutex);
+        const SinkMap* cur = m_sinks.Read();
+        if(cur->count(name) == 0){
+            return;
+        }
+        SinkMap* next = new SinkMap(*cur);
+        next->erase(name);
+        m_sinks.Update(next);
+        LoggerSinkInterface::BumpLevelGeneration();
     }
     
     void Logger::CleanSink(){
-        m_sinks.clear();
+        std::lock_guard<std::mutex> lk(m_sink_mutex);
+        if(m_sinks.Read()->empty()){
+            return;
+        }
+        m_sinks.Update(new SinkMap());
+        LoggerSinkInterface::BumpLevelGeneration();
     }
   
     /*********************class LoggerManger**************************************/
@@ -446,80 +1288,227 @@ namespace dysv{
      *        3. set default logger.
      * 
      */
-    LoggerManger::LoggerManger(){
-        m_loggers.clear();
-        if(m_default_logger != nullptr){
-            m_default_logger->Reset();
-        }
-        m_default_logger = std::make_shared<dysv::Logger>(DEFAULT_LOGGER_NAME);
-        
-        m_default_logger->AddSink(std::make_shared<StdLoggerSink>(STD_COUT_NAME, STD_COUT));
-        m_loggers[m_default_logger->GetName()] = m_default_logger;
+    LoggerManger::LoggerManger() : m_default_logger(nullptr), m_loggers(new LoggerMap()), m_report_stop(false),
+                                    m_flush_timer(0){
+        Logger::ptr root = std::make_shared<dysv::Logger>(DEFAULT_LOGGER_NAME);
+        root->AddSink(std::make_shared<StdLoggerSink>(STD_COUT_NAME, STD_COUT));
+        m_default_holders.push_back(root);
+        m_default_logger.store(root.get(), std::memory_order_release);
+        AddLogger(root);
     }
 
-    Logger::ptr LoggerManger::GetDefaultLog(){
-        return m_default_logger;
+    LoggerManger::~LoggerManger(){
+        StopStatsReport();
+        StopBackgroundFlush();
     }
 
     void LoggerManger::SetDefaultLog(Logger::ptr logger){
-        m_default_logger = logger;
+        if(logger == nullptr){
+            return;
+        }
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if(std::find(m_default_holders.begin(), m_default_holders.end(), logger) == m_default_holders.end()){
+            m_default_holders.push_back(logger);
+        }
+        m_default_logger.store(logger.get(), std::memory_order_release);
     }
 
     bool LoggerManger::AddLogger(Logger::ptr logger){
-        m_loggers.insert(std::pair<std::string, Logger::ptr>(logger->GetName(), logger));
+        std::lock_guard<std::mutex> lk(m_mutex);
+        const LoggerMap* cur = m_loggers.Read();
+        if(cur->count(logger->GetName()) != 0){
+            return false;
+        }
+        LoggerMap* next = new LoggerMap(*cur);
+        next->insert(std::make_pair(logger->GetName(), logger));
+        m_loggers.Update(next);
+        return true;
     }
 
     bool LoggerManger::DelLogger(const std::string &name){
-        m_loggers.erase(name);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        const LoggerMap* cur = m_loggers.Read();
+        if(cur->count(name) == 0){
+            return false;
+        }
+        LoggerMap* next = new LoggerMap(*cur);
+        next->erase(name);
+        m_loggers.Update(next);
+        return true;
     }
 
     Logger::ptr LoggerManger::GetLogger(const std::string& name){
-        return m_loggers[name];
+        RcuReadGuard guard;
+        const LoggerMap* loggers = m_loggers.Read();
+        auto it = loggers->find(name);
+        return it == loggers->end() ? nullptr : it->second;
+    }
+
+    LogStatsSnapshot LoggerManger::Snapshot(){
+        LogStatsSnapshot snapshot;
+        clock_gettime(CLOCK_REALTIME, &snapshot.time);
+        std::vector<Logger::ptr> loggers;
+        {
+            RcuReadGuard guard;
+            for(const auto& lg : *m_loggers.Read()){
+                loggers.push_back(lg.second);
+            }
+        }
+        Logger* default_logger = GetDefaultLog();
+        bool default_registered = false;
+        for(const auto& lg : loggers){
+            snapshot.loggers.push_back(lg->GetStats());
+            default_registered = default_registered || lg.get() == default_logger;
+        }
+        if(!default_registered){
+            snapshot.loggers.push_back(default_logger->GetStats());
+        }
+        return snapshot;
+    }
+
+    void LoggerManger::StartStatsReport(LoggerSinkInterface::ptr sink, uint32_t interval_ms){
+        StopStatsReport();
+        if(sink == nullptr || interval_ms == 0){
+            return;
+        }
+        std::lock_guard<std::mutex> lk(m_report_mutex);
+        m_report_stop = false;
+        m_report_thread = std::thread(&LoggerManger::StatsReportLoop, this, sink, interval_ms);
+    }
+
+    void LoggerManger::StopStatsReport(){
+        std::thread reporter;
+        {
+            std::lock_guard<std::mutex> lk(m_report_mutex);
+            m_report_stop = true;
+            reporter.swap(m_report_thread);
+        }
+        m_report_cv.notify_all();
+        if(reporter.joinable()){
+            reporter.join();
+        }
+    }
+
+    void LoggerManger::StatsReportLoop(LoggerSinkInterface::ptr sink, uint32_t interval_ms){
+        LogStatsSnapshot last = Snapshot();
+        std::unique_lock<std::mutex> lk(m_report_mutex);
+        while(!m_report_stop){
+            if(m_report_cv.wait_for(lk, std::chrono::milliseconds(interval_ms), [this]{ return m_report_stop; })){
+                break;
+            }
+            lk.unlock();
+            LogStatsSnapshot now = Snapshot();
+            std::string report = now.Since(last).ToString();
+            last = std::move(now);
+            // 逐行写入，sink自行追加换行
+            size_t begin = 0;
+            while(begin < report.size()){
+                size_t end = report.find('\n', begin);
+                sink->Sink(level::INFO, report.substr(begin, end - begin));
+                begin = end + 1;
+            }
+            sink->Flush();
+            lk.lock();
+        }
+    }
+
+    void LoggerManger::StartBackgroundFlush(std::shared_ptr<Executor> executor, uint32_t interval_ms){
+        StopBackgroundFlush();
+        if(executor == nullptr || interval_ms == 0){
+            return;
+        }
+        // 尚未完成的刷新任务数，由任务自己持有，停止后仍在执行的任务不依赖本对象
+        auto pending = std::make_shared<std::atomic<size_t>>(0);
+        std::lock_guard<std::mutex> lk(m_flush_mutex);
+        m_flush_timer = TimingWheel::Global().AddPeriodic(interval_ms, [this, executor, pending]{
+            BackgroundFlushOnce(executor, pending);
+        });
+    }
+
+    void LoggerManger::StopBackgroundFlush(){
+        TimerId timer;
+        {
+            std::lock_guard<std::mutex> lk(m_flush_mutex);
+            timer = m_flush_timer;
+            m_flush_timer = 0;
+        }
+        TimingWheel::Global().Cancel(timer);
+    }
+
+    void LoggerManger::BackgroundFlushOnce(const std::shared_ptr<Executor>& executor,
+                                           const std::shared_ptr<std::atomic<size_t>>& pending){
+        if(pending->load() != 0){
+            return;
+        }
+        std::vector<Logger::ptr> loggers;
+        {
+            RcuReadGuard guard;
+            for(const auto& lg : *m_loggers.Read()){
+                loggers.push_back(lg.second);
+            }
+        }
+        // 每个日志器一个任务，慢的sink不拖住其他日志器
+        for(const auto& lg : loggers){
+            pending->fetch_add(1);
+            executor->Post([lg, pending]{
+                lg->Flush();
+                pending->fetch_sub(1);
+            });
+        }
+        // 未注册的默认日志器由m_default_holders保持，裸指针始终有效
+        Logger* default_logger = GetDefaultLog();
+        if(std::none_of(loggers.begin(), loggers.end(), [&](const Logger::ptr& lg){ return lg.get() == default_logger; })){
+            pending->fetch_add(1);
+            executor->Post([default_logger, pending]{
+                default_logger->Flush();
+                pending->fetch_sub(1);
+            });
+        }
     }
 
     // no format, no pattern
-    void trace(const std::string &str){
+    void trace(std::string_view str){
         DEFAULT_LOGGER->Log(dysv::level::TRACE, str);
     }
-    void info(const std::string &str){
+    void info(std::string_view str){
         DEFAULT_LOGGER->Log(dysv::level::INFO, str);
     }
-    void warn(const std::string &str){
+    void warn(std::string_view str){
         DEFAULT_LOGGER->Log(dysv::level::WARN, str);
     }
-    void error(const std::string &str){
+    void error(std::string_view str){
         DEFAULT_LOGGER->Log(dysv::level::ERROR, str);
     }
-    void fatal(const std::string &str){
+    void fatal(std::string_view str){
         DEFAULT_LOGGER->Log(dysv::level::FATAL, str);
     }
 
     // format, no pattern
-    void fmt_trace(const std::string &str, ...){
+    void fmt_trace(const char* str, ...){
         va_list vargs;
         va_start(vargs, str);
         DEFAULT_LOGGER->LogImplf(nullptr, dysv::level::TRACE, str, vargs);
         va_end(vargs);
     }
-    void fmt_info(const std::string &str, ...){
+    void fmt_info(const char* str, ...){
         va_list vargs;
         va_start(vargs, str);
         DEFAULT_LOGGER->LogImplf(nullptr, dysv::level::INFO, str, vargs);
         va_end(vargs);
     }
-    void fmt_warn(const std::string &str, ...){
+    void fmt_warn(const char* str, ...){
         va_list vargs;
         va_start(vargs, str);
         DEFAULT_LOGGER->LogImplf(nullptr, dysv::level::WARN, str, vargs);
         va_end(vargs);
     }
-    void fmt_error(const std::string &str, ...){
+    void fmt_error(const char* str, ...){
         va_list vargs;
         va_start(vargs, str);
         DEFAULT_LOGGER->LogImplf(nullptr, dysv::level::ERROR, str, vargs);
         va_end(vargs);
     }
-    void fmt_fatal(const std::string &str, ...){
+    void fmt_fatal(const char* str, ...){
         va_list vargs;
         va_start(vargs, str);
         DEFAULT_LOGGER->LogImplf(nullptr, dysv::level::FATAL, str, vargs);
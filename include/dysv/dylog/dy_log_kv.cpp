@@ -0,0 +1,187 @@
+#include "dysv/dy_log_kv.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace dysv
+{
+namespace kv
+{
+    static inline bool NeedEscape(unsigned char c, bool for_logfmt){
+        return c < 0x20 || c == '"' || c == '\\' || (for_logfmt && (c == ' ' || c == '='));
+    }
+
+    size_t FindEscape(const char* data, size_t len, bool for_logfmt){
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i equal = _mm_set1_epi8('=');
+        const __m128i ctrl_max = _mm_set1_epi8(0x1F);
+        for(; i + 16 <= len; i += 16){
+            __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+            // 无符号比较c <= 0x1F：max(c, 0x1F) == 0x1F
+            __m128i hit = _mm_cmpeq_epi8(_mm_max_epu8(chunk, ctrl_max), ctrl_max);
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, quote));
+            hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, backslash));
+            if(for_logfmt){
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, space));
+                hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, equal));
+            }
+            int mask = _mm_movemask_epi8(hit);
+            if(mask != 0){
+                return i + __builtin_ctz(mask);
+            }
+        }
+#endif
+        for(; i < len; i++){
+            if(NeedEscape((unsigned char)data[i], for_logfmt)){
+                return i;
+            }
+        }
+        return len;
+    }
+
+    // 不加引号的JSON转义。两次需要转义的字节之间整段拷贝
+    static void AppendEscaped(std::string& out, std::string_view str){
+        static const char s_hex[] = "0123456789abcdef";
+        const char* data = str.data();
+        size_t len = str.size();
+        size_t pos = 0;
+        while(pos < len){
+            size_t hit = pos + FindEscape(data + pos, len - pos, false);
+            out.append(data + pos, hit - pos);
+            if(hit == len){
+                break;
+            }
+            unsigned char c = (unsigned char)data[hit];
+            switch(c){
+                case '"':  out.append("\\\"", 2); break;
+                case '\\': out.append("\\\\", 2); break;
+                case '\n': out.append("\\n", 2); break;
+                case '\r': out.append("\\r", 2); break;
+                case '\t': out.append("\\t", 2); break;
+                case '\b': out.append("\\b", 2); break;
+                case '\f': out.append("\\f", 2); break;
+                default:{
+                    char buf[6] = {'\\', 'u', '0', '0', s_hex[c >> 4], s_hex[c & 0xF]};
+                    out.append(buf, sizeof(buf));
+                    break;
+                }
+            }
+            pos = hit + 1;
+        }
+    }
+
+    // 一次扩容，返回新增部分的起始位置。逐段append在短字段上开销明显
+    static inline char* Grow(std::string& out, size_t n){
+        size_t old_size = out.size();
+        out.resize(old_size + n);
+        return &out[old_size];
+    }
+
+    static inline char* Put(char* p, std::string_view str){
+        memcpy(p, str.data(), str.size());
+        return p + str.size();
+    }
+
+    void AppendJsonString(std::string& out, std::string_view str){
+        if(FindEscape(str.data(), str.size(), false) == str.size()){
+            char* p = Grow(out, str.size() + 2);
+            *p++ = '"';
+            p = Put(p, str);
+            *p = '"';
+            return;
+        }
+        out.push_back('"');
+        AppendEscaped(out, str);
+        out.push_back('"');
+    }
+
+    void AppendLogfmtValue(std::string& out, std::string_view str){
+        if(!str.empty() && FindEscape(str.data(), str.size(), true) == str.size()){
+            out.append(str);
+            return;
+        }
+        AppendJsonString(out, str);
+    }
+
+    void AppendKeyValue(std::string& out, LogEncoding encoding, std::string_view key, std::string_view val, FieldKind kind){
+        // 常见情况：键与值都无需转义，一次写入
+        if(encoding == ENCODING_JSON){
+            bool key_clean = FindEscape(key.data(), key.size(), false) == key.size();
+            bool val_clean = kind == FIELD_RAW || FindEscape(val.data(), val.size(), false) == val.size();
+            if(key_clean && val_clean){
+                size_t quotes = (kind == FIELD_RAW ? 0 : 2);
+                char* p = Grow(out, key.size() + val.size() + 3 + quotes);
+                *p++ = '"';
+                p = Put(p, key);
+                *p++ = '"';
+                *p++ = ':';
+                if(quotes){
+                    *p++ = '"';
+                }
+                p = Put(p, val);
+                if(quotes){
+                    *p = '"';
+                }
+                return;
+            }
+        }else if(kind == FIELD_RAW || (!val.empty() && FindEscape(val.data(), val.size(), true) == val.size())){
+            char* p = Grow(out, key.size() + val.size() + 1);
+            p = Put(p, key);
+            *p++ = '=';
+            Put(p, val);
+            return;
+        }
+
+        if(encoding == ENCODING_JSON){
+            AppendJsonString(out, key);
+            out.push_back(':');
+            if(kind == FIELD_RAW){
+                out.append(val);
+            }else{
+                AppendJsonString(out, val);
+            }
+            return;
+        }
+        out.append(key);
+        out.push_back('=');
+        if(kind == FIELD_RAW){
+            out.append(val);
+        }else{
+            AppendLogfmtValue(out, val);
+        }
+    }
+
+    void RenderFields(std::string& out, LogEncoding encoding, std::string_view fields, bool need_sep){
+        const char sep = (encoding == ENCODING_JSON ? ',' : ' ');
+        const char* p = fields.data();
+        const char* end = p + fields.size();
+        while(p + KV_FIELD_HEADER_SIZE <= end){
+            FieldKind kind = (FieldKind)*p;
+            uint16_t key_len;
+            memcpy(&key_len, p + 1, sizeof(key_len));
+            p += KV_FIELD_HEADER_SIZE;
+            if(p + key_len + KV_VALUE_LEN_SIZE > end){
+                break;
+            }
+            std::string_view key(p, key_len);
+            p += key_len;
+            uint32_t val_len;
+            memcpy(&val_len, p, sizeof(val_len));
+            p += KV_VALUE_LEN_SIZE;
+            if(p + val_len > end){
+                break;
+            }
+            if(need_sep){
+                out.push_back(sep);
+            }
+            need_sep = true;
+            AppendKeyValue(out, encoding, key, std::string_view(p, val_len), kind);
+            p += val_len;
+        }
+    }
+} // namespace kv
+} // namespace dysv
@@ -0,0 +1,112 @@
+#include "dysv/dy_log_stream.hpp"
+
+namespace dysv
+{
+    /*********************class LogStreamBuf**************************************/
+    LogStreamBuf::int_type LogStreamBuf::overflow(int_type ch){
+        if(!traits_type::eq_int_type(ch, traits_type::eof())){
+            m_target->push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize LogStreamBuf::xsputn(const char* s, std::streamsize n){
+        m_target->append(s, n);
+        return n;
+    }
+
+    /*********************class LogStream**************************************/
+    struct LogStream::FallbackStream{
+        LogStreamBuf    buf;
+        std::ostream    os{&buf};
+    };
+
+    // 线程内复用的缓冲，同一时刻只由一条记录占用
+    struct LogStreamThreadState{
+        std::string     buf;
+        bool            in_use = false;
+    };
+
+    static LogStreamThreadState& GetLogStreamThreadState(){
+        static thread_local LogStreamThreadState t_state;
+        return t_state;
+    }
+
+    LogStream::LogStream(Logger* logger, const LogAdditionInfo& other_info, level::LevelEnum lv)
+                        : m_logger(logger), m_info(other_info), m_has_info(true), m_enabled(true),
+                          m_owns_thread_buf(false), m_stream_used(false), m_lv(lv), m_buf(&m_local_buf){
+        LogStreamThreadState& state = GetLogStreamThreadState();
+        if(m_enabled && !state.in_use){
+            state.in_use = true;
+            state.buf.clear();
+            m_buf = &state.buf;
+            m_owns_thread_buf = true;
+        }
+    }
+
+    LogStream::LogStream(Logger* logger, level::LevelEnum lv)
+                        : m_logger(logger), m_has_info(false), m_enabled(logger->CheckLevel(lv)),
+                          m_owns_thread_buf(false), m_stream_used(false), m_lv(lv), m_buf(&m_local_buf){
+        LogStreamThreadState& state = GetLogStreamThreadState();
+        if(m_enabled && !state.in_use){
+            state.in_use = true;
+            state.buf.clear();
+            m_buf = &state.buf;
+            m_owns_thread_buf = true;
+        }
+    }
+
+    LogStream::~LogStream(){
+        // 级别已在构造时(或DY_LOG_STREAM_*宏中)检查过
+        if(m_enabled){
+            m_logger->LogImpl(m_has_info ? &m_info : nullptr, m_lv, *m_buf);
+        }
+        // 提交完成后才释放，提交过程中再打印的流式日志使用各自的m_local_buf
+        if(m_owns_thread_buf){
+            GetLogStreamThreadState().in_use = false;
+        }
+    }
+
+    std::ostream& LogStream::GetFallbackStream(){
+        static thread_local FallbackStream t_stream;
+        FallbackStream* stream = &t_stream;
+        if(!m_owns_thread_buf){
+            // 嵌套的记录(外层记录可能正在经t_stream调用用户的operator<<)
+            if(!m_local_stream){
+                m_local_stream.reset(new FallbackStream);
+            }
+            stream = m_local_stream.get();
+        }
+        if(!m_stream_used){
+            // 清除上一条记录留下的格式状态
+            stream->buf.SetTarget(m_buf);
+            stream->os.clear();
+            stream->os.flags(std::ios_base::dec | std::ios_base::skipws | std::ios_base::boolalpha);
+            stream->os.precision(6);
+            stream->os.width(0);
+            stream->os.fill(' ');
+            m_stream_used = true;
+        }
+        return stream->os;
+    }
+
+    LogStream& LogStream::operator<<(std::ostream& (*manip)(std::ostream&)){
+        if(m_enabled){
+            manip(GetFallbackStream());
+        }
+        return *this;
+    }
+
+    LogStream& LogStream::operator<<(std::ios_base& (*manip)(std::ios_base&)){
+        if(m_enabled){
+            manip(GetFallbackStream());
+        }
+        return *this;
+    }
+
+    LogStream traceStream(){ return LogStream(DEFAULT_LOGGER, level::TRACE); }
+    LogStream infoStream(){ return LogStream(DEFAULT_LOGGER, level::INFO); }
+    LogStream warnStream(){ return LogStream(DEFAULT_LOGGER, level::WARN); }
+    LogStream errorStream(){ return LogStream(DEFAULT_LOGGER, level::ERROR); }
+    LogStream fatalStream(){ return LogStream(DEFAULT_LOGGER, level::FATAL); }
+} // namespace dysv
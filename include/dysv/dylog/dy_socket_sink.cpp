@@ -0,0 +1,361 @@
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "dysv/dy_socket_sink.hpp"
+#include "dysv/dy_crash_handler.hpp"
+
+namespace dysv{
+    #define SOCKET_SEND_FLAGS   (MSG_DONTWAIT | MSG_NOSIGNAL)
+
+    static int64_t CoarseMonotonicMs(){
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    // 对端不在或已断开，需重连; 其余错误(缓冲满等)留待下次重试
+    static bool IsDisconnectError(int err){
+        return err != EAGAIN && err != EWOULDBLOCK && err != ENOBUFS && err != EINTR;
+    }
+
+    /*********************struct SocketSinkConfig**************************************/
+    SocketSinkConfig SocketSinkConfig::Unix(const std::string& path, bool stream){
+        SocketSinkConfig config;
+        config.type = stream ? SOCKET_UNIX_STREAM : SOCKET_UNIX_DGRAM;
+        config.path = path;
+        return config;
+    }
+
+    SocketSinkConfig SocketSinkConfig::Udp(const std::string& host, uint16_t port){
+        SocketSinkConfig config;
+        config.type = SOCKET_UDP;
+        config.host = host;
+        config.port = port;
+        return config;
+    }
+
+    /*********************class SocketLoggerSink**************************************/
+    SocketLoggerSink::SocketLoggerSink(const std::string& name, const SocketSinkConfig& config, const FileFlushPolicy& policy)
+                                        : LoggerSinkInterface(name), m_config(config), m_policy(policy), m_fd(-1),
+                                          m_open_records(0), m_stream_partial(false),
+                                          m_send_threshold(policy.buffer_size), m_first_pending_ms(-1),
+                                          m_next_connect_ms(0), m_connect_count(0),
+                                          m_latency_timer(0), m_timers_closed(false)
+    {
+        if(m_config.datagram_size == 0){
+            m_config.datagram_size = DEFAULT_SOCKET_DATAGRAM_SIZE;
+        }
+        m_buffer.reserve(std::min(m_config.max_pending_bytes, m_policy.buffer_size + m_config.datagram_size));
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            ConnectLocked();
+        }
+        CrashHandler::Register(this);
+    }
+
+    SocketLoggerSink::~SocketLoggerSink(){
+        CrashHandler::Unregister(this);
+        TimerId timer;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_timers_closed = true;
+            timer = m_latency_timer;
+            m_latency_timer = 0;
+        }
+        // 不持有m_mutex：回调可能正等待该锁
+        TimingWheel::Global().Cancel(timer);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        SendLocked();
+        DisconnectLocked();
+    }
+
+    void SocketLoggerSink::Sink(const std::string& content){
+        Sink(level::TRACE, content);
+    }
+
+    void SocketLoggerSink::Sink(level::LevelEnum lv, const std::string& content){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        size_t len = content.size();
+        if(IsDatagram() && len + 1 > m_config.datagram_size){
+            len = m_config.datagram_size - 1;
+        }
+        if(m_buffer.size() + len + 1 > m_config.max_pending_bytes){
+            // 收集端不可用或跟不上：先尝试发送腾出空间，仍放不下则丢弃本条
+            SendLocked(false);
+            if(m_buffer.size() + len + 1 > m_config.max_pending_bytes){
+                CountDropped();
+                return;
+            }
+        }
+        if(m_buffer.empty()){
+            m_first_pending_ms = m_policy.max_latency_ms > 0 ? CoarseMonotonicMs() : -1;
+        }
+        if(IsDatagram()){
+            // 记录不跨报文：放不进正在填充的报文时先封口
+            size_t open_begin = m_datagrams.empty() ? 0 : m_datagrams.back().end;
+            if(m_buffer.size() - open_begin + len + 1 > m_config.datagram_size){
+                SealLocked();
+            }
+            m_open_records++;
+        }
+        m_buffer.append(content.data(), len);
+        m_buffer.push_back('\n');
+
+        bool need_seal = lv >= m_policy.flush_level;
+        if(!need_seal && m_first_pending_ms >= 0){
+            need_seal = CoarseMonotonicMs() - m_first_pending_ms >= (int64_t)m_policy.max_latency_ms;
+        }
+        if(need_seal || m_buffer.size() >= m_send_threshold){
+            SendLocked(need_seal);
+        }
+        // 发送未能清空时m_first_pending_ms为该次尝试的时刻，定时器同时负责重试
+        if(m_first_pending_ms >= 0 && m_latency_timer == 0){
+            ArmLatencyTimerLocked(m_policy.max_latency_ms);
+        }
+    }
+
+    void SocketLoggerSink::Flush(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        SendLocked();
+    }
+
+    bool SocketLoggerSink::IsConnected(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_fd >= 0;
+    }
+
+    size_t SocketLoggerSink::GetPendingBytes(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_buffer.size();
+    }
+
+    uint64_t SocketLoggerSink::GetConnectCount(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_connect_count;
+    }
+
+    bool SocketLoggerSink::ConnectLocked(){
+        if(m_fd >= 0){
+            return true;
+        }
+        int64_t now = CoarseMonotonicMs();
+        if(now < m_next_connect_ms){
+            return false;
+        }
+        m_next_connect_ms = now + m_config.reconnect_interval_ms;
+
+        sockaddr_storage addr;
+        socklen_t addr_len;
+        memset(&addr, 0, sizeof(addr));
+        int domain;
+        if(m_config.type == SOCKET_UDP){
+            sockaddr_in* in = (sockaddr_in*)&addr;
+            in->sin_family = AF_INET;
+            in->sin_port = htons(m_config.port);
+            if(inet_pton(AF_INET, m_config.host.c_str(), &in->sin_addr) != 1){
+                return false;
+            }
+            domain = AF_INET;
+            addr_len = sizeof(sockaddr_in);
+        }else{
+            sockaddr_un* un = (sockaddr_un*)&addr;
+            if(m_config.path.size() >= sizeof(un->sun_path)){
+                return false;
+            }
+            un->sun_family = AF_UNIX;
+            memcpy(un->sun_path, m_config.path.c_str(), m_config.path.size() + 1);
+            domain = AF_UNIX;
+            addr_len = sizeof(sockaddr_un);
+        }
+
+        int type = (m_config.type == SOCKET_UNIX_STREAM ? SOCK_STREAM : SOCK_DGRAM);
+        int fd = socket(domain, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(fd < 0){
+            return false;
+        }
+        // Unix与UDP套接字的connect不会等待对端，失败(收集端不存在、监听队列满)时稍后重试
+        if(connect(fd, (sockaddr*)&addr, addr_len) != 0){
+            close(fd);
+            return false;
+        }
+        m_fd = fd;
+        m_connect_count++;
+        return true;
+    }
+
+    void SocketLoggerSink::DisconnectLocked(){
+        if(m_fd >= 0){
+            close(m_fd);
+            m_fd = -1;
+        }
+        // 对端只收到了半条记录，剩下的半条在新连接上无法解析
+        if(m_stream_partial){
+            size_t pos = m_buffer.find('\n');
+            m_buffer.erase(0, pos == std::string::npos ? m_buffer.size() : pos + 1);
+            m_stream_partial = false;
+            CountDropped();
+        }
+    }
+
+    void SocketLoggerSink::SealLocked(){
+        size_t open_begin = m_datagrams.empty() ? 0 : m_datagrams.back().end;
+        if(m_buffer.size() > open_begin){
+            m_datagrams.push_back(Datagram{m_buffer.size(), m_open_records});
+            m_open_records = 0;
+        }
+    }
+
+    void SocketLoggerSink::SendLocked(bool seal){
+        if(!m_buffer.empty() && ConnectLocked()){
+            if(!IsDatagram()){
+                SendStreamLocked();
+            }else{
+                if(seal){
+                    SealLocked();
+                }
+                SendDatagramsLocked();
+            }
+        }
+        // 未能清空(收集端不在或跟不上)时顺延下一次尝试
+        m_send_threshold = m_buffer.size() + m_policy.buffer_size;
+        if(m_buffer.empty()){
+            m_first_pending_ms = -1;
+        }else if(m_first_pending_ms >= 0){
+            m_first_pending_ms = CoarseMonotonicMs();
+        }
+    }
+
+    void SocketLoggerSink::ArmLatencyTimerLocked(int64_t delay_ms){
+        if(m_timers_closed){
+            return;
+        }
+        m_latency_timer = TimingWheel::Global().Add((uint32_t)std::max<int64_t>(delay_ms, 1), [this]{ OnLatencyTimer(); });
+    }
+
+    void SocketLoggerSink::OnLatencyTimer(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_latency_timer = 0;
+        if(m_buffer.empty() || m_first_pending_ms < 0){
+            return;
+        }
+        int64_t age = CoarseMonotonicMs() - m_first_pending_ms;
+        if(age >= (int64_t)m_policy.max_latency_ms){
+            SendLocked();
+            if(m_first_pending_ms >= 0){
+                ArmLatencyTimerLocked(m_policy.max_latency_ms);
+            }
+        }else{
+            ArmLatencyTimerLocked(m_policy.max_latency_ms - age);
+        }
+    }
+
+    void SocketLoggerSink::SendDatagramsLocked(){
+        mmsghdr msgs[SOCKET_SEND_BATCH];
+        iovec iovs[SOCKET_SEND_BATCH];
+        size_t sent = 0;
+        while(sent < m_datagrams.size()){
+            size_t n = std::min(m_datagrams.size() - sent, (size_t)SOCKET_SEND_BATCH);
+            size_t begin = (sent == 0 ? 0 : m_datagrams[sent - 1].end);
+            for(size_t i = 0; i < n; i++){
+                size_t end = m_datagrams[sent + i].end;
+                iovs[i].iov_base = &m_buffer[begin];
+                iovs[i].iov_len = end - begin;
+                memset(&msgs[i], 0, sizeof(msgs[i]));
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+                begin = end;
+            }
+            int ret = sendmmsg(m_fd, msgs, n, SOCKET_SEND_FLAGS);
+            if(ret < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                if(errno == EMSGSIZE){
+                    // 超过对端或内核允许的报文大小，只能丢弃
+                    CountDropped(m_datagrams[sent].records);
+                    sent++;
+                    continue;
+                }
+                if(IsDisconnectError(errno)){
+                    DisconnectLocked();
+                }
+                break;
+            }
+            sent += ret;
+            if((size_t)ret < n){
+                // 套接字发送缓冲已满，其余留待下次
+                break;
+            }
+        }
+        if(sent == 0){
+            return;
+        }
+        size_t consumed = m_datagrams[sent - 1].end;
+        m_buffer.erase(0, consumed);
+        m_datagrams.erase(m_datagrams.begin(), m_datagrams.begin() + sent);
+        for(Datagram& dgram : m_datagrams){
+            dgram.end -= consumed;
+        }
+    }
+
+    void SocketLoggerSink::SendStreamLocked(){
+        size_t sent = 0;
+        while(sent < m_buffer.size()){
+            ssize_t n = send(m_fd, m_buffer.data() + sent, m_buffer.size() - sent, SOCKET_SEND_FLAGS);
+            if(n < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                if(sent > 0){
+                    m_stream_partial = (m_buffer[sent - 1] != '\n');
+                    m_buffer.erase(0, sent);
+                    sent = 0;
+                }
+                if(IsDisconnectError(errno)){
+                    DisconnectLocked();
+                }
+                break;
+            }
+            sent += n;
+        }
+        if(sent > 0){
+            m_stream_partial = (m_buffer[sent - 1] != '\n');
+            m_buffer.erase(0, sent);
+        }
+    }
+
+    void SocketLoggerSink::EmergencyFlush(){
+        // 只发一次，不加锁(见FileLoggerSink::EmergencyFlush)
+        if(m_emergency_flushed.exchange(true)){
+            return;
+        }
+        int fd = m_fd;
+        size_t size = m_buffer.size();
+        if(fd < 0 || size == 0 || size > m_buffer.capacity()){
+            return;
+        }
+        const char* data = m_buffer.data();
+        if(!IsDatagram()){
+            send(fd, data, size, SOCKET_SEND_FLAGS);
+            return;
+        }
+        size_t begin = 0;
+        size_t count = m_datagrams.size();
+        for(size_t i = 0; i <= count; i++){
+            size_t end = (i < count ? m_datagrams[i].end : size);
+            if(end <= begin || end > size){
+                continue;
+            }
+            send(fd, data + begin, end - begin, SOCKET_SEND_FLAGS);
+            begin = end;
+        }
+    }
+
+    bool SocketLoggerSink::EmergencyWrite(const char* data, size_t len){
+        EmergencyFlush();
+        return m_fd >= 0 && send(m_fd, data, len, SOCKET_SEND_FLAGS) >= 0;
+    }
+} // namespace dysv
@@ -0,0 +1,441 @@
+#include <cerrno>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include "dysv/dy_uring_sink.hpp"
+#include "dysv/dy_crash_handler.hpp"
+#if DYSV_WITH_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+namespace dysv{
+    #define URING_RECORD_HEADROOM   4096    // 缓冲在buffer_size之外为最后一条记录留出的余量
+
+    static int64_t CoarseMonotonicMs(){
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    /**
+     * @brief 将[data, data+len)完整写入fd的offset处，处理EINTR与部分写。不申请内存，可在信号处理函数中使用。
+     *
+     */
+    static bool PwriteFully(int fd, const char* data, size_t len, uint64_t offset){
+        while(len > 0){
+            ssize_t n = pwrite(fd, data, len, (off_t)offset);
+            if(n < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            len -= n;
+            offset += n;
+        }
+        return true;
+    }
+
+    /*********************class IoUringFileLoggerSink**************************************/
+    IoUringFileLoggerSink::IoUringFileLoggerSink(const std::string& name, const std::string& file_name,
+                                                    const FileFlushPolicy& policy, size_t buffer_count)
+                                                    : LoggerSinkInterface(name), m_file_name(file_name), m_policy(policy),
+                                                      m_fd(-1), m_file_offset(0), m_current(0), m_in_flight(0),
+                                                      m_first_pending_ms(-1), m_submit_count(0),
+                                                      m_latency_timer(0), m_timers_closed(false),
+                                                      m_ring_fd(-1), m_sq_ring(nullptr), m_cq_ring(nullptr), m_sqes(nullptr),
+                                                      m_sq_ring_size(0), m_cq_ring_size(0), m_sqes_size(0),
+                                                      m_sq_tail(nullptr), m_sq_mask(nullptr), m_sq_array(nullptr),
+                                                      m_cq_head(nullptr), m_cq_tail(nullptr), m_cq_mask(nullptr), m_cqes(nullptr)
+    {
+        if(buffer_count < 2){
+            buffer_count = 2;
+        }
+        m_capacity = m_policy.buffer_size + URING_RECORD_HEADROOM;
+        m_pool.resize(m_capacity * buffer_count);
+        m_buffers = std::vector<Buffer>(buffer_count);
+        for(size_t i = 0; i < buffer_count; i++){
+            m_buffers[i].data = &m_pool[i * m_capacity];
+        }
+        // 0号为当前缓冲，其余空闲
+        for(size_t i = buffer_count; i-- > 1;){
+            m_free.push_back((uint32_t)i);
+        }
+
+        // 按偏移写入，不用O_APPEND：多个请求可同时在途，完成顺序不影响文件内容
+        m_fd = open(m_file_name.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+        struct stat st;
+        if(m_fd >= 0 && fstat(m_fd, &st) == 0){
+            m_file_offset = st.st_size;
+        }
+        if(m_fd >= 0){
+            SetupRing(buffer_count);
+        }
+        CrashHandler::Register(this);
+    }
+
+    IoUringFileLoggerSink::~IoUringFileLoggerSink(){
+        CrashHandler::Unregister(this);
+        TimerId timer;
+        {
+            std::lock_guard<std::mutex> lk(m_mutex);
+            m_timers_closed = true;
+            timer = m_latency_timer;
+            m_latency_timer = 0;
+        }
+        // 不持有m_mutex：回调可能正等待该锁
+        TimingWheel::Global().Cancel(timer);
+        std::lock_guard<std::mutex> lk(m_mutex);
+        SubmitCurrentLocked();
+        WaitInFlightLocked(0);
+        DestroyRing();
+        if(m_fd >= 0){
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    void IoUringFileLoggerSink::Sink(const std::string& content){
+        Sink(level::TRACE, content);
+    }
+
+    void IoUringFileLoggerSink::Sink(level::LevelEnum lv, const std::string& content){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        size_t record_size = content.size() + 1;
+        if(m_buffers[m_current].size + record_size > m_capacity){
+            SubmitCurrentLocked();
+        }
+        if(record_size > m_capacity){
+            // 放不进任何缓冲的超长记录：预留偏移后同步写出
+            uint64_t offset = m_file_offset;
+            m_file_offset += record_size;
+            if(m_fd < 0 || !PwriteFully(m_fd, content.data(), content.size(), offset)
+                || !PwriteFully(m_fd, "\n", 1, offset + content.size())){
+                CountDropped();
+            }
+            return;
+        }
+
+        Buffer& buf = m_buffers[m_current];
+        if(buf.size == 0){
+            m_first_pending_ms = m_policy.max_latency_ms > 0 ? CoarseMonotonicMs() : -1;
+        }
+        memcpy(buf.data + buf.size, content.data(), content.size());
+        buf.data[buf.size + content.size()] = '\n';
+        buf.size += record_size;
+        buf.records++;
+
+        bool need_submit = buf.size >= m_policy.buffer_size || lv >= m_policy.flush_level;
+        if(!need_submit && m_first_pending_ms >= 0){
+            need_submit = CoarseMonotonicMs() - m_first_pending_ms >= (int64_t)m_policy.max_latency_ms;
+        }
+        if(need_submit){
+            SubmitCurrentLocked();
+        }else if(m_first_pending_ms >= 0 && m_latency_timer == 0){
+            ArmLatencyTimerLocked(m_policy.max_latency_ms);
+        }
+    }
+
+    void IoUringFileLoggerSink::Flush(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        SubmitCurrentLocked();
+        WaitInFlightLocked(0);
+    }
+
+    const std::string& IoUringFileLoggerSink::GetFileName() const{
+        return m_file_name;
+    }
+
+    bool IoUringFileLoggerSink::IsUringEnabled() const{
+        return m_ring_fd >= 0;
+    }
+
+    uint64_t IoUringFileLoggerSink::GetSubmitCount(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        return m_submit_count;
+    }
+
+    void IoUringFileLoggerSink::SubmitCurrentLocked(){
+        Buffer& buf = m_buffers[m_current];
+        if(buf.size == 0){
+            return;
+        }
+        buf.offset = m_file_offset;
+        buf.done = 0;
+        m_file_offset += buf.size;
+        m_first_pending_ms = -1;
+        m_submit_count++;
+
+        // 顺便收割已完成的请求，尽量不在下面等待。收割中重新提交失败时环已关闭，改走同步写
+        if(m_ring_fd >= 0){
+            ReapLocked();
+        }
+        if(m_ring_fd < 0){
+            // 未启用io_uring：同步写出，当前缓冲原地复用
+            if(m_fd < 0 || !PwriteFully(m_fd, buf.data, buf.size, buf.offset)){
+                CountDropped(buf.records);
+            }
+            buf.size = 0;
+            buf.records = 0;
+            return;
+        }
+
+        buf.in_flight.store(true, std::memory_order_release);
+        m_in_flight++;
+        QueueWriteLocked(m_current);
+        if(EnterLocked(1, 0) != 0){
+            // 提交失败时AbandonRingLocked已把所有缓冲(包括这一个)同步写出并归还
+            AbandonRingLocked();
+        }else if(m_free.empty()){
+            WaitInFlightLocked(m_buffers.size() - 1);
+        }
+        m_current = m_free.back();
+        m_free.pop_back();
+    }
+
+    void IoUringFileLoggerSink::ArmLatencyTimerLocked(int64_t delay_ms){
+        if(m_timers_closed){
+            return;
+        }
+        m_latency_timer = TimingWheel::Global().Add((uint32_t)std::max<int64_t>(delay_ms, 1), [this]{ OnLatencyTimer(); });
+    }
+
+    void IoUringFileLoggerSink::OnLatencyTimer(){
+        std::lock_guard<std::mutex> lk(m_mutex);
+        m_latency_timer = 0;
+        if(m_buffers[m_current].size == 0 || m_first_pending_ms < 0){
+            return;
+        }
+        int64_t age = CoarseMonotonicMs() - m_first_pending_ms;
+        if(age >= (int64_t)m_policy.max_latency_ms){
+            // 只提交不等待完成，时间轮线程不等磁盘(缓冲全部在途时除外)
+            SubmitCurrentLocked();
+        }else{
+            ArmLatencyTimerLocked(m_policy.max_latency_ms - age);
+        }
+    }
+
+    void IoUringFileLoggerSink::RecycleLocked(uint32_t index, bool ok){
+        Buffer& buf = m_buffers[index];
+        if(!ok){
+            CountDropped(buf.records);
+        }
+        buf.size = 0;
+        buf.done = 0;
+        buf.records = 0;
+        buf.in_flight.store(false, std::memory_order_release);
+        m_in_flight--;
+        m_free.push_back(index);
+    }
+
+    void IoUringFileLoggerSink::AbandonRingLocked(){
+        // 先关闭环再重写：无法确定哪些请求已被内核接收，在途缓冲按原偏移同步写出剩余部分(已写过的内容相同)
+        DestroyRing();
+        for(uint32_t i = 0; i < m_buffers.size(); i++){
+            Buffer& buf = m_buffers[i];
+            if(!buf.in_flight.load(std::memory_order_acquire)){
+                continue;
+            }
+            bool ok = m_fd >= 0 && PwriteFully(m_fd, buf.data + buf.done, buf.size - buf.done, buf.offset + buf.done);
+            RecycleLocked(i, ok);
+        }
+    }
+
+    void IoUringFileLoggerSink::EmergencyFlush(){
+        // 只写出一次，不加锁(见FileLoggerSink::EmergencyFlush)。
+        // 在途的缓冲按原偏移重写：若内核已写完，写入的内容相同
+        if(m_emergency_flushed.exchange(true) || m_fd < 0){
+            return;
+        }
+        for(Buffer& buf : m_buffers){
+            if(buf.in_flight.load(std::memory_order_acquire) && buf.size <= m_capacity){
+                PwriteFully(m_fd, buf.data, buf.size, buf.offset);
+            }
+        }
+        Buffer& cur = m_buffers[m_current];
+        if(!cur.in_flight.load(std::memory_order_acquire) && cur.size > 0 && cur.size <= m_capacity){
+            PwriteFully(m_fd, cur.data, cur.size, m_file_offset);
+            m_file_offset += cur.size;
+        }
+    }
+
+    bool IoUringFileLoggerSink::EmergencyWrite(const char* data, size_t len){
+        EmergencyFlush();
+        if(m_fd < 0 || !PwriteFully(m_fd, data, len, m_file_offset)){
+            return false;
+        }
+        m_file_offset += len;
+        return true;
+    }
+
+#if DYSV_WITH_IO_URING
+    bool IoUringFileLoggerSink::SetupRing(size_t entries){
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        int ring_fd = (int)syscall(__NR_io_uring_setup, (unsigned)entries, &params);
+        if(ring_fd < 0){
+            // 内核不支持或被禁用(ENOSYS/EPERM)，退化为同步写
+            return false;
+        }
+        m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if(single_mmap){
+            m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+        }
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+        void* sq_ring = mmap(nullptr, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                ring_fd, IORING_OFF_SQ_RING);
+        void* cq_ring = single_mmap ? sq_ring
+                                    : mmap(nullptr, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                            ring_fd, IORING_OFF_CQ_RING);
+        void* sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring_fd, IORING_OFF_SQES);
+        m_ring_fd = ring_fd;
+        m_sq_ring = (sq_ring == MAP_FAILED ? nullptr : sq_ring);
+        m_cq_ring = (cq_ring == MAP_FAILED ? nullptr : cq_ring);
+        m_sqes = (sqes == MAP_FAILED ? nullptr : sqes);
+        if(m_sq_ring == nullptr || m_cq_ring == nullptr || m_sqes == nullptr){
+            DestroyRing();
+            return false;
+        }
+
+        char* sq = (char*)m_sq_ring;
+        char* cq = (char*)m_cq_ring;
+        m_sq_tail = (unsigned*)(sq + params.sq_off.tail);
+        m_sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+        m_sq_array = (unsigned*)(sq + params.sq_off.array);
+        m_cq_head = (unsigned*)(cq + params.cq_off.head);
+        m_cq_tail = (unsigned*)(cq + params.cq_off.tail);
+        m_cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+        m_cqes = cq + params.cq_off.cqes;
+        return true;
+    }
+
+    void IoUringFileLoggerSink::DestroyRing(){
+        if(m_sqes != nullptr){
+            munmap(m_sqes, m_sqes_size);
+        }
+        if(m_cq_ring != nullptr && m_cq_ring != m_sq_ring){
+            munmap(m_cq_ring, m_cq_ring_size);
+        }
+        if(m_sq_ring != nullptr){
+            munmap(m_sq_ring, m_sq_ring_size);
+        }
+        m_sqes = m_cq_ring = m_sq_ring = nullptr;
+        // 置空指向环内的指针，关闭后的误用直接崩在空指针上，而不是写进已解除映射的内存
+        m_sq_tail = m_sq_mask = m_sq_array = nullptr;
+        m_cq_head = m_cq_tail = m_cq_mask = nullptr;
+        m_cqes = nullptr;
+        if(m_ring_fd >= 0){
+            close(m_ring_fd);
+            m_ring_fd = -1;
+        }
+    }
+
+    void IoUringFileLoggerSink::QueueWriteLocked(uint32_t index){
+        Buffer& buf = m_buffers[index];
+        // 提交队列只由持锁的线程写入，在途请求数不超过缓冲个数，队列不会满
+        unsigned tail = *m_sq_tail;
+        unsigned slot = tail & *m_sq_mask;
+        io_uring_sqe* sqe = (io_uring_sqe*)m_sqes + slot;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_WRITE;
+        sqe->fd = m_fd;
+        sqe->addr = (uint64_t)(uintptr_t)(buf.data + buf.done);
+        sqe->len = (uint32_t)(buf.size - buf.done);
+        sqe->off = buf.offset + buf.done;
+        sqe->user_data = index;
+        m_sq_array[slot] = slot;
+        __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    int IoUringFileLoggerSink::EnterLocked(uint32_t to_submit, uint32_t min_complete){
+        unsigned flags = (min_complete > 0 ? IORING_ENTER_GETEVENTS : 0);
+        for(;;){
+            int ret = (int)syscall(__NR_io_uring_enter, m_ring_fd, to_submit, min_complete, flags, nullptr, 0);
+            if(ret >= 0){
+                if((uint32_t)ret >= to_submit){
+                    return 0;
+                }
+                to_submit -= ret;
+                continue;
+            }
+            if(errno == EINTR){
+                continue;
+            }
+            if(errno == EAGAIN || errno == EBUSY){
+                // 内核暂时无法接收(完成队列将满等)，让出后重试
+                sched_yield();
+                continue;
+            }
+            return errno;
+        }
+    }
+
+    size_t IoUringFileLoggerSink::ReapLocked(){
+        unsigned head = *m_cq_head;
+        unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+        size_t reaped = 0;
+        uint32_t resubmit = 0;
+        for(; head != tail; head++, reaped++){
+            const io_uring_cqe* cqe = (const io_uring_cqe*)m_cqes + (head & *m_cq_mask);
+            uint32_t index = (uint32_t)cqe->user_data;
+            int res = cqe->res;
+            Buffer& buf = m_buffers[index];
+            if(res > 0){
+                buf.done += res;
+                if(buf.done < buf.size){
+                    // 短写：续写剩余部分
+                    QueueWriteLocked(index);
+                    resubmit++;
+                }else{
+                    RecycleLocked(index, true);
+                }
+            }else if(res == -EINTR || res == -EAGAIN){
+                QueueWriteLocked(index);
+                resubmit++;
+            }else{
+                // 出错(或内核不支持IORING_OP_WRITE)：同步重试一次
+                bool ok = PwriteFully(m_fd, buf.data + buf.done, buf.size - buf.done, buf.offset + buf.done);
+                RecycleLocked(index, ok);
+            }
+        }
+        __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+        if(resubmit > 0 && EnterLocked(resubmit, 0) != 0){
+            AbandonRingLocked();
+        }
+        return reaped;
+    }
+
+    void IoUringFileLoggerSink::WaitInFlightLocked(size_t limit){
+        while(m_in_flight > limit){
+            if(ReapLocked() == 0 && EnterLocked(0, 1) != 0){
+                AbandonRingLocked();
+            }
+        }
+    }
+#else
+    // 编译时未启用io_uring：始终同步写出
+    bool IoUringFileLoggerSink::SetupRing(size_t entries){
+        return false;
+    }
+
+    void IoUringFileLoggerSink::DestroyRing(){}
+
+    void IoUringFileLoggerSink::QueueWriteLocked(uint32_t index){}
+
+    int IoUringFileLoggerSink::EnterLocked(uint32_t to_submit, uint32_t min_complete){
+        return 0;
+    }
+
+    size_t IoUringFileLoggerSink::ReapLocked(){
+        return 0;
+    }
+
+    void IoUringFileLoggerSink::WaitInFlightLocked(size_t limit){}
+#endif
+} // namespace dysv
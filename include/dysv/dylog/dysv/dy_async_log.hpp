@@ -0,0 +1,255 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "dy_log.hpp"
+#include "../common/dy_ring_buffer.hpp"
+
+/**
+ * @brief 异步日志器。
+ * @feature 生产者只将记录拷贝进预分配的无锁环形队列，由唯一的后台线程完成模式化与sink落地;
+ *          析构/Stop()时排空队列; Flush()阻塞至调用前的所有记录落地。
+ * @example
+ *      auto lg = std::make_shared<dysv::AsyncLogger>("async", dysv::level::INFO, DEFAULT_PATTERN_STR);
+ *      lg->AddSink(std::make_shared<dysv::FileLoggerSink>("file", "./async.txt"));
+ *      lg->Logf(ADD_ADDITION_INFO, dysv::level::INFO, "hello %s", "async");
+ *      lg->Flush();    // 此前的日志均已写入文件
+ * @feature ShardedAsyncLogger: 每个生产者线程独占一个SPSC分片，线程之间不共享任何写入的缓存行;
+ *          后台线程按时间戳k路归并各分片，落地顺序与时间戳全局有序。
+ * @feature 背压策略(BackpressureConfig): 队列满或超过高水位时阻塞/丢弃最新/丢弃低优先级/采样，
+ *          丢弃的条数在队列排空后以一条"N records dropped"的WARN日志报告。
+ * @example
+ *      auto lg = std::make_shared<dysv::ShardedAsyncLogger>("sharded", dysv::level::INFO, DEFAULT_PATTERN_STR);
+ *      lg->AddSink(std::make_shared<dysv::FileLoggerSink>("file", "./sharded.txt"));
+ *      dysv::BackpressureConfig bp;
+ *      bp.policy = dysv::BACKPRESSURE_DROP_LOW_PRIORITY;   // 高水位以上只接收ERROR及以上
+ *      lg->SetBackpressure(bp);
+ */
+
+namespace dysv
+{
+#define DEFAULT_ASYNC_QUEUE_SIZE        8192    // 默认队列槽位数
+#define ASYNC_BACKEND_IDLE_WAIT_MS      10      // 后台线程空闲时的最长休眠时间
+#define ASYNC_RECORD_RESERVE_SIZE       128     // 每个槽位预留的日志内容容量
+#define DEFAULT_SHARD_QUEUE_SIZE        2048    // 默认每个分片的槽位数
+#define DEFAULT_MAX_SHARDS              64      // 默认最多的独占分片数，超出的线程共用一个加锁的分片
+#define DEFAULT_BACKPRESSURE_HIGH_WATERMARK 75  // 默认高水位(队列占用百分比)
+#define DEFAULT_BACKPRESSURE_SAMPLE_RATE    10  // 默认采样率，每N条保留1条
+
+    /**
+     * @brief 队列写满或积压时的处理策略。不低于keep_level的记录在DROP_LOW_PRIORITY与SAMPLE下不会被丢弃。
+     *
+     */
+    enum BackpressurePolicy{
+        BACKPRESSURE_BLOCK = 0,             // 队列满时生产者等待后台线程腾出槽位(默认)
+        BACKPRESSURE_DROP_NEWEST,           // 队列满时丢弃当前记录
+        BACKPRESSURE_DROP_LOW_PRIORITY,     // 超过高水位时丢弃低于keep_level的记录，其余记录在队列满时等待
+        BACKPRESSURE_SAMPLE,                // 超过高水位时低于keep_level的记录每线程每sample_rate条保留1条，队列满时丢弃
+    };
+
+    struct BackpressureConfig{
+        BackpressurePolicy  policy = BACKPRESSURE_BLOCK;
+        level::LevelEnum    keep_level = level::ERROR;
+        uint32_t            high_watermark = DEFAULT_BACKPRESSURE_HIGH_WATERMARK;   // 队列占用百分比
+        uint32_t            sample_rate = DEFAULT_BACKPRESSURE_SAMPLE_RATE;
+    };
+
+    /**
+     * @brief 背压判定，异步日志器在入队前与队列满时调用。配置各字段为relaxed原子量，可在运行中切换;
+     *        采样计数为线程内变量，生产者之间不共享状态。
+     *
+     */
+    class Backpressure
+    {
+    public:
+        explicit Backpressure(const BackpressureConfig& config = BackpressureConfig());
+        void Set(const BackpressureConfig& config);
+        BackpressureConfig Get() const;
+        // 是否需要按队列占用判定，为false时生产者无需读取队列深度
+        bool UsesWatermark() const{
+            BackpressurePolicy policy = m_policy.load(std::memory_order_relaxed);
+            return policy == BACKPRESSURE_DROP_LOW_PRIORITY || policy == BACKPRESSURE_SAMPLE;
+        }
+        // 入队前：队列占用为depth/capacity时，是否直接丢弃该记录
+        bool DropBeforePush(level::LevelEnum lv, size_t depth, size_t capacity) const;
+        // 队列已满：true表示丢弃，false表示等待
+        bool DropWhenFull(level::LevelEnum lv) const;
+        // 当前策略名，用于丢弃报告
+        const char* PolicyName() const;
+        static const char* PolicyName(BackpressurePolicy policy);
+    private:
+        std::atomic<BackpressurePolicy>     m_policy;
+        std::atomic<level::LevelEnum>       m_keep_level;
+        std::atomic<uint32_t>               m_high_watermark;
+        std::atomic<uint32_t>               m_sample_rate;
+    };
+
+    /**
+     * @brief 异步日志器。所有生产者共用一个MPSC队列。
+     *
+     */
+    class AsyncLogger : public Logger
+    {
+    public:
+        using ptr = std::shared_ptr<AsyncLogger>;
+        AsyncLogger(const std::string &name, size_t queue_size = DEFAULT_ASYNC_QUEUE_SIZE);
+        AsyncLogger(const std::string &name, level::LevelEnum lv, const std::string& pt,
+                        size_t queue_size = DEFAULT_ASYNC_QUEUE_SIZE);
+        ~AsyncLogger() override;
+
+        // 仅做级别过滤与入队，队列满时自旋等待后台线程腾出槽位
+        void LogImpl(const LogAdditionInfo* other_info,
+                        level::LevelEnum lv,
+                        std::string_view org_str) override;
+
+        // 阻塞直到调用前入队的记录全部落地，并刷新所有sink
+        void Flush() override;
+
+        // 排空队列后停止后台线程。此后的日志退化为同步落地
+        void Stop();
+
+        // 队列中尚未落地的记录数(近似值)
+        size_t GetQueueDepth() const override;
+        // 崩溃时将队列中尚未取出的记录直接写给各sink
+        void EmergencyDrain() override;
+
+        // 背压策略，可在运行中切换
+        void SetBackpressure(const BackpressureConfig& config);
+        BackpressureConfig GetBackpressure() const;
+    private:
+        /**
+         * @brief 队列槽位。info可平凡拷贝；content的容量在槽位复用时保留，稳定后拷贝不再申请内存。
+         *
+         */
+        struct Record{
+            Record(){ content.reserve(ASYNC_RECORD_RESERVE_SIZE); }
+            bool                has_info = false;
+            LogAdditionInfo     info;
+            level::LevelEnum    lv = level::UNKNOW;
+            std::string         content;
+        };
+
+        void Start();
+        void BackendLoop();
+        void WakeBackend();
+
+        MpscRingBuffer<Record>      m_queue;
+        Backpressure                m_backpressure;
+        std::thread                 m_backend;
+        std::atomic<bool>           m_running;
+        std::atomic<bool>           m_stop;
+        std::atomic<bool>           m_backend_sleeping;
+        alignas(DYSV_CACHE_LINE_SIZE) std::atomic<size_t> m_pushing;  // 已通过m_running检查、尚未结束入队的生产者数
+
+        std::mutex                  m_mutex;
+        std::condition_variable     m_backend_cv;   // 唤醒后台线程
+        std::condition_variable     m_flush_cv;     // 通知Flush调用者
+        size_t                      m_flush_target; // 需要落地并刷新至的队列位置
+        size_t                      m_flushed;      // 已刷新至的队列位置
+    };
+
+    /**
+     * @brief 分片异步日志器。线程首次打印日志时认领一个独占的SPSC分片，线程退出后分片交给新线程复用;
+     *        独占分片用尽后，其余线程共用一个以互斥锁串行化的分片。
+     *        入队时重新打时间戳(记录的时间为入队时刻)，后台线程以"水位"为界按时间戳归并：
+     *        生产者在取时间戳之前先登记"入队中"，后台每轮先取当前时间，再取各分片登记值的最小者为水位，
+     *        只落地不晚于水位的记录，之后任何分片都不会再出现更早的记录。
+     *        归并用的时间戳取自CLOCK_MONOTONIC，不受系统时间调整影响; 输出中显示的仍是墙上时间。
+     *
+     */
+    class ShardedAsyncLogger : public Logger
+    {
+    public:
+        using ptr = std::shared_ptr<ShardedAsyncLogger>;
+        ShardedAsyncLogger(const std::string &name,
+                            size_t shard_queue_size = DEFAULT_SHARD_QUEUE_SIZE,
+                            size_t max_shards = DEFAULT_MAX_SHARDS);
+        ShardedAsyncLogger(const std::string &name, level::LevelEnum lv, const std::string& pt,
+                            size_t shard_queue_size = DEFAULT_SHARD_QUEUE_SIZE,
+                            size_t max_shards = DEFAULT_MAX_SHARDS);
+        ~ShardedAsyncLogger() override;
+
+        // 级别过滤、打时间戳并写入本线程的分片，分片满时自旋等待后台线程腾出槽位
+        void LogImpl(const LogAdditionInfo* other_info,
+                        level::LevelEnum lv,
+                        std::string_view org_str) override;
+
+        // 阻塞直到调用前入队的记录全部落地，并刷新所有sink
+        void Flush() override;
+
+        // 排空所有分片后停止后台线程。此后的日志退化为同步落地
+        void Stop();
+
+        // 各分片中尚未落地的记录数之和(近似值)
+        size_t GetQueueDepth() const override;
+        // 已创建的分片数(含共用分片)
+        size_t GetShardCount() const;
+        // 崩溃时将各分片中尚未取出的记录逐个分片写给各sink(不再按时间归并)
+        void EmergencyDrain() override;
+
+        // 背压策略，按各分片自身的占用判定，可在运行中切换
+        void SetBackpressure(const BackpressureConfig& config);
+        BackpressureConfig GetBackpressure() const;
+    private:
+        struct Record{
+            Record(){ content.reserve(ASYNC_RECORD_RESERVE_SIZE); }
+            uint64_t            time_ns = 0;    // 归并依据(CLOCK_MONOTONIC)，info中的时间为墙上时间，仅供显示
+            bool                has_info = false;
+            LogAdditionInfo     info;
+            level::LevelEnum    lv = level::UNKNOW;
+            std::string         content;
+        };
+
+        /**
+         * @brief 一个分片。inflight为生产者正在入队的记录的时间戳：0表示空闲，1表示已登记但尚未取得时间戳。
+         *
+         */
+        struct Shard{
+            explicit Shard(size_t queue_size) : queue(queue_size){}
+            SpscRingBuffer<Record>  queue;
+            alignas(DYSV_CACHE_LINE_SIZE) std::atomic<uint64_t> inflight{0};
+            std::atomic<bool>       owned{false};   // 是否已被某个线程独占
+            bool                    shared = false; // 是否为多个线程共用的分片
+        };
+
+        // 当前线程在本日志器上的分片，首次调用时认领
+        Shard* GetThreadShard();
+        Shard* ClaimShard();
+        void Push(Shard* shard, const LogAdditionInfo* other_info, level::LevelEnum lv, std::string_view org_str);
+
+        void Start();
+        void BackendLoop();
+        void WakeBackend();
+        // 计算本轮的水位并归并落地至多max_records条，返回落地条数
+        size_t MergeRound(size_t max_records, bool unbounded);
+        bool AllShardsEmpty() const;
+        // 各分片的出队数是否均已达到m_flush_targets
+        bool FlushTargetsReachedLocked() const;
+
+        const uint64_t              m_id;           // 进程内唯一，用于线程内缓存的分片查找
+        const size_t                m_shard_queue_size;
+        const size_t                m_max_shards;
+        Backpressure                m_backpressure;
+        std::vector<std::shared_ptr<Shard>>     m_shard_holders;    // [0, m_max_shards)为独占分片，最后一个为共用分片
+        std::vector<std::atomic<Shard*>>        m_shards;
+        std::atomic<size_t>         m_shard_count;  // m_shards中已发布的分片数
+        std::mutex                  m_claim_mutex;
+        std::mutex                  m_shared_mutex; // 串行化共用分片的生产者
+        size_t                      m_shared_index; // 共用分片在m_shards中的下标，尚未创建时为SIZE_MAX
+        std::vector<std::pair<uint64_t, Shard*>>    m_heap;     // 后台归并用的小顶堆(时间戳, 分片)
+
+        std::thread                 m_backend;
+        std::atomic<bool>           m_running;
+        std::atomic<bool>           m_stop;
+        std::atomic<bool>           m_backend_sleeping;
+
+        std::mutex                  m_mutex;
+        std::condition_variable     m_backend_cv;
+        std::condition_variable     m_flush_cv;
+        std::vector<size_t>         m_flush_targets;    // 各分片需落地至的出队数
+        uint64_t                    m_flush_gen;        // 已提交的Flush请求数
+        uint64_t                    m_flushed_gen;      // 已完成的Flush请求数
+    };
+} // namespace dysv
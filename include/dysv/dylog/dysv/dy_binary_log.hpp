@@ -0,0 +1,142 @@
+#pragma once
+#include <mutex>
+#include <string>
+#include <vector>
+#include "dy_log.hpp"
+
+/**
+ * @brief 二进制延迟格式化日志。
+ * @feature DY_LOG_FMT_*与DY_LOGF_*的每个调用点首次执行时注册静态id(见LogSite); 日志器设置BinaryLogWriter后，
+ *          每条记录只写调用点id、原始时间戳、线程id与参数的原始字节，格式化与模式化推迟到离线解码(dysv_log_decode)。
+ *          文件自描述：文件头记录日志器的模式串，调用点定义帧在每个文件中首次用到时写入一次。
+ * @example
+ *      auto writer = std::make_shared<dysv::BinaryLogWriter>("./app.dybl");
+ *      DEFAULT_LOGGER->SetBinaryWriter(writer);
+ *      DY_LOGF_INFO("request {} served in {} us", id, cost);
+ *      // $ dysv_log_decode app.dybl                  按文件头中的模式串输出文本
+ *      // $ dysv_log_decode -p "[%P][%C]" app.dybl    按指定的模式串输出
+ * @format 整数均为本机字节序
+ *      文件头帧:   'H' "DYBL" u16版本 u32长度+模式串 u32长度+日志器名
+ *      调用点帧:   'S' u32id u8级别 u8风格 u32行号 u8参数个数 u8类型*n u32长度+文件名 u32长度+函数名 u32长度+格式串
+ *      记录帧:     'R' u32id u64纳秒时间戳 u32线程id u32参数字节数 参数
+ *          参数按调用点帧中的类型依次存放: 整数/浮点/指针按类型宽度原样存储，字符串为u32长度+字节。
+ */
+
+namespace dysv
+{
+#define BINARY_LOG_MAGIC            "DYBL"
+#define BINARY_LOG_VERSION          1
+#define BINARY_FRAME_HEADER         'H'
+#define BINARY_FRAME_SITE           'S'
+#define BINARY_FRAME_RECORD         'R'
+
+    /**
+     * @brief 二进制日志写入器。记录编码进用户态缓冲，按FileFlushPolicy通过O_APPEND的fd成块写出。
+     *        同一文件可被多次追加写入，每次打开都会重新写入文件头与调用点定义。
+     *
+     */
+    class BinaryLogWriter
+    {
+    public:
+        using ptr = std::shared_ptr<BinaryLogWriter>;
+        BinaryLogWriter(const std::string& file_name, const FileFlushPolicy& policy = FileFlushPolicy());
+        ~BinaryLogWriter();
+
+        // 编码一条记录。args由Logger::LogAt构造
+        void Write(const LogSite& site, const BinaryArg* args, size_t nargs);
+        void Flush();
+        // 崩溃时不加锁地写出缓冲(异步信号安全)
+        void EmergencyFlush();
+        bool Reopen();
+        // 写入文件头的日志器名与默认模式串，由Logger::SetBinaryWriter设置
+        void SetSource(const std::string& logger_name, const std::string& pattern);
+        const std::string& GetFileName() const;
+    private:
+        void AppendHeaderLocked();
+        void AppendSiteLocked(const LogSite& site, const BinaryArg* args, size_t nargs);
+        void AppendArgLocked(const BinaryArg& arg);
+        void WriteBufferLocked();
+        // 保证缓冲在m_used之后还能容纳len字节，返回写入位置
+        char* ReserveLocked(size_t len);
+        template<class T>
+        void PutLocked(const T& val);
+        // u32长度 + 字节
+        void PutBytesLocked(const char* data, size_t len);
+        // 同FileLoggerSink：缓冲由空变为非空时在全局时间轮上挂max_latency_ms后的定时器，到期时写出
+        void ArmLatencyTimerLocked(int64_t delay_ms);
+        void OnLatencyTimer();
+
+        std::mutex              m_mutex;
+        int                     m_fd;
+        std::string             m_buffer;           // 预先分配的存储，有效数据为[0, m_used)
+        size_t                  m_used;
+        std::string             m_scratch;          // 渲染自定义类型参数
+        std::vector<uint8_t>    m_defined;          // 以调用点id为下标，本文件中是否已写入定义
+        bool                    m_header_written;
+        int64_t                 m_first_pending_ms; // 缓冲中最早一条记录的时刻，缓冲为空时为-1
+        TimerId                 m_latency_timer;    // 挂起中的延迟写出定时器，0表示没有
+        bool                    m_timers_closed;    // 析构中，定时器回调不再续期
+        std::string             m_file_name;
+        std::string             m_logger_name;
+        std::string             m_pattern;
+        FileFlushPolicy         m_policy;
+    };
+
+    /**
+     * @brief 二进制日志解码器。增量解析，数据可分块传入; 遇到新的文件头时丢弃此前的调用点定义。
+     *
+     */
+    class BinaryLogDecoder
+    {
+    public:
+        // pattern为空时使用文件头中记录的模式串
+        explicit BinaryLogDecoder(const std::string& pattern = "");
+
+        /**
+         * @brief 解析[data, data+len)中的完整帧，每条记录按模式串渲染为一行追加到out。
+         * @return size_t 已消费的字节数。末尾不完整的帧需与后续数据拼接后再次传入
+         */
+        size_t Decode(const char* data, size_t len, std::string& out);
+        // 遇到无法识别的帧时置位，此后不再解析
+        bool IsBroken() const;
+        uint64_t GetRecordCount() const;
+    private:
+        struct Site{
+            level::LevelEnum            lv;
+            LogSite::FormatStyle        style;
+            uint64_t                    line_num;
+            std::vector<BinaryArgType>  types;
+            std::string                 file_name;
+            std::string                 func_name;
+            std::string                 fmt;
+        };
+
+        // 解码后的参数，按type取对应的成员
+        struct Value{
+            BinaryArgType       type;
+            bool                b;
+            char                c;
+            int64_t             i;
+            uint64_t            u;
+            double              f;
+            const void*         p;
+            std::string_view    s;
+        };
+
+        // 以下返回0表示数据不完整
+        size_t DecodeHeader(const char* data, size_t len);
+        size_t DecodeSite(const char* data, size_t len);
+        size_t DecodeRecord(const char* data, size_t len, std::string& out);
+        bool DecodeArgs(const Site& site, const char* data, size_t len);
+        void RenderContent(const Site& site, std::string& out);
+
+        std::string                         m_fixed_pattern;
+        LoggerPattern                       m_pattern;
+        std::vector<std::unique_ptr<Site>>  m_sites;    // 以调用点id为下标
+        std::vector<Value>                  m_values;
+        std::vector<fmt::ArgRef>            m_refs;
+        std::string                         m_content;
+        bool                                m_broken;
+        uint64_t                            m_records;
+    };
+} // namespace dysv
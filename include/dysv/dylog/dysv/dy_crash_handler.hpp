@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <csignal>
+#include <string_view>
+#include "dy_log.hpp"
+
+/**
+ * @brief 崩溃时的日志排空(可选开启)。
+ * @feature 接管SIGSEGV/SIGABRT/SIGBUS/SIGFPE/SIGILL：信号处理函数只用write(2)把尚未落地的日志写到各sink已打开的fd,
+ *          包括异步日志器队列中尚未被后台线程取出的记录、FileLoggerSink与BinaryLogWriter用户态缓冲中的内容，
+ *          然后恢复原先的处理方式并重新发出该信号(照常产生core或交给原处理函数);
+ *          FATAL记录在调用返回前同步落地并刷新该日志器的所有sink(异步日志器等待后台线程写出);
+ *          日志器与文件sink在构造时登记到固定大小的无锁表中，开启前创建的对象同样受保护。
+ * @note 信号处理函数不加锁、不申请内存，对崩溃时正被其他线程修改的缓冲只能尽力而为(可能重复或缺失一条记录);
+ *       队列中的记录以默认模式串的格式输出(不含结构化字段)，ShardedAsyncLogger按分片依次输出，不再按时间归并;
+ *       备用信号栈只为调用Install的线程设置，其他线程栈溢出时无法排空。
+ * @example
+ *      dysv::CrashHandler::Install();      // main开头调用一次，之后可放心使用缓冲写与异步日志器
+ *      auto lg = std::make_shared<dysv::AsyncLogger>("async", dysv::level::INFO, DEFAULT_PATTERN_STR);
+ *      lg->AddSink(std::make_shared<dysv::FileLoggerSink>("file", "./app.log"));
+ *      ...
+ *      *(volatile int*)nullptr = 0;        // app.log中保留崩溃前的全部日志，随后照常产生core
+ */
+
+namespace dysv
+{
+#define CRASH_MAX_LOGGERS           64          // 可登记的日志器个数，超出的不受保护
+#define CRASH_MAX_SINKS             256         // 可登记的sink个数，超出的不受保护
+#define CRASH_RECORD_BUFFER_SIZE    4096        // 崩溃时单条记录的最大长度，超出部分截断
+#define CRASH_ALT_STACK_SIZE        (64 * 1024) // 默认备用信号栈大小
+
+    struct CrashHandlerConfig{
+        bool        handle_signals = true;                  // 接管崩溃信号
+        bool        flush_on_fatal = true;                  // FATAL记录在调用返回前落地并刷新该日志器的所有sink
+        size_t      alt_stack_size = CRASH_ALT_STACK_SIZE;  // 备用信号栈(栈溢出时仍能运行处理函数)，0表示不设置
+    };
+
+    /**
+     * @brief 崩溃处理。均为静态接口，进程内唯一。
+     *
+     */
+    class CrashHandler
+    {
+    public:
+        // 开启。重复调用时以最后一次的配置为准
+        static bool Install(const CrashHandlerConfig& config = CrashHandlerConfig());
+        // 恢复原先的信号处理方式
+        static void Uninstall();
+        static bool IsInstalled();
+        static bool FlushOnFatal(){
+            return s_flush_on_fatal.load(std::memory_order_relaxed);
+        }
+        // 是否已开始排空。异步日志器的后台线程据此停止消费，避免与排空重复写出
+        static bool IsDraining(){
+            return s_draining.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 异步信号安全：把所有已登记日志器与sink中尚未落地的内容直接写入各自的fd。
+         *        可在自定义的信号处理函数中调用; 调用后日志器的状态不再可靠，只应随后终止进程。
+         *
+         */
+        static void Drain();
+
+        // 由日志器与sink在构造/析构时调用。表满时不登记
+        static void Register(Logger* logger);
+        static void Unregister(Logger* logger);
+        static void Register(LoggerSinkInterface* sink);
+        static void Unregister(LoggerSinkInterface* sink);
+
+        /**
+         * @brief 异步信号安全：按默认模式串的格式把一条记录渲染到buf(含换行)，返回字节数。
+         *        other_info为空时只输出内容; 内容中的结构化字段区不输出。
+         *
+         */
+        static size_t FormatRecord(char* buf, size_t cap, const LogAdditionInfo* other_info,
+                                    level::LevelEnum lv, std::string_view content);
+    private:
+        static void SignalHandler(int sig, siginfo_t* info, void* context);
+
+        static std::atomic<bool>    s_flush_on_fatal;
+        static std::atomic<bool>    s_draining;
+    };
+} // namespace dysv
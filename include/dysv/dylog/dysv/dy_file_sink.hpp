@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "dy_log.hpp"
+
+/**
+ * @brief 扩展的文件sink。
+ * @feature RotatingFileLoggerSink: 按大小/按本地时间周期轮转，保留N个历史文件;
+ *          下一个文件由后台线程提前打开并fallocate，轮转时写线程只做一次fd交换;
+ *          按时间轮转由全局时间轮(../common/dy_timing_wheel.hpp)上的定时器触发，写记录时不再读时钟，没有记录时也按时轮转。
+ * @example
+ *      dysv::RotatePolicy rp;
+ *      rp.max_file_size = 64 * 1024 * 1024;    // 64MB一个文件
+ *      rp.interval_sec = 24 * 3600;            // 每天零点轮转
+ *      rp.max_files = 7;                       // 保留app.log.1 ~ app.log.7
+ *      ADD_SINK(std::make_shared<dysv::RotatingFileLoggerSink>("rotate", "./app.log", rp));
+ * @feature MmapFileLoggerSink: 写线程通过原子fetch_add预留偏移后直接memcpy进映射区，不加锁、不进系统调用;
+ *          段写满时由第一个越界的写线程映射下一段。已写入的内容位于page cache，进程崩溃不会丢失。
+ * @example
+ *      ADD_SINK(std::make_shared<dysv::MmapFileLoggerSink>("mmap", "./app.log", 32 * 1024 * 1024));
+ */
+
+namespace dysv
+{
+#define DEFAULT_ROTATE_MAX_FILES        5
+#define ROTATE_NEXT_SEGMENT_SUFFIX      ".next"             // 预先准备的下一个文件的后缀
+#define ROTATE_MAX_PREALLOC_SIZE        (256 * 1024 * 1024) // 单个文件最多预分配的字节数
+#define DEFAULT_MMAP_SEGMENT_SIZE       (16 * 1024 * 1024)  // mmap sink默认每段映射的字节数
+#define MMAP_MIN_SEGMENT_SIZE           (64 * 1024)         // mmap sink每段映射的最小字节数
+
+    /**
+     * @brief 轮转策略。max_file_size与interval_sec至少设置一个，否则不会轮转。
+     *
+     */
+    struct RotatePolicy{
+        uint64_t    max_file_size = 0;                      // 单个文件的最大字节数，0表示不按大小轮转
+        uint32_t    interval_sec = 0;                       // 按本地时间对齐的轮转周期(如3600为整点)，0表示不按时间轮转
+        uint32_t    max_files = DEFAULT_ROTATE_MAX_FILES;   // 保留的历史文件个数(base.1 ~ base.N)
+        uint64_t    prealloc_size = 0;                      // 新文件预分配的字节数，0表示取max_file_size
+    };
+
+    /**
+     * @brief 轮转文件sink。当前文件始终为base_file，历史文件为base_file.1(最新) ~ base_file.N。
+     *        轮转时写线程把fd换成后台已打开的base_file.next，旧fd交给后台线程截断多余的预分配空间、
+     *        关闭并完成改名，写线程不会阻塞在open/rename上。后台尚未准备好时推迟到下一条记录再轮转。
+     *
+     */
+    class RotatingFileLoggerSink : public FileLoggerSink
+    {
+    public:
+        using ptr = std::shared_ptr<RotatingFileLoggerSink>;
+        RotatingFileLoggerSink(const std::string& name, const std::string& base_file,
+                                const RotatePolicy& rotate_policy,
+                                const FileFlushPolicy& flush_policy = FileFlushPolicy());
+        ~RotatingFileLoggerSink() override;
+
+        // 已完成的轮转次数
+        uint64_t GetRotateCount();
+    protected:
+        void BeforeAppendLocked(size_t record_size) override;
+    private:
+        // 用后台准备好的文件替换当前文件，尚未就绪时返回false。需持有m_mutex
+        bool RotateLocked();
+        // 在下一个轮转时刻挂定时器，需持有m_mutex
+        void ArmRotateTimerLocked();
+        void OnRotateTimer();
+        void BackendLoop();
+        // 后台：关闭旧文件并依次改名 base.N-1 -> base.N, ..., base -> base.1, base.next -> base
+        void RetireSegment(int old_fd);
+        // 后台：打开并预分配base.next
+        int PrepareSegment();
+        // 计算下一个按本地时间对齐的轮转时刻(秒)
+        time_t NextRotateTime(time_t now) const;
+
+        RotatePolicy                m_rotate_policy;
+        std::string                 m_base_file;
+        std::string                 m_next_file;
+        int                         m_prepared_fd;      // 后台准备好的下一个文件，-1表示尚未就绪(受m_mutex保护)
+        time_t                      m_next_rotate_time; // 下一次按时间轮转的时刻，0表示不按时间
+        uint64_t                    m_rotate_count;
+        TimerId                     m_rotate_timer;     // 按时间轮转的定时器，0表示没有(受m_mutex保护)
+
+        std::thread                 m_backend;
+        std::mutex                  m_backend_mutex;
+        std::condition_variable     m_backend_cv;
+        std::deque<int>             m_retired_fds;      // 待后台处理的旧fd
+        bool                        m_need_prepare;
+        bool                        m_stop;
+    };
+
+    /**
+     * @brief 内存映射文件sink。文件被划分为连续的映射段，写线程在当前段上原子预留[offset, offset+len)后直接拷贝，
+     *        整个落地路径无锁、无系统调用。第一个越过段尾的写线程负责扩展文件、映射下一段并发布，
+     *        待旧段上的写线程全部退出后将其解除映射；其余越界者等待新段发布后重试。
+     *        文件按段预先扩展，正常析构时截断到实际长度；进程崩溃时末尾可能残留'\0'填充，重新打开时会被跳过覆盖。
+     *        扩展或映射失败(如磁盘已满)时不发布新段，期间的记录被丢弃，之后的Sink(按间隔)与Flush会重新尝试映射。
+     *        超过段大小一半的单条记录会被截断。
+     *
+     */
+    class MmapFileLoggerSink : public LoggerSinkInterface
+    {
+    public:
+        using ptr = std::shared_ptr<MmapFileLoggerSink>;
+        MmapFileLoggerSink(const std::string& name, const std::string& file_name,
+                            size_t segment_size = DEFAULT_MMAP_SEGMENT_SIZE);
+        ~MmapFileLoggerSink() override;
+        using LoggerSinkInterface::Sink;
+        void Sink(const std::string& content) override;
+        // 数据已在page cache中，仅发起异步回写(msync MS_ASYNC)
+        void Flush() override;
+        const std::string& GetFileName() const;
+        // 已映射过的段数
+        size_t GetSegmentCount();
+    private:
+        /**
+         * @brief 一个映射段。映射区间为文件的[file_offset, file_offset + size)，file_offset按页对齐。
+         *        段结构在sink析构前不释放，写线程持有的过期指针始终可以安全访问其原子成员。
+         *
+         */
+        struct Segment{
+            char*                   base = nullptr;
+            uint64_t                file_offset = 0;
+            size_t                  size = 0;
+            std::atomic<size_t>     offset{0};      // 下一个可预留的段内偏移，可能超过size
+            std::atomic<uint32_t>   writers{0};     // 正在此段上预留/拷贝的写线程数
+        };
+
+        // 映射从文件data_end处开始的新段，需持有m_roll_mutex
+        Segment* MapSegmentLocked(uint64_t data_end);
+        // 映射失败后记下续写位置，由之后的Sink/Flush重试，需持有m_roll_mutex
+        void MapFailedLocked(uint64_t data_end);
+        // 重新映射并发布新段，未到重试时间或映射仍失败时返回nullptr，需持有m_roll_mutex
+        Segment* RemapLocked(bool force);
+        // 当前没有可写的段时由Sink调用，不阻塞：其他线程正在切换时返回其发布的段
+        Segment* TryRemap();
+        // 旧段在end处写满，切换到新段
+        void RollSegment(Segment* seg, size_t end);
+        // 等待旧段写线程退出后解除映射
+        void UnmapSegment(Segment* seg);
+        // 跳过上次崩溃遗留的末尾'\0'，返回有效数据的长度
+        uint64_t FindDataEnd(uint64_t file_size);
+
+        std::string                             m_file_name;
+        size_t                                  m_segment_size;
+        int                                     m_fd;
+        std::atomic<Segment*>                   m_current;
+        std::mutex                              m_roll_mutex;   // 串行化段切换与Flush
+        std::vector<std::unique_ptr<Segment>>   m_segments;
+        bool                                    m_map_failed;   // 上次映射失败，尚未重新映射成功
+        uint64_t                                m_resume_end;   // 映射失败时文件中有效数据的长度，新段从此处续写
+        std::atomic<int64_t>                    m_next_remap_ms;    // Sink最早在此时刻(ms)重试映射，没有失败的映射时为INT64_MAX
+    };
+} // namespace dysv
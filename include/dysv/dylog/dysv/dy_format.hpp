@@ -0,0 +1,470 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief 类型安全的"{}"格式化引擎。
+ * @feature 参数类型由模板推导，不经过va_list; 整数/浮点通过std::to_chars直接写入可增长的输出缓冲;
+ *          宏入口(DY_LOGF_*)在编译期校验格式串与参数的个数、类型是否匹配。
+ * @syntax  {}                 按参数类型默认输出
+ *          {:[<|>][0][宽度][.精度][类型]}
+ *              类型: d 十进制; x/X 十六进制; o 八进制; b 二进制; c 字符; s 字符串;
+ *                    f/e/g 浮点(可配合精度); p 指针
+ *          {{ 与 }} 输出字面量'{'与'}'
+ * @example
+ *      std::string out;
+ *      dysv::fmt::FormatTo(out, "{} answer is {:04}, pi={:.3f}", "Ultimate", 42, 3.14159);
+ *      // out == "Ultimate answer is 0042, pi=3.142"
+ *
+ *      // 自定义类型需特化Formatter
+ *      template<> struct dysv::fmt::Formatter<Point>{
+ *          static void Format(std::string& out, const Point& p){ dysv::fmt::FormatTo(out, "({}, {})", p.x, p.y); }
+ *      };
+ */
+
+namespace dysv
+{
+namespace fmt
+{
+    /**
+     * @brief 参数类别，决定默认输出方式与允许的类型说明符。
+     *
+     */
+    enum ArgKind{
+        KIND_BOOL = 0,
+        KIND_CHAR,
+        KIND_INT,
+        KIND_UINT,
+        KIND_FLOAT,
+        KIND_STRING,
+        KIND_POINTER,
+        KIND_CUSTOM,    // 特化了Formatter的自定义类型，只接受"{}"
+    };
+
+    /**
+     * @brief 自定义类型的格式化扩展点。特化后提供 static void Format(std::string& out, const T& val)。
+     *
+     */
+    template<class T, class Enable = void>
+    struct Formatter{
+        static constexpr bool unsupported = true;
+    };
+
+    template<class T, class = void>
+    struct HasFormatter : std::true_type{};
+    template<class T>
+    struct HasFormatter<T, std::void_t<decltype(Formatter<T>::unsupported)>> : std::false_type{};
+
+    template<class T>
+    struct IsStringLike : std::integral_constant<bool,
+                                std::is_same<T, const char*>::value || std::is_same<T, char*>::value
+                                || std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value>{};
+
+    template<class T>
+    constexpr ArgKind KindOf(){
+        if constexpr(std::is_same<T, bool>::value){
+            return KIND_BOOL;
+        }else if constexpr(std::is_same<T, char>::value){
+            return KIND_CHAR;
+        }else if constexpr(std::is_enum<T>::value){
+            return std::is_signed<std::underlying_type_t<T>>::value ? KIND_INT : KIND_UINT;
+        }else if constexpr(std::is_integral<T>::value){
+            return std::is_signed<T>::value ? KIND_INT : KIND_UINT;
+        }else if constexpr(std::is_floating_point<T>::value){
+            return KIND_FLOAT;
+        }else if constexpr(IsStringLike<T>::value){
+            return KIND_STRING;
+        }else if constexpr(std::is_pointer<T>::value || std::is_null_pointer<T>::value){
+            return KIND_POINTER;
+        }else{
+            static_assert(HasFormatter<T>::value, "dysv::fmt: no Formatter specialization for this argument type");
+            return KIND_CUSTOM;
+        }
+    }
+
+    /**
+     * @brief 解析后的格式说明 {:[align][0][width][.precision][type]}
+     *
+     */
+    struct FormatSpec{
+        char    align = 0;      // '<' 或 '>'，0表示默认(数值右对齐，其余左对齐)
+        bool    zero_pad = false;
+        int     width = 0;
+        int     precision = -1;
+        char    type = 0;
+    };
+
+    /**
+     * @brief 解析占位符内部[begin, end)的格式说明(不含':')。
+     *
+     * @return true 语法正确
+     */
+    constexpr bool ParseSpec(const char* begin, const char* end, FormatSpec& spec){
+        const char* p = begin;
+        if(p != end && (*p == '<' || *p == '>')){
+            spec.align = *p++;
+        }
+        if(p != end && *p == '0'){
+            spec.zero_pad = true;
+            p++;
+        }
+        while(p != end && *p >= '0' && *p <= '9'){
+            spec.width = spec.width * 10 + (*p++ - '0');
+        }
+        if(p != end && *p == '.'){
+            p++;
+            if(p == end || *p < '0' || *p > '9'){
+                return false;
+            }
+            spec.precision = 0;
+            while(p != end && *p >= '0' && *p <= '9'){
+                spec.precision = spec.precision * 10 + (*p++ - '0');
+            }
+        }
+        if(p != end){
+            spec.type = *p++;
+        }
+        return p == end;
+    }
+
+    /**
+     * @brief 说明符能否作用于该类别的参数。
+     *
+     */
+    constexpr bool SpecAccepts(const FormatSpec& spec, ArgKind kind){
+        if(kind == KIND_CUSTOM){
+            return spec.type == 0 && spec.precision < 0 && spec.width == 0;
+        }
+        if(spec.precision >= 0 && kind != KIND_FLOAT && kind != KIND_STRING){
+            return false;
+        }
+        switch(spec.type){
+            case 0:
+                return true;
+            case 'd':
+                return kind == KIND_INT || kind == KIND_UINT || kind == KIND_CHAR || kind == KIND_BOOL;
+            case 'x': case 'X': case 'o': case 'b':
+                return kind == KIND_INT || kind == KIND_UINT || kind == KIND_CHAR || kind == KIND_POINTER;
+            case 'c':
+                return kind == KIND_INT || kind == KIND_UINT || kind == KIND_CHAR;
+            case 's':
+                return kind == KIND_STRING || kind == KIND_BOOL;
+            case 'f': case 'e': case 'g':
+                return kind == KIND_FLOAT;
+            case 'p':
+                return kind == KIND_POINTER || kind == KIND_STRING;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief 编译期参数类型列表。
+     *
+     */
+    template<class... Args>
+    struct TypeList{};
+
+    // 仅用于decltype，取得宏参数退化后的类型
+    template<class... Args>
+    TypeList<std::decay_t<Args>...> ArgTypes(Args&&... args);
+
+    /**
+     * @brief 校验格式串与参数类型：占位符个数与参数个数一致，且各说明符与对应参数类型相容。
+     *        可在常量表达式中求值，供宏在编译期检查。
+     *
+     */
+    template<class... Args>
+    constexpr bool CheckFormat(TypeList<Args...>, const char* fmt){
+        constexpr ArgKind kinds[] = {KindOf<Args>()..., KIND_CUSTOM};
+        constexpr size_t nargs = sizeof...(Args);
+        size_t idx = 0;
+        for(const char* p = fmt; *p != '\0'; p++){
+            if(*p == '}'){
+                if(*(p + 1) != '}'){
+                    return false;
+                }
+                p++;
+                continue;
+            }
+            if(*p != '{'){
+                continue;
+            }
+            if(*(p + 1) == '{'){
+                p++;
+                continue;
+            }
+            const char* close = p + 1;
+            while(*close != '\0' && *close != '}'){
+                close++;
+            }
+            if(*close == '\0' || idx >= nargs){
+                return false;
+            }
+            FormatSpec spec;
+            const char* inner = p + 1;
+            if(inner != close){
+                if(*inner != ':' || !ParseSpec(inner + 1, close, spec)){
+                    return false;
+                }
+            }
+            if(!SpecAccepts(spec, kinds[idx])){
+                return false;
+            }
+            idx++;
+            p = close;
+        }
+        return idx == nargs;
+    }
+
+    /**
+     * @brief 实例化即触发静态断言，使宏可以在表达式中完成编译期检查。
+     *
+     */
+    template<bool ok>
+    struct FormatChecked{
+        static_assert(ok, "dysv::fmt: format string does not match the number or types of arguments");
+    };
+
+    /// 以下为运行期写入
+    // 按宽度/对齐补齐[begin, end)后追加到out
+    inline void AppendPadded(std::string& out, const char* begin, size_t len, const FormatSpec& spec, bool numeric){
+        size_t width = spec.width > 0 ? (size_t)spec.width : 0;
+        if(width <= len){
+            out.append(begin, len);
+            return;
+        }
+        size_t pad = width - len;
+        bool right = spec.align == '>' || (spec.align == 0 && numeric);
+        if(numeric && spec.zero_pad && spec.align == 0){
+            // 符号位置于补齐的0之前
+            if(len > 0 && (*begin == '-' || *begin == '+')){
+                out.push_back(*begin++);
+                len--;
+            }
+            out.append(pad, '0');
+            out.append(begin, len);
+            return;
+        }
+        if(right){
+            out.append(pad, ' ');
+            out.append(begin, len);
+        }else{
+            out.append(begin, len);
+            out.append(pad, ' ');
+        }
+    }
+
+    template<class T>
+    inline void WriteInteger(std::string& out, T val, const FormatSpec& spec){
+        char buf[72];
+        char* begin = buf;
+        char* end;
+        switch(spec.type){
+            case 'x': case 'X':
+                end = std::to_chars(begin, buf + sizeof(buf), val, 16).ptr;
+                if(spec.type == 'X'){
+                    for(char* p = begin; p != end; p++){
+                        if(*p >= 'a' && *p <= 'f'){
+                            *p = *p - 'a' + 'A';
+                        }
+                    }
+                }
+                break;
+            case 'o':
+                end = std::to_chars(begin, buf + sizeof(buf), val, 8).ptr;
+                break;
+            case 'b':
+                end = std::to_chars(begin, buf + sizeof(buf), val, 2).ptr;
+                break;
+            case 'c':
+                out.push_back((char)val);
+                return;
+            default:
+                end = std::to_chars(begin, buf + sizeof(buf), val).ptr;
+                break;
+        }
+        if(spec.width == 0){
+            out.append(begin, end - begin);
+        }else{
+            AppendPadded(out, begin, end - begin, spec, true);
+        }
+    }
+
+    inline void WriteFloat(std::string& out, double val, const FormatSpec& spec){
+        char buf[128];
+        std::to_chars_result rc;
+        std::chars_format chfmt = std::chars_format::general;
+        if(spec.type == 'f'){
+            chfmt = std::chars_format::fixed;
+        }else if(spec.type == 'e'){
+            chfmt = std::chars_format::scientific;
+        }
+        if(spec.precision >= 0){
+            rc = std::to_chars(buf, buf + sizeof(buf), val, chfmt, spec.precision);
+        }else if(spec.type == 0){
+            rc = std::to_chars(buf, buf + sizeof(buf), val);
+        }else{
+            rc = std::to_chars(buf, buf + sizeof(buf), val, chfmt);
+        }
+        if(rc.ec != std::errc()){
+            out.append("{?}");
+            return;
+        }
+        AppendPadded(out, buf, rc.ptr - buf, spec, true);
+    }
+
+    inline void WriteString(std::string& out, std::string_view val, const FormatSpec& spec){
+        if(spec.precision >= 0 && (size_t)spec.precision < val.size()){
+            val = val.substr(0, spec.precision);
+        }
+        if(spec.width == 0){
+            out.append(val.data(), val.size());
+        }else{
+            AppendPadded(out, val.data(), val.size(), spec, false);
+        }
+    }
+
+    inline void WritePointer(std::string& out, const void* val, const FormatSpec& spec){
+        char buf[24] = {'0', 'x'};
+        char* end = std::to_chars(buf + 2, buf + sizeof(buf), (uintptr_t)val, 16).ptr;
+        AppendPadded(out, buf, end - buf, spec, true);
+    }
+
+    template<class T>
+    inline void WriteArg(std::string& out, const T& val, const FormatSpec& spec){
+        constexpr ArgKind kind = KindOf<T>();
+        if constexpr(kind == KIND_BOOL){
+            if(spec.type == 'd'){
+                WriteInteger(out, (int)val, spec);
+            }else{
+                WriteString(out, val ? "true" : "false", spec);
+            }
+        }else if constexpr(kind == KIND_CHAR){
+            if(spec.type == 0 || spec.type == 'c'){
+                WriteString(out, std::string_view(&val, 1), spec);
+            }else{
+                WriteInteger(out, (int)val, spec);
+            }
+        }else if constexpr(std::is_enum<T>::value){
+            WriteInteger(out, (std::underlying_type_t<T>)val, spec);
+        }else if constexpr(kind == KIND_INT || kind == KIND_UINT){
+            WriteInteger(out, val, spec);
+        }else if constexpr(kind == KIND_FLOAT){
+            WriteFloat(out, (double)val, spec);
+        }else if constexpr(kind == KIND_STRING){
+            if constexpr(std::is_pointer<T>::value){
+                if(spec.type == 'p'){
+                    WritePointer(out, val, spec);
+                }else{
+                    WriteString(out, val != nullptr ? std::string_view(val) : std::string_view("(null)"), spec);
+                }
+            }else{
+                WriteString(out, std::string_view(val), spec);
+            }
+        }else if constexpr(kind == KIND_POINTER){
+            if constexpr(std::is_null_pointer<T>::value){
+                WritePointer(out, nullptr, spec);
+            }else if(spec.type == 0 || spec.type == 'p'){
+                WritePointer(out, (const void*)val, spec);
+            }else{
+                WriteInteger(out, (uintptr_t)val, spec);
+            }
+        }else{
+            Formatter<T>::Format(out, val);
+        }
+    }
+
+    /**
+     * @brief 类型擦除的参数引用，仅在一次FormatTo调用内有效，避免为每种参数组合展开解析循环。
+     *
+     */
+    struct ArgRef{
+        const void* ptr;
+        void (*write)(std::string& out, const void* val, const FormatSpec& spec);
+    };
+
+    template<class T>
+    inline void WriteErased(std::string& out, const void* val, const FormatSpec& spec){
+        WriteArg(out, *static_cast<const T*>(val), spec);
+    }
+
+    // 解析fmt并依次写入参数。占位符多于参数时输出"{?}"，多余的参数被忽略
+    inline void VFormatTo(std::string& out, std::string_view fmt, const ArgRef* args, size_t nargs){
+        const char* p = fmt.data();
+        const char* end = p + fmt.size();
+        size_t idx = 0;
+        while(p != end){
+            const char* brace = p;
+            while(brace != end && *brace != '{' && *brace != '}'){
+                brace++;
+            }
+            out.append(p, brace - p);
+            if(brace == end){
+                break;
+            }
+            if(brace + 1 != end && *(brace + 1) == *brace){
+                // "{{" 或 "}}"
+                out.push_back(*brace);
+                p = brace + 2;
+                continue;
+            }
+            if(*brace == '}'){
+                out.push_back('}');
+                p = brace + 1;
+                continue;
+            }
+            const char* close = brace + 1;
+            while(close != end && *close != '}'){
+                close++;
+            }
+            if(close == end){
+                out.append(brace, end - brace);
+                break;
+            }
+            FormatSpec spec;
+            const char* inner = brace + 1;
+            bool spec_ok = (inner == close) || (*inner == ':' && ParseSpec(inner + 1, close, spec));
+            if(spec_ok && idx < nargs){
+                args[idx].write(out, args[idx].ptr, spec);
+            }else{
+                out.append("{?}");
+            }
+            idx++;
+            p = close + 1;
+        }
+    }
+
+    // 字符数组(如字符串字面量)退化为指针，其余参数原样引用
+    template<class T>
+    inline const T& DecayArg(const T& val){ return val; }
+    template<size_t N>
+    inline const char* DecayArg(const char (&val)[N]){ return val; }
+
+    template<class... Args>
+    inline void FormatToDecayed(std::string& out, std::string_view fmt, const Args&... args){
+        const ArgRef refs[] = {ArgRef{&args, &WriteErased<Args>}..., ArgRef{nullptr, nullptr}};
+        VFormatTo(out, fmt, refs, sizeof...(Args));
+    }
+
+    /**
+     * @brief 按fmt格式化参数并追加到out末尾。
+     *
+     */
+    template<class... Args>
+    inline void FormatTo(std::string& out, std::string_view fmt, const Args&... args){
+        FormatToDecayed(out, fmt, DecayArg(args)...);
+    }
+
+    template<class... Args>
+    inline std::string Format(std::string_view fmt, const Args&... args){
+        std::string out;
+        FormatTo(out, fmt, args...);
+        return out;
+    }
+} // namespace fmt
+} // namespace dysv
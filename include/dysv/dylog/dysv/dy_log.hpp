@@ -18,16 +18,43 @@
 #include <algorithm>
 #include <thread>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <charconv>
+#include <string_view>
 #include "../common/dy_singleton.hpp"
+#include "../common/dy_rcu.hpp"
+#include "../common/dy_counter.hpp"
+#include "../common/dy_timing_wheel.hpp"
+#include "dy_format.hpp"
+#include "dy_log_limit.hpp"
+#include "dy_log_kv.hpp"
 
 /**
  * @brief 日志模块。
- * @feature 同步; 输出至多文件; 流/格式化输出;
- * @todo asyn; mutex; sink cache; exception;
+ * @feature 同步/异步(AsyncLogger); 输出至多文件; 流/格式化输出; 类型安全的"{}"格式化(dy_format.hpp);
+ *          二进制延迟格式化(dy_binary_log.hpp);
+ *          日志器注册表与sink表为写时复制快照(dy_rcu.hpp)，打印日志的路径不加锁，可与增删sink/日志器并发;
+ *          运行时统计(分条带计数，读取时汇总): LoggerManger::Snapshot()与周期性自报告;
+ *          调用点级别的限频与采样(dy_log_limit.hpp): DY_LOG_EVERY_N / FIRST_N / EVERY_MS / RATE_LIMITED;
+ *          流式日志(dy_log_stream.hpp): 线程内复用的缓冲，数值/字符串不经过std::ostream;
+ *          每个sink可单独设置模式与级别，同一条记录每种模式只渲染一次，由使用该模式的sink共享;
+ *          结构化键值日志(dy_log_kv.hpp): DY_LOG_KV，按LoggerPattern的编码输出文本/JSON/logfmt;
+ *          崩溃时的日志排空(dy_crash_handler.hpp): 崩溃信号中以write(2)写出队列与缓冲中尚未落地的记录;
+ *          套接字sink(dy_socket_sink.hpp): 非阻塞地把日志成批发往本机收集端(Unix数据报/Unix流/UDP);
+ *          io_uring文件sink(dy_uring_sink.hpp): 写满的缓冲作为异步写请求提交，写线程不等待磁盘(DYSV_WITH_IO_URING);
+ *          后台刷新: LoggerManger::StartBackgroundFlush在工作窃取线程池(../common/dy_executor.hpp)上周期性刷新各日志器;
+ *          定时器: 文件sink的max_latency_ms、按时间轮转与后台刷新都挂在全局时间轮(../common/dy_timing_wheel.hpp)上，共用一个驱动线程;
+ * @todo sink cache; exception;
  * @example 
  *      // 默认日志器
- *      dysv::infoStream << "some thing";   // 流式输出至控制台;    //todo
- *      dysv::info("welcome {}", "dysv");   // 格式化输出至控制台;  //todo
+ *      dysv::infoStream() << "some thing"; // 流式输出至控制台(dy_log_stream.hpp);
+ *      DY_LOG_STREAM_INFO << "id " << 42;  // 流式输出，模式化，被过滤时不对操作数求值;
+ *      dysv::info("welcome {}", "dysv");   // 格式化输出至控制台;
+ *      DY_LOGF_INFO("{} answer is {}", "Ultimate", 42); // 编译期校验格式串与参数类型;
  *      dysv::set_level(dysv::level::info); // 设置默认日志器的日志级别，后续低于该级别的日志则不会落地;
  *      dysv::set_logger(logger);           // 更改默认的日志器;
  *      dysv::set_pattern("[%D %H:%M:%S:%s][%T][%F][%L][%P][%C]");   // 设置默认日志模式;
@@ -42,11 +69,26 @@
 namespace dysv
 {
 #define DEFAULT_PATTERN_STR "[%D %H:%M:%S:%s][%T][%F][%L][%P][%C]"
+#define LOG_NO_FIELDS       UINT32_MAX  // LogAdditionInfo中表示没有结构化字段
 
     /**
      * @brief 日志级别
      * 
      */
+    /**
+     * @brief 编译期日志级别，数值与level::LevelEnum一致，供预处理器比较。
+     * 
+     */
+#define DYSV_LEVEL_TRACE    0
+#define DYSV_LEVEL_INFO     1
+#define DYSV_LEVEL_WARN     2
+#define DYSV_LEVEL_ERROR    3
+#define DYSV_LEVEL_FATAL    4
+#define DYSV_LEVEL_OFF      5
+#ifndef DYSV_ACTIVE_LEVEL
+#define DYSV_ACTIVE_LEVEL   DYSV_LEVEL_TRACE
+#endif
+
     namespace level
     {
         enum LevelEnum
@@ -59,6 +101,9 @@ namespace dysv
             UNKNOW
         };
         const std::string to_string(level::LevelEnum lv);
+        const char* to_c_str(level::LevelEnum lv);
+        static_assert(TRACE == DYSV_LEVEL_TRACE && INFO == DYSV_LEVEL_INFO && WARN == DYSV_LEVEL_WARN
+                        && ERROR == DYSV_LEVEL_ERROR && FATAL == DYSV_LEVEL_FATAL, "level macros out of sync");
         level::LevelEnum to_enum(const std::string &lv);
     } // namespace level
 
@@ -83,7 +128,8 @@ namespace dysv
             H_HOUR,             // H, 小时。eg: 08
             M_MINUTE,           // M, 分钟。eg: 59
             S_SECOND,           // S, 秒。eg: 33
-            s_MILLISECOND,      // s, 毫秒。eg: 012
+            s_MILLISECOND,      // s, 秒以下部分(微秒，6位)。eg: 012345
+            f_FUNC_NAME,        // f, 打印日志时的函数名
             MAX_PATTERN         // 未知标识符，以' '替代
         };
         /**
@@ -103,21 +149,41 @@ namespace dysv
         PlaceholderType to_enum(const char& pt);
     } // namespace placeholder
 
+    /**
+     * @brief 获取当前线程ID。线程内缓存，仅首次调用产生系统调用。
+     * 
+     */
+    pid_t GetCurrentThreadId();
+
+    /**
+     * @brief 将[data, data+len)完整写入fd，处理短写与EINTR。失败返回false。
+     * 
+     */
+    bool WriteFully(int fd, const char* data, size_t len);
+
     class LogAdditionInfo;
     class Logger;
     class LoggerPattern;
     class LoggerSinkInterface;
     class LoggerManger;
+    class BinaryLogWriter;
+    class Executor;
     /**
      * @brief 除日志内容与日志级别，为LogPattern格式化提供额外的辅助信息。
+     *        可平凡拷贝，直接在调用处的栈上构造(见ADD_ADDITION_INFO)，不申请堆内存。
      * 
      */
     class LogAdditionInfo{
     public:
         using ptr = std::shared_ptr<LogAdditionInfo>;
-        // 文件名和行号必须在调用处传入
-        LogAdditionInfo(const std::string& file, uint64_t line);
+        // 空信息，仅用于预分配的槽位
+        LogAdditionInfo();
+        // 文件名和行号必须在调用处传入。file/func仅保存指针，需在日志落地前保持有效(通常为__FILE__/__func__字面量)
+        LogAdditionInfo(const char* file, uint64_t line, const char* func = "");
+        // 回放已记录的信息(如解码二进制日志)，不取当前线程与时间
+        LogAdditionInfo(const char* file, uint64_t line, const char* func, pid_t thread_id, const timespec& time);
         std::string GetFileName() const;
+        std::string GetFuncName() const;
         std::string GetLineNumber() const;
         std::string GetThreadId() const;
         std::string GetDate() const;
@@ -128,15 +194,147 @@ namespace dysv
         // 通过占位符直接获取所需信息
         std::string GetAdditionInfoByPlaceholder(char plchld) const;
         std::string GetAdditionInfoByPlaceholder(placeholder::PlaceholderType plchld) const;
+        // 将占位符对应的信息直接追加到out末尾，不产生临时字符串
+        void AppendAdditionInfo(placeholder::PlaceholderType plchld, std::string& out) const;
+        // 追加"YYYY/MM/DD HH:MM:SS"，等价于"%D %H:%M:%S"
+        void AppendDateTime(std::string& out) const;
+        const timespec& GetTime() const;
+        // 以落地顺序为准重新打时间戳(见ShardedAsyncLogger)
+        void SetTime(const timespec& time);
+        // 结构化字段区(见dy_log_kv.hpp)在日志内容中的起始偏移，无字段时为LOG_NO_FIELDS
+        uint32_t GetFieldsOffset() const;
+        void SetFieldsOffset(uint32_t offset);
     private:
-        std::string         m_file_name; // 记录日志处所在文件名
+        friend class CrashHandler;  // 崩溃时不经std::string直接读取各字段
+
+        const char*         m_file_name; // 记录日志处所在文件名
+        const char*         m_func_name; // 记录日志处所在函数名
         uint64_t            m_line_num;  // 记录日志处所在文件行号
-        pid_t               m_thread_id; // 记录日志的线程ID
-        timespec            m_time;      // 记录日志的时间(std::time_t tv_sec; long tv_nsec;)
-        tm*                 m_tm;        // 格式化的m_time秒级时间，减少解析次数(系统调用返回即为指针，此内存为静态的无需管理)
-        clock_t             m_elapse;    // 从线程启动到日志记录时已流逝的时间(微秒, 1s = 10^6)
+        pid_t               m_thread_id; // 记录日志的线程ID(线程内缓存，仅首次系统调用)
+        uint32_t            m_fields_offset; // 结构化字段区的起始偏移(占用m_thread_id之后的对齐空隙)
+        timespec            m_time;      // 记录日志的时间(std::time_t tv_sec; long tv_nsec;)。渲染时使用线程内按秒缓存的结果
     };
 
+    /**
+     * @brief 日志调用点。DY_LOG_FMT_*与DY_LOGF_*在每个调用点构造一个静态LogSite，首次执行时分配进程内唯一的id;
+     *        二进制模式下每条记录只写id，格式串/文件/行号/函数名在每个文件中只写一次。
+     *        各字符串只保存指针，须为字面量等静态存储期的字符串。
+     * 
+     */
+    struct LogSite{
+        enum FormatStyle{
+            PRINTF = 0,     // "%d"风格(DY_LOG_FMT_*)
+            BRACE,          // "{}"风格(DY_LOGF_*)
+        };
+        LogSite(level::LevelEnum level, FormatStyle format_style, const char* file, uint64_t line,
+                const char* func, const char* format);
+
+        uint32_t            id;
+        level::LevelEnum    lv;
+        FormatStyle         style;
+        const char*         file_name;
+        uint64_t            line_num;
+        const char*         func_name;
+        const char*         fmt;
+    };
+
+    /**
+     * @brief 二进制日志中的参数类型。BIN_WIRE_TYPE_COUNT之前的类型会写入文件，之后的仅在编码时使用，
+     *        编码后分别记为BIN_STRING/BIN_F64。
+     * 
+     */
+    enum BinaryArgType : uint8_t{
+        BIN_BOOL = 0,
+        BIN_CHAR,
+        BIN_I8,
+        BIN_I16,
+        BIN_I32,
+        BIN_I64,
+        BIN_U8,
+        BIN_U16,
+        BIN_U32,
+        BIN_U64,
+        BIN_F32,
+        BIN_F64,
+        BIN_PTR,
+        BIN_STRING,             // u32长度 + 字节
+        BIN_WIRE_TYPE_COUNT,
+        BIN_CSTR = BIN_WIRE_TYPE_COUNT, // ptr即字符串本身
+        BIN_STD_STRING,         // ptr指向std::string
+        BIN_STRING_VIEW,        // ptr指向std::string_view
+        BIN_LONG_DOUBLE,
+        BIN_CUSTOM,             // 自定义类型，编码时经Formatter渲染为字符串
+    };
+
+    /**
+     * @brief 类型擦除的二进制参数，仅在一次LogAt调用内有效。ptr指向调用者的参数(BIN_CSTR/BIN_PTR为值本身)。
+     * 
+     */
+    struct BinaryArg{
+        BinaryArgType   type;
+        const void*     ptr;
+        void            (*render)(std::string& out, const void* val);
+    };
+
+    template<class T>
+    constexpr BinaryArgType BinaryIntType(){
+        static_assert(sizeof(T) <= 8, "dysv: integer argument wider than 64 bits");
+        if constexpr(sizeof(T) == 1){
+            return std::is_signed<T>::value ? BIN_I8 : BIN_U8;
+        }else if constexpr(sizeof(T) == 2){
+            return std::is_signed<T>::value ? BIN_I16 : BIN_U16;
+        }else if constexpr(sizeof(T) == 4){
+            return std::is_signed<T>::value ? BIN_I32 : BIN_U32;
+        }else{
+            return std::is_signed<T>::value ? BIN_I64 : BIN_U64;
+        }
+    }
+
+    template<class T>
+    inline void RenderCustomArg(std::string& out, const void* val){
+        fmt::Formatter<T>::Format(out, *static_cast<const T*>(val));
+    }
+
+    template<class T>
+    inline BinaryArg MakeBinaryArg(const T& val){
+        constexpr fmt::ArgKind kind = fmt::KindOf<T>();
+        if constexpr(kind == fmt::KIND_BOOL){
+            return BinaryArg{BIN_BOOL, &val, nullptr};
+        }else if constexpr(kind == fmt::KIND_CHAR){
+            return BinaryArg{BIN_CHAR, &val, nullptr};
+        }else if constexpr(std::is_enum<T>::value){
+            return BinaryArg{BinaryIntType<std::underlying_type_t<T>>(), &val, nullptr};
+        }else if constexpr(kind == fmt::KIND_INT || kind == fmt::KIND_UINT){
+            return BinaryArg{BinaryIntType<T>(), &val, nullptr};
+        }else if constexpr(kind == fmt::KIND_FLOAT){
+            if constexpr(std::is_same<T, float>::value){
+                return BinaryArg{BIN_F32, &val, nullptr};
+            }else if constexpr(std::is_same<T, double>::value){
+                return BinaryArg{BIN_F64, &val, nullptr};
+            }else{
+                return BinaryArg{BIN_LONG_DOUBLE, &val, nullptr};
+            }
+        }else if constexpr(std::is_pointer<T>::value && kind == fmt::KIND_STRING){
+            return BinaryArg{BIN_CSTR, val, nullptr};
+        }else if constexpr(std::is_same<T, std::string>::value){
+            return BinaryArg{BIN_STD_STRING, &val, nullptr};
+        }else if constexpr(std::is_same<T, std::string_view>::value){
+            return BinaryArg{BIN_STRING_VIEW, &val, nullptr};
+        }else if constexpr(std::is_null_pointer<T>::value){
+            return BinaryArg{BIN_PTR, nullptr, nullptr};
+        }else if constexpr(kind == fmt::KIND_POINTER){
+            return BinaryArg{BIN_PTR, (const void*)val, nullptr};
+        }else{
+            return BinaryArg{BIN_CUSTOM, &val, &RenderCustomArg<T>};
+        }
+    }
+
+    // 字符数组(如字符串字面量)直接按字符串记录
+    template<size_t N>
+    inline BinaryArg MakeBinaryArg(const char (&val)[N]){
+        return BinaryArg{BIN_CSTR, val, nullptr};
+    }
+
     /**
      * @brief 日志事件。将日志标准化，便于从日志文件中分析每条日志[when][who][where]的信息，防止日志文件杂糅在一起。
      * 
@@ -146,7 +344,7 @@ namespace dysv
     public:
         using ptr = std::shared_ptr<LoggerPattern>;
         LoggerPattern();
-        LoggerPattern(const std::string& pt);
+        LoggerPattern(const std::string& pt, LogEncoding encoding = ENCODING_TEXT);
         
         // 格式化+模式化
         std::string FmtAndPatternLog(LogAdditionInfo::ptr other_info, 
@@ -158,11 +356,21 @@ namespace dysv
         std::string PatternLog(LogAdditionInfo::ptr other_info, 
                                 level::LevelEnum lv, 
                                 const std::string &content);
+        std::string PatternLog(const LogAdditionInfo& other_info, 
+                                level::LevelEnum lv, 
+                                const std::string &content);
+        // 模式化，结果追加到out末尾(out可跨调用复用)。content中结构化字段区的位置由other_info给出
+        void PatternLog(const LogAdditionInfo& other_info, 
+                        level::LevelEnum lv, 
+                        std::string_view content,
+                        std::string& out) const;
         
 
         // 格式化
         static std::string FormatLog(const std::string &content, ...);
         static std::string FormatLog(const std::string &content, va_list args);
+        // 格式化，结果追加到out末尾(out可跨调用复用，长度不受限)
+        static void FormatLog(std::string& out, const char* content, va_list args);
         
         /**
          * @brief Get the Default Pattern Str object
@@ -173,8 +381,81 @@ namespace dysv
         void SetPatternStr(const std::string & str);
         std::string GetPatternStr();
         void Reset2Default();
+        // 输出编码(见dy_log_kv.hpp)。JSON/logfmt只取模式串中的占位符作为键，字面量忽略
+        void SetEncoding(LogEncoding encoding);
+        LogEncoding GetEncoding() const;
     private:
-        std::string m_pattern_str;
+        /**
+         * @brief 预编译的模式项。字面量以[offset, offset+length)引用m_pattern_str。
+         * 
+         */
+        struct PatternItem{
+            enum ItemType{
+                LITERAL = 0,    // 字面量片段
+                CONTENT,        // 日志内容
+                PRIORITY,       // 日志级别
+                ADDITION_INFO,  // 由LogAdditionInfo提供的信息
+                DATE_TIME,      // "%D %H:%M:%S"融合项
+            };
+            ItemType                        type;
+            placeholder::PlaceholderType    placeholder;
+            size_t                          offset;
+            size_t                          length;
+        };
+
+        // SetPatternStr时编译一次，之后每条日志只需顺序遍历m_items
+        void Compile();
+        // JSON/logfmt编码的模式化
+        void PatternStructured(const LogAdditionInfo& other_info, 
+                                level::LevelEnum lv, 
+                                std::string_view msg,
+                                std::string_view fields,
+                                std::string& out) const;
+
+        std::string                 m_pattern_str;
+        std::vector<PatternItem>    m_items;
+        LogEncoding                 m_encoding;
+    };
+
+    /**
+     * @brief sink的运行时统计快照。计数均为自创建以来的累计值。
+     * 
+     */
+    struct SinkStats{
+        std::string     name;
+        uint64_t        records = 0;        // 经Logger写入的记录数
+        uint64_t        bytes = 0;          // 经Logger写入的字节数(不含换行)
+        uint64_t        dropped = 0;        // sink自身丢弃的记录数(如写入失败)
+        uint64_t        latency_buckets[DYSV_HISTOGRAM_BUCKETS] = {};  // 单次Sink()耗时(纳秒)的log2直方图
+        uint64_t        latency_max_ns = 0;
+        // 耗时的近似分位数(所在桶的上界)，p取0~1
+        uint64_t LatencyPercentile(double p) const;
+    };
+
+    /**
+     * @brief 日志器的运行时统计快照。
+     * 
+     */
+    struct LoggerStats{
+        std::string             name;
+        uint64_t                accepted = 0;       // 通过级别过滤并交给sink(或入队)的记录数
+        uint64_t                filtered = 0;       // 被级别过滤的调用数
+        uint64_t                dropped = 0;        // 日志器丢弃的记录数(如异步队列的背压策略)
+        uint64_t                queue_depth = 0;    // 异步日志器中尚未落地的记录数
+        std::vector<SinkStats>  sinks;              // 被多个日志器共用的sink在每个日志器下都会出现
+    };
+
+    /**
+     * @brief 所有日志器的统计快照。
+     * 
+     */
+    struct LogStatsSnapshot{
+        timespec                    time;       // 取快照的时刻(CLOCK_REALTIME)
+        std::vector<LoggerStats>    loggers;
+        // 相对更早的快照的增量(按名字匹配)，用于计算区间速率与区间分位数。queue_depth与latency_max_ns保持原值
+        LogStatsSnapshot Since(const LogStatsSnapshot& earlier) const;
+        // 每个日志器一行、每个sink一行
+        std::string ToString() const;
     };
 
     /**
@@ -189,9 +470,58 @@ namespace dysv
         virtual ~LoggerSinkInterface();
         
         virtual void Sink(const std::string& content) = 0;
+        // 带级别的落地，Logger通过此接口调用sink。默认忽略级别
+        virtual void Sink(level::LevelEnum lv, const std::string& content);
+        // 将已缓冲的内容落盘，默认无缓冲
+        virtual void Flush();
         std::string GetName();
+
+        /// 崩溃处理(dy_crash_handler.hpp)在信号处理函数中调用，实现只能使用异步信号安全的操作(不加锁、不申请内存)
+        // 写出已缓冲而尚未落地的内容，默认无缓冲
+        virtual void EmergencyFlush();
+        // 直接写出一条已渲染的记录(含换行)，返回false表示不支持
+        virtual bool EmergencyWrite(const char* data, size_t len);
+
+        /// 级别与模式，均可在打印日志时修改
+        // 低于该级别的记录不写入此sink，默认TRACE。日志器据所有sink的最低级别提前过滤
+        void SetLevel(level::LevelEnum lv);
+        level::LevelEnum GetLevel() const;
+        bool ShouldSink(level::LevelEnum lv) const{
+            return lv >= m_level.load(std::memory_order_relaxed);
+        }
+        // 单独的模式，为空时使用日志器的模式
+        void SetPattern(LoggerPattern::ptr pattern);
+        void SetPattern(const std::string& pattern_str);
+        LoggerPattern::ptr GetPattern();
+        // 同GetPattern，不增加引用计数。须在RcuReadGuard内调用，返回值仅在临界区内有效
+        const LoggerPattern* PeekPattern() const;
+        // 任一sink的级别或任一日志器的sink表变化时递增，日志器据此刷新缓存的sink最低级别
+        static uint64_t GetLevelGeneration(){
+            return s_level_generation.load(std::memory_order_acquire);
+        }
+        static void BumpLevelGeneration();
+
+        // 由Logger在每次Sink()之后调用，记录字节数与耗时
+        void RecordSink(size_t bytes, uint64_t cost_ns);
+        SinkStats GetStats();
+    protected:
+        // 子类丢弃记录时调用
+        void CountDropped(uint64_t n = 1);
     private:
-        std::string m_name;
+        enum StatField{
+            STAT_RECORDS = 0,
+            STAT_BYTES,
+            STAT_DROPPED,
+            STAT_FIELD_COUNT
+        };
+
+        std::string                         m_name;
+        std::atomic<level::LevelEnum>       m_level;
+        RcuPtr<LoggerPattern::ptr>          m_pattern;      // 写时替换，Logger在读临界区内取用
+        StripedCounters<STAT_FIELD_COUNT>   m_stats;
+        StripedHistogram                    m_latency;
+
+        static std::atomic<uint64_t>        s_level_generation;
     };
 
     enum StdLoggerSinkType {
@@ -205,7 +535,10 @@ namespace dysv
         using ptr = std::shared_ptr<StdLoggerSink>;
         StdLoggerSink(const std::string& name, StdLoggerSinkType tp);
         virtual ~StdLoggerSink();
+        using LoggerSinkInterface::Sink;
         void Sink(const std::string& content) override;
+        void Flush() override;
+        bool EmergencyWrite(const char* data, size_t len) override;
         StdLoggerSinkType GetType();
     private:
         std::ostream*       m_stream;
@@ -213,17 +546,65 @@ namespace dysv
     };
 
 
+#define DEFAULT_FILE_BUFFER_SIZE        (64 * 1024)    // 文件sink默认用户态缓冲大小
+#define DEFAULT_FILE_FLUSH_LATENCY_MS   1000           // 文件sink默认最长写出延迟
+
+    /**
+     * @brief 文件sink的刷新策略。满足任一条件即把用户态缓冲一次性write到文件。
+     * 
+     */
+    struct FileFlushPolicy{
+        size_t              buffer_size = DEFAULT_FILE_BUFFER_SIZE;            // 缓冲达到该字节数
+        uint32_t            max_latency_ms = DEFAULT_FILE_FLUSH_LATENCY_MS;    // 最早一条未写出的记录已停留该时长(0表示不限)。由全局时间轮上的定时器保证，没有新记录时同样生效(文件、轮转文件、io_uring、套接字sink与二进制日志均适用)
+        level::LevelEnum    flush_level = level::ERROR;                        // 记录级别不低于该级别时立即写出
+
+        // 每条记录立即写出(与旧版std::endl行为一致)
+        static FileFlushPolicy Immediate();
+    };
+
+    /**
+     * @brief 文件sink。记录先追加到用户态缓冲，按FileFlushPolicy通过O_APPEND的fd成块写出。
+     * 
+     */
     class FileLoggerSink : public LoggerSinkInterface
     {
     public:
         using ptr = std::shared_ptr<FileLoggerSink>;
-        FileLoggerSink(const std::string& name, const std::string& file_name);
+        FileLoggerSink(const std::string& name, const std::string& file_name,
+                        const FileFlushPolicy& policy = FileFlushPolicy());
         virtual ~FileLoggerSink();
         void Sink(const std::string& content) override;
+        void Sink(level::LevelEnum lv, const std::string& content) override;
+        void Flush() override;
+        // 崩溃时不加锁地写出缓冲(只写一次)，之后的记录直接写入fd
+        void EmergencyFlush() override;
+        bool EmergencyWrite(const char* data, size_t len) override;
         bool Reopen();
+        void SetFlushPolicy(const FileFlushPolicy& policy);
+        FileFlushPolicy GetFlushPolicy();
+        const std::string& GetFileName() const;
+    protected:
+        // 将缓冲写入文件，需持有m_mutex
+        void WriteBufferLocked();
+        // 记录追加进缓冲前的回调(持有m_mutex)，子类可在记录边界上切换文件
+        virtual void BeforeAppendLocked(size_t record_size);
+
+        std::mutex       m_mutex;
+        int              m_fd;
+        std::string      m_buffer;
+        int64_t          m_first_pending_ms;    // 缓冲中最早一条记录的写入时刻(单调时钟)，缓冲为空时为-1
+        uint64_t         m_file_bytes;          // 已写入当前fd的字节数(不含缓冲)
+        bool             m_timers_closed;       // 析构中，定时器回调不再续期(受m_mutex保护)
     private:
+        // 缓冲由空变为非空时在全局时间轮上挂一个max_latency_ms后的定时器(已挂起时不重复)，需持有m_mutex
+        void ArmLatencyTimerLocked(int64_t delay_ms);
+        void OnLatencyTimer();
+
         std::string      m_file_name;
-        std::ofstream    m_stream;
+        FileFlushPolicy  m_policy;
+        uint64_t         m_buffer_records; // 缓冲中的记录数，写入失败时计为丢弃
+        std::atomic<bool> m_emergency_flushed{false};
+        TimerId          m_latency_timer;  // 挂起中的延迟刷新定时器，0表示没有
     };
 
     /**
@@ -237,88 +618,321 @@ namespace dysv
         /// 构造函数、拷贝构造、赋值构造
         Logger(const std::string &name);
         Logger(const std::string &name, level::LevelEnum lv, const std::string& pt);
+        virtual ~Logger();
         // Logger(const Logger &lg) = delete;
         // Logger &operator=(const Logger &lg) = delete;
 
-        /// 落日志
+        /// 落日志。LogAdditionInfo以引用传入，稳定状态下一次调用不申请堆内存。
+        /// 级别在每条调用路径上只检查一次：以下公开入口在开头检查，*Impl与LogAt*不再检查，由调用方(入口或DY_LOG_*宏)保证
         // no format, no pattern
         void Log(level::LevelEnum lv, 
-                    const std::string& str);
+                    std::string_view str);
 
         // format, no pattern
         void Logf(level::LevelEnum lv, 
-                    const std::string& org_str, ...);
+                    const char* org_str, ...);
 
         // no format, pattern
+        void Log(const LogAdditionInfo& other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view str);
         void Log(LogAdditionInfo::ptr other_info, 
                     level::LevelEnum lv, 
-                    const std::string& str);
+                    std::string_view str);
 
         // format, pattern
+        void Logf(const LogAdditionInfo& other_info, 
+                    level::LevelEnum lv, 
+                    const char* org_str, ...);
         void Logf(LogAdditionInfo::ptr other_info, 
                     level::LevelEnum lv, 
-                    const std::string& org_str, ...);
+                    const char* org_str, ...);
 
-        // implement of function Log
-        void LogImpl(LogAdditionInfo::ptr other_info, 
+        // implement of function Log. 异步日志器重写此函数，仅将记录入队。other_info为空时不模式化，不检查级别
+        virtual void LogImpl(const LogAdditionInfo* other_info, 
                         level::LevelEnum lv, 
-                        const std::string& org_str);
+                        std::string_view org_str);
         
         // implement of function Logf
-        void LogImplf(LogAdditionInfo::ptr other_info, 
+        void LogImplf(const LogAdditionInfo* other_info, 
                         level::LevelEnum lv, 
-                        const std::string& org_str, 
+                        const char* org_str, 
                         va_list vargs);
 
+        // "{}"格式化(见dy_format.hpp), no pattern
+        template<class... Args>
+        void LogFmt(level::LevelEnum lv, 
+                    std::string_view org_str, const Args&... args){
+            if(CheckLevel(lv)){
+                LogFmtImpl(nullptr, lv, org_str, args...);
+            }
+        }
+
+        // "{}"格式化, pattern
+        template<class... Args>
+        void LogFmt(const LogAdditionInfo& other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view org_str, const Args&... args){
+            if(CheckLevel(lv)){
+                LogFmtImpl(&other_info, lv, org_str, args...);
+            }
+        }
+
+        /**
+         * @brief 经调用点记录日志(DY_LOG_FMT_*与DY_LOGF_*)。设置了二进制写入器时只记录调用点id、时间与参数的原始字节，
+         *        否则按style格式化后与Logf/LogFmt一样模式化并落地。宏已过滤级别，此处不再检查。
+         */
+        template<LogSite::FormatStyle style, class... Args>
+        void LogAt(const LogSite& site, const Args&... args){
+            static_assert(sizeof...(Args) < 256, "dysv: too many log arguments");
+            if(m_binary_writer){
+                const BinaryArg bin_args[] = {MakeBinaryArg(args)..., BinaryArg{BIN_BOOL, nullptr, nullptr}};
+                LogBinary(site, bin_args, sizeof...(Args));
+                return;
+            }
+            LogAdditionInfo info(site.file_name, site.line_num, site.func_name);
+            if constexpr(style == LogSite::BRACE){
+                LogFmtImpl(&info, site.lv, site.fmt, args...);
+            }else{
+                std::string& buf = GetFormatBuffer();
+                buf.clear();
+                FormatPrintf(buf, site.fmt, args...);
+                LogImpl(&info, site.lv, buf);
+            }
+        }
+
+        // 同Log(other_info, lv, str)，不检查级别。DY_LOG_*宏使用
+        void LogAt(const LogAdditionInfo& other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view str){
+            LogImpl(&other_info, lv, str);
+        }
+
+        // 同LogAt，suppressed非0时在内容末尾追加" (N suppressed)"。限频宏(dy_log_limit.hpp)使用，二进制模式下不追加
+        template<LogSite::FormatStyle style, class... Args>
+        void LogAtSuppressed(const LogSite& site, uint64_t suppressed, const Args&... args){
+            if(suppressed == 0 || m_binary_writer){
+                LogAt<style>(site, args...);
+                return;
+            }
+            std::string& buf = GetFormatBuffer();
+            buf.clear();
+            if constexpr(style == LogSite::BRACE){
+                fmt::FormatTo(buf, site.fmt, args...);
+            }else{
+                FormatPrintf(buf, site.fmt, args...);
+            }
+            AppendSuppressed(buf, suppressed);
+            LogAdditionInfo info(site.file_name, site.line_num, site.func_name);
+            LogImpl(&info, site.lv, buf);
+        }
+
+        /**
+         * @brief 结构化键值日志(DY_LOG_KV)。kvs为键、值交替的参数，键须为字符串;
+         *        字段编码追加在msg之后，由各LoggerPattern按自身编码输出。
+         */
+        template<class... KVs>
+        void LogKv(const LogAdditionInfo& other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view msg, const KVs&... kvs){
+            if(CheckLevel(lv)){
+                LogKvAt(other_info, lv, msg, kvs...);
+            }
+        }
+
+        // 同LogKv，不检查级别。DY_LOG_KV_*宏使用
+        template<class... KVs>
+        void LogKvAt(LogAdditionInfo other_info, 
+                    level::LevelEnum lv, 
+                    std::string_view msg, const KVs&... kvs){
+            static_assert(sizeof...(KVs) % 2 == 0, "dysv: DY_LOG_KV expects key-value pairs");
+            std::string& buf = GetFormatBuffer();
+            buf.assign(msg.data(), msg.size());
+            other_info.SetFieldsOffset((uint32_t)buf.size());
+            kv::AppendFields(buf, kvs...);
+            LogImpl(&other_info, lv, buf);
+        }
+
+        // 同LogAt(other_info, lv, str)，suppressed非0时在内容末尾追加" (N suppressed)"。限频宏使用，不检查级别
+        void LogSuppressed(const LogAdditionInfo& other_info, 
+                            level::LevelEnum lv, 
+                            std::string_view str, uint64_t suppressed);
+
+        // implement of function LogFmt
+        template<class... Args>
+        void LogFmtImpl(const LogAdditionInfo* other_info, 
+                        level::LevelEnum lv, 
+                        std::string_view org_str, const Args&... args){
+            std::string& buf = GetFormatBuffer();
+            buf.clear();
+            fmt::FormatTo(buf, org_str, args...);
+            LogImpl(other_info, lv, buf);
+        }
+
         /// 辅助函数
         void Reset();
         const std::string GetName();
+        // 将所有sink中已缓冲的日志落地
+        virtual void Flush();
+
+        /// 二进制模式(见dy_binary_log.hpp)，需在开始打印日志之前设置。为空时恢复文本模式
+        void SetBinaryWriter(std::shared_ptr<BinaryLogWriter> writer);
+        const std::shared_ptr<BinaryLogWriter>& GetBinaryWriter() const;
 
-        /// 日志模式相关
+        /// 日志模式相关。模式写时复制后整体替换，后台线程可能正在使用旧模式渲染，不要修改GetPattern返回的对象
         LoggerPattern::ptr GetPattern();
         void SetPattern(const std::string &pattern_str);
         void SetPattern(LoggerPattern::ptr pattern_ptr);
+        // 以复制后替换的方式修改当前模式的输出编码(见dy_log_kv.hpp)
+        void SetEncoding(LogEncoding encoding);
 
         /// 日志级别相关
         void SetLevel(level::LevelEnum lv);
         void SetLevel(const std::string &lv);
         level::LevelEnum GetLevel();
+        // 级别过滤：日志器级别与所有sink的最低级别。稳定时为三次relaxed原子读
+        bool ShouldLog(level::LevelEnum lv) const{
+            return lv >= m_level.load(std::memory_order_relaxed) && lv >= SinkMinLevel();
+        }
+        // 同ShouldLog，被过滤时计入统计。各公开打印入口使用
+        bool CheckLevel(level::LevelEnum lv){
+            return ShouldLog(lv) || CountFiltered();
+        }
+        // 被过滤的调用计入线程私有计数(不碰共享缓存行)，恒返回false。DY_LOG_*宏在ShouldLog为假时调用
+        bool CountFiltered(){
+            m_filtered.Add();
+            return false;
+        }
 
-        /// 日志sink相关
+        /// 运行时统计
+        LoggerStats GetStats();
+        // 尚未落地的记录数，同步日志器为0
+        virtual size_t GetQueueDepth() const;
+
+        /// 日志sink相关。读取走RCU快照，增删时复制整张表后原子替换，可与打印日志并发调用
+        // 不存在时返回nullptr
         LoggerSinkInterface::ptr GetLoggerSink(const std::string &name);
         void AddSink(LoggerSinkInterface::ptr sink);
         void DelSink(const std::string &name);
         void CleanSink();
+
+        // 崩溃处理调用(异步信号安全)：写出二进制写入器的缓冲，异步日志器另将队列中尚未落地的记录写给各sink
+        virtual void EmergencyDrain();
+    protected:
+        // 线程内复用的格式化缓冲
+        static std::string& GetFormatBuffer();
+        // "%d"风格格式化，追加到out末尾
+        static void FormatPrintf(std::string& out, const char* org_str, ...);
+        static void AppendSuppressed(std::string& out, uint64_t suppressed);
+
+        // 模式化并写入各个sink，同步日志器与异步日志器的后台线程共用
+        void SinkImpl(const LogAdditionInfo* other_info,
+                        level::LevelEnum lv,
+                        std::string_view org_str);
+
+        // 写入二进制写入器
+        void LogBinary(const LogSite& site, const BinaryArg* args, size_t nargs);
+
+        // 崩溃时(异步信号安全)按默认格式渲染一条记录，直接写给各sink
+        void EmergencySink(const LogAdditionInfo* other_info,
+                            level::LevelEnum lv,
+                            std::string_view org_str);
+
+        // 所有sink中最低的级别(设置了二进制写入器或没有sink时为TRACE)，按sink级别代数缓存
+        level::LevelEnum SinkMinLevel() const{
+            uint64_t cache = m_sink_level_cache.load(std::memory_order_relaxed);
+            if((cache >> 8) != LoggerSinkInterface::GetLevelGeneration()){
+                return RefreshSinkMinLevel();
+            }
+            return (level::LevelEnum)(cache & 0xFF);
+        }
+        level::LevelEnum RefreshSinkMinLevel() const;
+
+        void CountAccepted(){ m_stats.Add(STAT_ACCEPTED); }
+        void CountDropped(uint64_t n = 1){ m_stats.Add(STAT_DROPPED, n); }
+        // 自上次报告以来有记录被丢弃时，向各sink写一条"N records dropped"的WARN日志并返回true。仅由后台线程调用
+        bool ReportDropped(const char* reason);
     private:
+        enum StatField{
+            STAT_ACCEPTED = 0,
+            STAT_DROPPED,
+            STAT_FIELD_COUNT
+        };
+
+        using SinkMap = std::map<std::string, LoggerSinkInterface::ptr>;
+
         std::string m_name;
-        level::LevelEnum m_level;
-        std::map<std::string, LoggerSinkInterface::ptr> m_sinks;
-        LoggerPattern::ptr m_pattern;
+        std::atomic<level::LevelEnum> m_level;
+        RcuPtr<SinkMap> m_sinks;        // 当前sink表快照，只读
+        std::mutex m_sink_mutex;        // 串行化sink表的修改
+        mutable std::atomic<uint64_t> m_sink_level_cache{0};   // (sink级别代数 << 8) | sink最低级别
+        RcuPtr<LoggerPattern::ptr> m_pattern;   // 写时替换，SinkImpl在读临界区内取用
+        std::mutex m_pattern_mutex;     // 串行化模式的读-改-写
+        std::shared_ptr<BinaryLogWriter> m_binary_writer;
+        StripedCounters<STAT_FIELD_COUNT> m_stats;
+        ThreadCounter m_filtered;           // 被级别过滤的调用数
+        uint64_t m_reported_drops = 0;      // 已报告过的丢弃数
     };
 
 
     /**
-     * @brief 管理所有的日志器。
+     * @brief 管理所有的日志器。查询不加锁(RCU快照)，增删与替换默认日志器由m_mutex串行化。
      * 
      */
     class LoggerManger
     {
     public:
         LoggerManger();
+        ~LoggerManger();
 
-        dysv::Logger::ptr GetDefaultLog();
+        // 返回裸指针，打印日志时仅一次原子读，没有shared_ptr引用计数的原子操作。
+        // 被替换下来的默认日志器不会析构，已取得的指针始终有效
+        dysv::Logger* GetDefaultLog(){
+            return m_default_logger.load(std::memory_order_acquire);
+        }
 
         void SetDefaultLog(Logger::ptr logger);
 
+        // 同名日志器已存在时返回false
         bool AddLogger(Logger::ptr logger);
 
         bool DelLogger(const std::string &name);
 
+        // 不存在时返回nullptr，不会插入
         Logger::ptr GetLogger(const std::string& name);
+
+        /// 运行时统计
+        // 所有已注册的日志器(及未注册的默认日志器)的统计快照
+        LogStatsSnapshot Snapshot();
+        // 每隔interval_ms把区间统计(LogStatsSnapshot::Since)直接写入sink，不经过任何日志器。再次调用替换之前的设置
+        void StartStatsReport(LoggerSinkInterface::ptr sink, uint32_t interval_ms);
+        void StopStatsReport();
+
+        /// 后台刷新
+        // 每隔interval_ms把各日志器的Flush作为任务提交到线程池(../common/dy_executor.hpp)，
+        // 由全局时间轮上的周期定时器触发，不占用单独的线程; 上一轮尚未完成时跳过本轮。再次调用替换之前的设置
+        void StartBackgroundFlush(std::shared_ptr<Executor> executor, uint32_t interval_ms);
+        void StopBackgroundFlush();
     private:
-        // TODO:lock
-        Logger::ptr m_default_logger;
-        std::map<std::string, Logger::ptr> m_loggers;
+        void StatsReportLoop(LoggerSinkInterface::ptr sink, uint32_t interval_ms);
+        // 一轮后台刷新，pending为尚未完成的刷新任务数
+        void BackgroundFlushOnce(const std::shared_ptr<Executor>& executor,
+                                 const std::shared_ptr<std::atomic<size_t>>& pending);
+
+        using LoggerMap = std::map<std::string, Logger::ptr>;
+
+        std::atomic<Logger*>        m_default_logger;
+        std::vector<Logger::ptr>    m_default_holders;  // 当前及历任默认日志器，保证GetDefaultLog返回的指针不失效
+        RcuPtr<LoggerMap>           m_loggers;
+        std::mutex                  m_mutex;
+
+        std::thread                 m_report_thread;
+        std::mutex                  m_report_mutex;
+        std::condition_variable     m_report_cv;
+        bool                        m_report_stop;
+
+        std::mutex                  m_flush_mutex;
+        TimerId                     m_flush_timer;      // 后台刷新的周期定时器，0表示未启动
     };
 
 
@@ -328,21 +942,43 @@ namespace dysv
 #define STD_COUT_NAME                    "__stdout__"
 #define DEFAULT_LOGGER_MANGER            (dysv::LoggerMgr::GetInstance())
 #define DEFAULT_LOGGER                   (dysv::LoggerMgr::GetInstance()->GetDefaultLog())
-#define ADD_ADDITION_INFO                std::make_shared<dysv::LogAdditionInfo>(__FILE__, __LINE__)
+#define ADD_ADDITION_INFO                (dysv::LogAdditionInfo(__FILE__, __LINE__, __func__))
 
     // no format, no pattern
-    void trace(const std::string &str);
-    void info(const std::string &str);
-    void warn(const std::string &str);
-    void error(const std::string &str);
-    void fatal(const std::string &str);
+    void trace(std::string_view str);
+    void info(std::string_view str);
+    void warn(std::string_view str);
+    void error(std::string_view str);
+    void fatal(std::string_view str);
 
     // format, no pattern
-    void fmt_trace(const std::string &str, ...);
-    void fmt_info(const std::string &str, ...);
-    void fmt_warn(const std::string &str, ...);
-    void fmt_error(const std::string &str, ...);
-    void fmt_fatal(const std::string &str, ...);
+    void fmt_trace(const char* str, ...);
+    void fmt_info(const char* str, ...);
+    void fmt_warn(const char* str, ...);
+    void fmt_error(const char* str, ...);
+    void fmt_fatal(const char* str, ...);
+
+    // "{}" format, no pattern. 格式串在运行期解析，不匹配的占位符输出"{?}"
+    template<class T, class... Args>
+    void trace(std::string_view str, const T& arg, const Args&... args){
+        DEFAULT_LOGGER->LogFmt(level::TRACE, str, arg, args...);
+    }
+    template<class T, class... Args>
+    void info(std::string_view str, const T& arg, const Args&... args){
+        DEFAULT_LOGGER->LogFmt(level::INFO, str, arg, args...);
+    }
+    template<class T, class... Args>
+    void warn(std::string_view str, const T& arg, const Args&... args){
+        DEFAULT_LOGGER->LogFmt(level::WARN, str, arg, args...);
+    }
+    template<class T, class... Args>
+    void error(std::string_view str, const T& arg, const Args&... args){
+        DEFAULT_LOGGER->LogFmt(level::ERROR, str, arg, args...);
+    }
+    template<class T, class... Args>
+    void fatal(std::string_view str, const T& arg, const Args&... args){
+        DEFAULT_LOGGER->LogFmt(level::FATAL, str, arg, args...);
+    }
 
     void set_level(level::LevelEnum lv);
     void set_default_logger(Logger::ptr lg);
@@ -350,21 +986,143 @@ namespace dysv
     void add_sink(LoggerSinkInterface::ptr sink);
     void clean_sink();
 
+    /**
+     * @brief 级别过滤。DY_LOG_*宏先经ShouldLog做一次原子读与分支(被过滤时计入线程私有的统计)，被过滤的语句不构造LogAdditionInfo，
+     *        也不对参数求值，放行的语句经LogAt*落地，不再重复检查; 低于编译期级别DYSV_ACTIVE_LEVEL(由CMake变量DYSV_ACTIVE_LEVEL设置)的语句被整体移除。
+     * 
+     */
+#define DY_LOG_ENABLED(lv)               ((int)(lv) >= DYSV_ACTIVE_LEVEL && \
+                                            (DEFAULT_LOGGER->ShouldLog(lv) || DEFAULT_LOGGER->CountFiltered()))
+
+    /**
+     * @brief 调用点的静态描述，首次执行时注册。__func__经初始化捕获取自外层函数;
+     *        txt须为字面量(引用局部变量的格式串无法通过编译)。
+     * 
+     */
+#define DY_LOG_SITE(lv, style, txt)      DY_LOG_SITE_IN(lv, style, txt, __func__)
+#define DY_LOG_SITE_IN(lv, style, txt, func)                                                                                      \
+                                         ([dysv_func = func]() -> const dysv::LogSite& {                                          \
+                                            static const dysv::LogSite dysv_site(lv, style, __FILE__, __LINE__, dysv_func, txt);  \
+                                            return dysv_site; }())
+
     // format, pattern
-#define DY_LOG_FMT_LEVEL(lv, txt, ...)   (DEFAULT_LOGGER->Logf(std::make_shared<dysv::LogAdditionInfo>(__FILE__, __LINE__), lv, txt, __VA_ARGS__))
+#define DY_LOG_FMT_LEVEL(lv, txt, ...)   (DY_LOG_ENABLED(lv) ? DEFAULT_LOGGER->LogAt<dysv::LogSite::PRINTF>(                     \
+                                            DY_LOG_SITE(lv, dysv::LogSite::PRINTF, txt), __VA_ARGS__) : (void)0)
+
+    // "{}" format, pattern. 格式串须为字面量，编译期校验占位符与参数的个数和类型
+#define DY_LOGF_CHECK(txt, ...)          ((void)sizeof(dysv::fmt::FormatChecked<dysv::fmt::CheckFormat(decltype(dysv::fmt::ArgTypes(__VA_ARGS__)){}, txt)>))
+#define DY_LOGF_LEVEL(lv, txt, ...)      (DY_LOGF_CHECK(txt, ##__VA_ARGS__), \
+                                            DY_LOG_ENABLED(lv) ? DEFAULT_LOGGER->LogAt<dysv::LogSite::BRACE>(                     \
+                                            DY_LOG_SITE(lv, dysv::LogSite::BRACE, txt), ##__VA_ARGS__) : (void)0)
+
+    // no format, pattern
+#define DY_LOG_LEVEL(lv, txt)            (DY_LOG_ENABLED(lv) ? DEFAULT_LOGGER->LogAt(ADD_ADDITION_INFO, lv, txt) : (void)0)
+
+    // key-value, pattern. lv为TRACE/INFO/WARN/ERROR/FATAL，eg. DY_LOG_KV(INFO, "login", "user", id, "cost_us", t)
+#define DY_LOG_KV_LEVEL(lv, msg, ...)    (DY_LOG_ENABLED(lv) ? DEFAULT_LOGGER->LogKvAt(ADD_ADDITION_INFO, lv, msg, ##__VA_ARGS__) : (void)0)
+#define DY_LOG_KV(lv, msg, ...)          DY_LOG_KV_##lv(msg, ##__VA_ARGS__)
+
+#if DYSV_ACTIVE_LEVEL <= DYSV_LEVEL_TRACE
 #define DY_LOG_FMT_TRACE(txt,...)        (DY_LOG_FMT_LEVEL(dysv::level::TRACE, txt, __VA_ARGS__))
+#define DY_LOGF_TRACE(txt, ...)          (DY_LOGF_LEVEL(dysv::level::TRACE, txt, ##__VA_ARGS__))
+#define DY_LOG_TRACE(txt)                (DY_LOG_LEVEL(dysv::level::TRACE, txt))
+#define DY_LOG_KV_TRACE(msg, ...)        (DY_LOG_KV_LEVEL(dysv::level::TRACE, msg, ##__VA_ARGS__))
+#else
+#define DY_LOG_FMT_TRACE(txt,...)        ((void)0)
+#define DY_LOGF_TRACE(txt, ...)          ((void)0)
+#define DY_LOG_TRACE(txt)                ((void)0)
+#define DY_LOG_KV_TRACE(msg, ...)        ((void)0)
+#endif
+
+#if DYSV_ACTIVE_LEVEL <= DYSV_LEVEL_INFO
 #define DY_LOG_FMT_INFO(txt,...)         (DY_LOG_FMT_LEVEL(dysv::level::INFO,  txt, __VA_ARGS__))
+#define DY_LOGF_INFO(txt, ...)           (DY_LOGF_LEVEL(dysv::level::INFO,  txt, ##__VA_ARGS__))
+#define DY_LOG_INFO(txt)                 (DY_LOG_LEVEL(dysv::level::INFO,  txt))
+#define DY_LOG_KV_INFO(msg, ...)         (DY_LOG_KV_LEVEL(dysv::level::INFO,  msg, ##__VA_ARGS__))
+#else
+#define DY_LOG_FMT_INFO(txt,...)         ((void)0)
+#define DY_LOGF_INFO(txt, ...)           ((void)0)
+#define DY_LOG_INFO(txt)                 ((void)0)
+#define DY_LOG_KV_INFO(msg, ...)         ((void)0)
+#endif
+
+#if DYSV_ACTIVE_LEVEL <= DYSV_LEVEL_WARN
 #define DY_LOG_FMT_WARN(txt,...)         (DY_LOG_FMT_LEVEL(dysv::level::WARN,  txt, __VA_ARGS__))
+#define DY_LOGF_WARN(txt, ...)           (DY_LOGF_LEVEL(dysv::level::WARN,  txt, ##__VA_ARGS__))
+#define DY_LOG_WARN(txt)                 (DY_LOG_LEVEL(dysv::level::WARN,  txt))
+#define DY_LOG_KV_WARN(msg, ...)         (DY_LOG_KV_LEVEL(dysv::level::WARN,  msg, ##__VA_ARGS__))
+#else
+#define DY_LOG_FMT_WARN(txt,...)         ((void)0)
+#define DY_LOGF_WARN(txt, ...)           ((void)0)
+#define DY_LOG_WARN(txt)                 ((void)0)
+#define DY_LOG_KV_WARN(msg, ...)         ((void)0)
+#endif
+
+#if DYSV_ACTIVE_LEVEL <= DYSV_LEVEL_ERROR
 #define DY_LOG_FMT_ERROR(txt,...)        (DY_LOG_FMT_LEVEL(dysv::level::ERROR, txt, __VA_ARGS__))
+#define DY_LOGF_ERROR(txt, ...)          (DY_LOGF_LEVEL(dysv::level::ERROR, txt, ##__VA_ARGS__))
+#define DY_LOG_ERROR(txt)                (DY_LOG_LEVEL(dysv::level::ERROR, txt))
+#define DY_LOG_KV_ERROR(msg, ...)        (DY_LOG_KV_LEVEL(dysv::level::ERROR, msg, ##__VA_ARGS__))
+#else
+#define DY_LOG_FMT_ERROR(txt,...)        ((void)0)
+#define DY_LOGF_ERROR(txt, ...)          ((void)0)
+#define DY_LOG_ERROR(txt)                ((void)0)
+#define DY_LOG_KV_ERROR(msg, ...)        ((void)0)
+#endif
+
+#if DYSV_ACTIVE_LEVEL <= DYSV_LEVEL_FATAL
 #define DY_LOG_FMT_FATAL(txt,...)        (DY_LOG_FMT_LEVEL(dysv::level::FATAL, txt, __VA_ARGS__))
+#define DY_LOGF_FATAL(txt, ...)          (DY_LOGF_LEVEL(dysv::level::FATAL, txt, ##__VA_ARGS__))
+#define DY_LOG_FATAL(txt)                (DY_LOG_LEVEL(dysv::level::FATAL, txt))
+#define DY_LOG_KV_FATAL(msg, ...)        (DY_LOG_KV_LEVEL(dysv::level::FATAL, msg, ##__VA_ARGS__))
+#else
+#define DY_LOG_FMT_FATAL(txt,...)        ((void)0)
+#define DY_LOGF_FATAL(txt, ...)          ((void)0)
+#define DY_LOG_FATAL(txt)                ((void)0)
+#define DY_LOG_KV_FATAL(msg, ...)        ((void)0)
+#endif
 
-    // no format, pattern
-#define DY_LOG_LEVEL(lv, txt)   (DEFAULT_LOGGER->Log(std::make_shared<dysv::LogAdditionInfo>(__FILE__, __LINE__), lv, txt))
-#define DY_LOG_TRACE(txt)       (DY_LOG_LEVEL(dysv::level::TRACE, txt))
-#define DY_LOG_INFO(txt)        (DY_LOG_LEVEL(dysv::level::INFO,  txt))
-#define DY_LOG_WARN(txt)        (DY_LOG_LEVEL(dysv::level::WARN,  txt))
-#define DY_LOG_ERROR(txt)       (DY_LOG_LEVEL(dysv::level::ERROR, txt))
-#define DY_LOG_FATAL(txt)       (DY_LOG_LEVEL(dysv::level::FATAL, txt))
+    /**
+     * @brief 限频与采样(见dy_log_limit.hpp)。lv为dysv::level::*，限频参数须为常量，调用点首次执行时确定。
+     *        先过滤级别(被过滤的不计入抑制次数)，再经调用点的静态限频器判定; 放行时才构造附加信息并对参数求值。
+     *
+     */
+#define DY_LOG_LIMITER(type, ...)        ([]() -> type& { static type dysv_limiter(__VA_ARGS__); return dysv_limiter; }())
+#define DY_LOG_LIMITED_(lv, limiter, txt)                                                                                         \
+                                         (DY_LOG_ENABLED(lv) ? dysv::LogLimited(limiter, __func__,                                \
+                                            [&](const char* dysv_func, uint64_t dysv_suppressed){                                 \
+                                                DEFAULT_LOGGER->LogSuppressed(dysv::LogAdditionInfo(__FILE__, __LINE__, dysv_func), \
+                                                    lv, txt, dysv_suppressed); }) : (void)0)
+#define DY_LOG_FMT_LIMITED_(lv, limiter, txt, ...)                                                                                \
+                                         (DY_LOG_ENABLED(lv) ? dysv::LogLimited(limiter, __func__,                                \
+                                            [&](const char* dysv_func, uint64_t dysv_suppressed){                                 \
+                                                DEFAULT_LOGGER->LogAtSuppressed<dysv::LogSite::PRINTF>(                           \
+                                                    DY_LOG_SITE_IN(lv, dysv::LogSite::PRINTF, txt, dysv_func), dysv_suppressed,   \
+                                                    __VA_ARGS__); }) : (void)0)
+#define DY_LOGF_LIMITED_(lv, limiter, txt, ...)                                                                                   \
+                                         (DY_LOGF_CHECK(txt, ##__VA_ARGS__),                                                      \
+                                            DY_LOG_ENABLED(lv) ? dysv::LogLimited(limiter, __func__,                              \
+                                            [&](const char* dysv_func, uint64_t dysv_suppressed){                                 \
+                                                DEFAULT_LOGGER->LogAtSuppressed<dysv::LogSite::BRACE>(                            \
+                                                    DY_LOG_SITE_IN(lv, dysv::LogSite::BRACE, txt, dysv_func), dysv_suppressed     \
+                                                    , ##__VA_ARGS__); }) : (void)0)
+
+    // 第1次及此后每n次落地一次
+#define DY_LOG_EVERY_N(lv, n, txt)                   DY_LOG_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogEveryN, n), txt)
+#define DY_LOG_FMT_EVERY_N(lv, n, txt, ...)          DY_LOG_FMT_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogEveryN, n), txt, __VA_ARGS__)
+#define DY_LOGF_EVERY_N(lv, n, txt, ...)             DY_LOGF_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogEveryN, n), txt, ##__VA_ARGS__)
+    // 只落地前n次
+#define DY_LOG_FIRST_N(lv, n, txt)                   DY_LOG_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogFirstN, n), txt)
+#define DY_LOG_FMT_FIRST_N(lv, n, txt, ...)          DY_LOG_FMT_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogFirstN, n), txt, __VA_ARGS__)
+#define DY_LOGF_FIRST_N(lv, n, txt, ...)             DY_LOGF_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogFirstN, n), txt, ##__VA_ARGS__)
+    // 每ms毫秒至多落地一次
+#define DY_LOG_EVERY_MS(lv, ms, txt)                 DY_LOG_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogEveryMs, ms), txt)
+#define DY_LOG_FMT_EVERY_MS(lv, ms, txt, ...)        DY_LOG_FMT_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogEveryMs, ms), txt, __VA_ARGS__)
+#define DY_LOGF_EVERY_MS(lv, ms, txt, ...)           DY_LOGF_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogEveryMs, ms), txt, ##__VA_ARGS__)
+    // 令牌桶：每秒rate条，突发至多burst条
+#define DY_LOG_RATE_LIMITED(lv, rate, burst, txt)            DY_LOG_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogRateLimited, rate, burst), txt)
+#define DY_LOG_FMT_RATE_LIMITED(lv, rate, burst, txt, ...)   DY_LOG_FMT_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogRateLimited, rate, burst), txt, __VA_ARGS__)
+#define DY_LOGF_RATE_LIMITED(lv, rate, burst, txt, ...)      DY_LOGF_LIMITED_(lv, DY_LOG_LIMITER(dysv::LogRateLimited, rate, burst), txt, ##__VA_ARGS__)
 
 #define SET_LEVEL(lv)                (DEFAULT_LOGGER->SetLevel(lv))
 #define SET_DEFAULT_LOGGER(lg)       (DEFAULT_LOGGER_MANGER->SetDefaultLog(lg))
@@ -0,0 +1,128 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "dy_format.hpp"
+
+/**
+ * @brief 结构化键值日志(DY_LOG_KV)。
+ * @feature 键值对在调用处按类型编码为与输出格式无关的字段区，追加在日志内容之后，随记录一起经过异步队列;
+ *          落地时由LoggerPattern按其编码(文本/JSON/logfmt)直接写入输出缓冲;
+ *          字符串以SSE2每次扫描16字节，定位需要转义的字节，其间的片段整段拷贝。
+ * @example
+ *      DEFAULT_LOGGER->SetEncoding(dysv::ENCODING_JSON);
+ *      DY_LOG_KV(INFO, "request served", "user", id, "path", path, "latency_us", t);
+ *      // {"time":"2022/02/08 12:49:31","us":"394116","thread":8065,...,"msg":"request served","user":42,"path":"/a\"b","latency_us":17}
+ *      // logfmt: time="2022/02/08 12:49:31" us=394116 thread=8065 ... msg="request served" user=42 path="/a\"b" latency_us=17
+ *      // 文本:    [2022/02/08 12:49:31:394116][8065]...[request served user=42 path="/a\"b" latency_us=17]
+ * @format 字段区: 逐个字段 [u8类别][u16键长度][键][u32值长度][值]，长度为本机字节序。
+ *          值在调用处已转为文本，类别决定输出时是否加引号转义。
+ */
+
+namespace dysv
+{
+    /**
+     * @brief 日志输出编码，由LoggerPattern选择。
+     *
+     */
+    enum LogEncoding{
+        ENCODING_TEXT = 0,  // 按模式串输出，字段以" k=v"接在日志内容之后
+        ENCODING_JSON,      // 每条日志一个JSON对象，模式串中的占位符依次成为键，字面量忽略
+        ENCODING_LOGFMT,    // 同JSON，以"k=v"空格分隔输出
+    };
+
+namespace kv
+{
+    enum FieldKind : uint8_t{
+        FIELD_RAW = 0,      // 数值/布尔/null，原样输出
+        FIELD_STRING,       // 字符串，按编码加引号转义
+    };
+
+#define KV_FIELD_HEADER_SIZE    (1 + sizeof(uint16_t))
+#define KV_VALUE_LEN_SIZE       sizeof(uint32_t)
+
+    // 值已是文本时，一次扩容写入整个字段
+    inline void AppendFieldText(std::string& out, std::string_view key, std::string_view val, FieldKind kind){
+        uint16_t key_len = (uint16_t)(key.size() < UINT16_MAX ? key.size() : UINT16_MAX);
+        uint32_t val_len = (uint32_t)val.size();
+        size_t old_size = out.size();
+        out.resize(old_size + KV_FIELD_HEADER_SIZE + key_len + KV_VALUE_LEN_SIZE + val_len);
+        char* p = &out[old_size];
+        *p++ = (char)kind;
+        memcpy(p, &key_len, sizeof(key_len));
+        p += sizeof(key_len);
+        memcpy(p, key.data(), key_len);
+        p += key_len;
+        memcpy(p, &val_len, sizeof(val_len));
+        p += sizeof(val_len);
+        memcpy(p, val.data(), val_len);
+    }
+
+    /**
+     * @brief 向字段区追加一个字段。值的类型与"{}"格式化一致(见dy_format.hpp)，自定义类型需特化fmt::Formatter。
+     *        布尔/整数/字符串直接写入，不经过格式串解析。
+     *
+     */
+    template<class T>
+    inline void AppendField(std::string& out, std::string_view key, const T& val){
+        using D = std::decay_t<T>;
+        constexpr fmt::ArgKind kind = fmt::KindOf<D>();
+        if constexpr(kind == fmt::KIND_BOOL){
+            AppendFieldText(out, key, val ? std::string_view("true", 4) : std::string_view("false", 5), FIELD_RAW);
+        }else if constexpr((kind == fmt::KIND_INT || kind == fmt::KIND_UINT) && !std::is_enum<D>::value){
+            char digits[24];
+            auto res = std::to_chars(digits, digits + sizeof(digits), val);
+            AppendFieldText(out, key, std::string_view(digits, res.ptr - digits), FIELD_RAW);
+        }else if constexpr(kind == fmt::KIND_STRING){
+            AppendFieldText(out, key, std::string_view(val), FIELD_STRING);
+        }else if constexpr(std::is_null_pointer<D>::value){
+            AppendFieldText(out, key, std::string_view("null", 4), FIELD_RAW);
+        }else{
+            FieldKind field_kind = FIELD_STRING;
+            if constexpr(kind == fmt::KIND_INT || kind == fmt::KIND_UINT){
+                field_kind = FIELD_RAW;
+            }else if constexpr(kind == fmt::KIND_FLOAT){
+                // nan/inf不是合法的JSON数值，按字符串输出
+                field_kind = std::isfinite(val) ? FIELD_RAW : FIELD_STRING;
+            }
+            // 值直接格式化到输出缓冲，再回填长度
+            AppendFieldText(out, key, std::string_view(), field_kind);
+            size_t len_pos = out.size() - KV_VALUE_LEN_SIZE;
+            fmt::FormatTo(out, "{}", val);
+            uint32_t val_len = (uint32_t)(out.size() - len_pos - KV_VALUE_LEN_SIZE);
+            memcpy(&out[len_pos], &val_len, sizeof(val_len));
+        }
+    }
+
+    inline void AppendFields(std::string&){}
+
+    template<class K, class V, class... Rest>
+    inline void AppendFields(std::string& out, const K& key, const V& val, const Rest&... rest){
+        static_assert(fmt::IsStringLike<std::decay_t<K>>::value, "dysv: DY_LOG_KV keys must be strings");
+        AppendField(out, std::string_view(key), val);
+        AppendFields(out, rest...);
+    }
+
+    /**
+     * @brief 返回[data, data+len)中第一个需要处理的字节下标，没有时返回len。
+     *        JSON需转义'"'、'\\'与控制字符; for_logfmt时另含' '与'='(值需加引号)。
+     *
+     */
+    size_t FindEscape(const char* data, size_t len, bool for_logfmt);
+
+    // 追加带引号并转义的JSON字符串
+    void AppendJsonString(std::string& out, std::string_view str);
+    // 追加logfmt值：无需处理的原样输出，否则按JSON规则加引号转义。空串输出""
+    void AppendLogfmtValue(std::string& out, std::string_view str);
+    // 按编码输出单个键值对。JSON为"k":v，其余为k=v
+    void AppendKeyValue(std::string& out, LogEncoding encoding, std::string_view key, std::string_view val, FieldKind kind);
+    /**
+     * @brief 按编码输出字段区中的所有字段。JSON时每个字段前加','，其余加' '。
+     *
+     * @param need_sep 第一个字段前是否需要分隔符
+     */
+    void RenderFields(std::string& out, LogEncoding encoding, std::string_view fields, bool need_sep);
+} // namespace kv
+} // namespace dysv
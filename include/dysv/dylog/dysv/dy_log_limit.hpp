@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+/**
+ * @brief 调用点级别的限频与采样(DY_LOG_EVERY_N / DY_LOG_FIRST_N / DY_LOG_EVERY_MS / DY_LOG_RATE_LIMITED及其格式化版本)。
+ * @feature 每个调用点一个静态的限频器，状态均为原子量，多线程共用无锁;
+ *          被抑制的调用只有级别判断与一两次原子操作，不构造LogAdditionInfo，也不对参数求值;
+ *          放行的日志末尾追加" (N suppressed)"，N为自上一条放行以来被抑制的次数(二进制模式下不追加)。
+ * @example
+ *      for(...){
+ *          DY_LOG_EVERY_N(dysv::level::WARN, 1000, "queue is full");               // 第1, 1001, 2001...次落地
+ *          DY_LOGF_EVERY_MS(dysv::level::WARN, 500, "retry {} failed", retry);     // 每500ms至多一条
+ *          DY_LOG_FMT_FIRST_N(dysv::level::INFO, 3, "slow path: %d", n);           // 只落地前3次
+ *          DY_LOGF_RATE_LIMITED(dysv::level::ERROR, 10, 20, "bad packet from {}", peer); // 令牌桶: 每秒10条，突发20条
+ *      }
+ */
+
+namespace dysv
+{
+    /**
+     * @brief 限频器公共部分：累计被抑制的次数，放行时取出并清零。
+     *
+     */
+    class LogLimiterBase
+    {
+    public:
+        // 放行时调用，取出自上次放行以来被抑制的次数
+        uint64_t TakeSuppressed(){
+            return m_suppressed.load(std::memory_order_relaxed) == 0 ? 0 : m_suppressed.exchange(0, std::memory_order_relaxed);
+        }
+    protected:
+        bool Suppress(){
+            m_suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // 粗粒度时钟(通常1~4ms精度)，读取不到普通时钟的一半开销，对限频足够
+        static int64_t NowNs(){
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+        }
+    private:
+        std::atomic<uint64_t>   m_suppressed{0};
+    };
+
+    // 第1次及此后每n次放行一次
+    class LogEveryN : public LogLimiterBase
+    {
+    public:
+        explicit LogEveryN(uint64_t n) : m_n(n > 0 ? n : 1){}
+        bool Allow(){
+            return m_count.fetch_add(1, std::memory_order_relaxed) % m_n == 0 ? true : Suppress();
+        }
+    private:
+        const uint64_t          m_n;
+        std::atomic<uint64_t>   m_count{0};
+    };
+
+    // 只放行前n次。用尽后只剩一次读与一次计数
+    class LogFirstN : public LogLimiterBase
+    {
+    public:
+        explicit LogFirstN(uint64_t n) : m_n(n){}
+        bool Allow(){
+            if(m_count.load(std::memory_order_relaxed) >= m_n){
+                return Suppress();
+            }
+            return m_count.fetch_add(1, std::memory_order_relaxed) < m_n ? true : Suppress();
+        }
+    private:
+        const uint64_t          m_n;
+        std::atomic<uint64_t>   m_count{0};
+    };
+
+    // 每ms毫秒至多放行一次，首次调用总是放行
+    class LogEveryMs : public LogLimiterBase
+    {
+    public:
+        explicit LogEveryMs(uint64_t ms) : m_interval_ns((int64_t)ms * 1000000LL){}
+        bool Allow(){
+            int64_t now = NowNs();
+            int64_t next = m_next_ns.load(std::memory_order_relaxed);
+            if(now < next){
+                return Suppress();
+            }
+            // 同一时刻多个线程到期时只有一个放行
+            return m_next_ns.compare_exchange_strong(next, now + m_interval_ns, std::memory_order_relaxed) ? true : Suppress();
+        }
+    private:
+        const int64_t           m_interval_ns;
+        std::atomic<int64_t>    m_next_ns{0};
+    };
+
+    /**
+     * @brief 令牌桶：每秒补充rate个令牌，桶容量burst。以GCRA实现，状态只有一个"理论到达时间"，
+     *        放行为一次CAS，不需要额外的补充线程。
+     *
+     */
+    class LogRateLimited : public LogLimiterBase
+    {
+    public:
+        LogRateLimited(double rate, uint64_t burst)
+            : m_interval_ns(rate > 0 ? (int64_t)(1e9 / rate) : INT64_MAX / 4)
+            , m_tolerance_ns(rate > 0 && burst > 0 ? m_interval_ns * (int64_t)(burst - 1) : 0){}
+        bool Allow(){
+            int64_t now = NowNs();
+            int64_t tat = m_tat_ns.load(std::memory_order_relaxed);
+            for(;;){
+                int64_t base = tat > now ? tat : now;
+                if(base - now > m_tolerance_ns){
+                    return Suppress();
+                }
+                if(m_tat_ns.compare_exchange_weak(tat, base + m_interval_ns, std::memory_order_relaxed)){
+                    return true;
+                }
+            }
+        }
+    private:
+        const int64_t           m_interval_ns;      // 每个令牌的间隔
+        const int64_t           m_tolerance_ns;     // 允许超前的时长，即burst-1个令牌
+        std::atomic<int64_t>    m_tat_ns{0};        // 下一个令牌的理论到达时间
+    };
+
+    // 放行时以(调用处函数名, 被抑制次数)调用emit。emit内才对日志参数求值
+    template<class Limiter, class Emit>
+    inline void LogLimited(Limiter& limiter, const char* func, Emit&& emit){
+        if(limiter.Allow()){
+            emit(func, limiter.TakeSuppressed());
+        }
+    }
+} // namespace dysv
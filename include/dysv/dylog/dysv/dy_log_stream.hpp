@@ -0,0 +1,136 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "dy_log.hpp"
+
+/**
+ * @brief 流式日志。
+ * @feature 每条记录写入线程内复用的缓冲，稳定后不再申请内存; 整数/浮点/字符串/bool/字符及特化了fmt::Formatter的类型
+ *          直接写入缓冲，不经过std::ostream与locale; 其余类型(只提供了operator<<(std::ostream&)的类型、流操纵符)
+ *          经线程内复用的std::ostream写入同一缓冲;
+ *          临时对象析构时提交给日志器; DY_LOG_STREAM_*被级别过滤时整条语句跳过，不对任何操作数求值。
+ * @note 浮点按最短可还原的形式输出，bool输出true/false，与"{}"格式化一致(与std::ostream的默认行为不同)。
+ * @example
+ *      DY_LOG_STREAM_INFO << "user " << id << " served in " << cost_us << "us";
+ *      dysv::infoStream() << "no pattern, " << 42;     // 同dysv::info，不模式化，操作数总会求值
+ */
+
+namespace dysv
+{
+    /**
+     * @brief 追加到外部std::string的streambuf，供std::ostream回退路径使用。
+     *
+     */
+    class LogStreamBuf : public std::streambuf
+    {
+    public:
+        void SetTarget(std::string* target){ m_target = target; }
+    protected:
+        int_type overflow(int_type ch) override;
+        std::streamsize xsputn(const char* s, std::streamsize n) override;
+    private:
+        std::string*    m_target = nullptr;
+    };
+
+    /**
+     * @brief 一条流式日志记录，析构时提交。不可拷贝，仅作为临时对象使用。
+     *
+     */
+    class LogStream
+    {
+    public:
+        // 模式化。DY_LOG_STREAM_*宏已过滤级别，此处不再检查
+        LogStream(Logger* logger, const LogAdditionInfo& other_info, level::LevelEnum lv);
+        // 不模式化，构造时检查级别
+        LogStream(Logger* logger, level::LevelEnum lv);
+        ~LogStream();
+        LogStream(const LogStream&) = delete;
+        LogStream& operator=(const LogStream&) = delete;
+
+        template<class T>
+        LogStream& operator<<(const T& val){
+            using D = std::decay_t<T>;
+            if(!m_enabled){
+                return *this;
+            }
+            constexpr bool is_char = std::is_same<D, char>::value || std::is_same<D, signed char>::value
+                                        || std::is_same<D, unsigned char>::value;
+            constexpr bool is_cstr = std::is_same<D, const char*>::value || std::is_same<D, char*>::value;
+            constexpr bool is_str = std::is_same<D, std::string>::value || std::is_same<D, std::string_view>::value;
+            constexpr bool is_number = std::is_integral<D>::value || std::is_floating_point<D>::value;
+            if constexpr(is_char || is_cstr || is_str || is_number){
+                // 用过流操纵符后格式状态可能已改变(如std::hex、std::setw)，之后统一经std::ostream输出
+                if(m_stream_used){
+                    GetFallbackStream() << val;
+                }else if constexpr(std::is_same<D, bool>::value){
+                    m_buf->append(val ? "true" : "false");
+                }else if constexpr(is_char){
+                    m_buf->push_back((char)val);
+                }else if constexpr(is_number){
+                    char digits[32];
+                    auto res = std::to_chars(digits, digits + sizeof(digits), val);
+                    m_buf->append(digits, res.ptr - digits);
+                }else if constexpr(std::is_array<T>::value){
+                    m_buf->append(val);
+                }else if constexpr(is_cstr){
+                    m_buf->append(val != nullptr ? val : "(null)");
+                }else{
+                    m_buf->append(val.data(), val.size());
+                }
+            }else if constexpr(!std::is_enum<D>::value && !std::is_pointer<D>::value && fmt::HasFormatter<D>::value){
+                fmt::FormatTo(*m_buf, "{}", val);
+            }else{
+                GetFallbackStream() << val;
+            }
+            return *this;
+        }
+
+        // 流操纵符(std::endl, std::hex等)
+        LogStream& operator<<(std::ostream& (*manip)(std::ostream&));
+        LogStream& operator<<(std::ios_base& (*manip)(std::ios_base&));
+    private:
+        struct FallbackStream;
+        // 指向m_buf的std::ostream，每条记录首次使用时重置格式状态。占用线程内缓冲的记录复用线程内的流，
+        // 嵌套的记录使用自己的m_local_stream，不改动外层记录正在使用的流的目标与格式状态
+        std::ostream& GetFallbackStream();
+
+        Logger*             m_logger;
+        LogAdditionInfo     m_info;
+        bool                m_has_info;
+        bool                m_enabled;
+        bool                m_owns_thread_buf;  // 是否占用了线程内缓冲。嵌套的记录(如operator<<内又打印日志)使用m_local_buf
+        bool                m_stream_used;
+        level::LevelEnum    m_lv;
+        std::string*        m_buf;
+        std::string         m_local_buf;
+        std::unique_ptr<FallbackStream> m_local_stream;     // 嵌套的记录用到std::ostream时才创建
+    };
+
+    /**
+     * @brief 将流表达式转为void，使DY_LOG_STREAM_*可置于条件运算符的一支。
+     *
+     */
+    struct LogStreamVoidify{
+        void operator&(const LogStream&){}
+    };
+
+    // no pattern，被过滤时<<为空操作(操作数仍会求值)
+    LogStream traceStream();
+    LogStream infoStream();
+    LogStream warnStream();
+    LogStream errorStream();
+    LogStream fatalStream();
+
+    // pattern. 被级别过滤时整条语句(含所有<<的操作数)不求值
+#define DY_LOG_STREAM_LEVEL(lv)          !(DY_LOG_ENABLED(lv)) ? (void)0 : \
+                                            dysv::LogStreamVoidify() & dysv::LogStream(DEFAULT_LOGGER, ADD_ADDITION_INFO, lv)
+#define DY_LOG_STREAM_TRACE              DY_LOG_STREAM_LEVEL(dysv::level::TRACE)
+#define DY_LOG_STREAM_INFO               DY_LOG_STREAM_LEVEL(dysv::level::INFO)
+#define DY_LOG_STREAM_WARN               DY_LOG_STREAM_LEVEL(dysv::level::WARN)
+#define DY_LOG_STREAM_ERROR              DY_LOG_STREAM_LEVEL(dysv::level::ERROR)
+#define DY_LOG_STREAM_FATAL              DY_LOG_STREAM_LEVEL(dysv::level::FATAL)
+} // namespace dysv
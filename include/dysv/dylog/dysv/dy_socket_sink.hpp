@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "dy_log.hpp"
+
+/**
+ * @brief 套接字sink，把日志发往本机的收集端(syslog/vector等)。
+ * @feature 支持Unix数据报/Unix流/回环UDP; 记录先在用户态合并成接近datagram_size的大报文，
+ *          按FileFlushPolicy成批以一次sendmmsg发出(流套接字为一次send);
+ *          套接字为非阻塞，收集端不存在、重启或跟不上时Sink()不会阻塞: 记录在有上限的缓冲中积压，超出的丢弃并计入统计,
+ *          断开后在下一次发送时按reconnect_interval_ms限频重连; 发送受阻后每积压buffer_size字节(或每max_latency_ms)才重试一次;
+ *          参与崩溃时的日志排空(dy_crash_handler.hpp)。
+ * @format 每条记录以'\n'结尾; 数据报套接字的一个报文含若干条完整记录，不会把一条记录拆到两个报文中(过长的记录被截断)。
+ * @note UDP没有流控，收集端跟不上时报文由内核静默丢弃，不计入统计; 需要不丢时使用Unix套接字。
+ * @example
+ *      // shell: dysv_log_collector unix:/tmp/dysv.sock
+ *      ADD_SINK(std::make_shared<dysv::SocketLoggerSink>("collector", dysv::SocketSinkConfig::Unix("/tmp/dysv.sock")));
+ *      ADD_SINK(std::make_shared<dysv::SocketLoggerSink>("udp", dysv::SocketSinkConfig::Udp("127.0.0.1", 5140)));
+ */
+
+namespace dysv
+{
+#define DEFAULT_SOCKET_DATAGRAM_SIZE    (32 * 1024)         // 数据报套接字默认每个报文的最大字节数
+#define DEFAULT_SOCKET_MAX_PENDING      (4 * 1024 * 1024)   // 默认最多积压的字节数
+#define DEFAULT_SOCKET_RECONNECT_MS     1000                // 默认两次重连之间的最短间隔
+#define SOCKET_SEND_BATCH               64                  // 每次sendmmsg最多发送的报文数
+
+    enum SocketSinkType{
+        SOCKET_UNIX_DGRAM = 0,      // Unix数据报套接字
+        SOCKET_UNIX_STREAM,         // Unix流套接字
+        SOCKET_UDP,                 // UDP(IPv4)，通常为回环地址
+    };
+
+    struct SocketSinkConfig{
+        SocketSinkType  type = SOCKET_UNIX_DGRAM;
+        std::string     path;                                               // Unix套接字路径
+        std::string     host = "127.0.0.1";                                 // UDP目的地址
+        uint16_t        port = 0;                                           // UDP目的端口
+        size_t          datagram_size = DEFAULT_SOCKET_DATAGRAM_SIZE;       // 数据报套接字每个报文的最大字节数
+        size_t          max_pending_bytes = DEFAULT_SOCKET_MAX_PENDING;     // 无法发送时最多积压的字节数，超出的记录丢弃
+        uint32_t        reconnect_interval_ms = DEFAULT_SOCKET_RECONNECT_MS;
+
+        static SocketSinkConfig Unix(const std::string& path, bool stream = false);
+        static SocketSinkConfig Udp(const std::string& host, uint16_t port);
+    };
+
+    /**
+     * @brief 套接字sink。缓冲为一段连续内存：前面是已封口的报文(边界记在m_datagrams中)，末尾是正在填充的报文;
+     *        发送成功的报文从头部移除。所有系统调用均为非阻塞，持锁时间只有一次发送。
+     *
+     */
+    class SocketLoggerSink : public LoggerSinkInterface
+    {
+    public:
+        using ptr = std::shared_ptr<SocketLoggerSink>;
+        SocketLoggerSink(const std::string& name, const SocketSinkConfig& config,
+                            const FileFlushPolicy& policy = FileFlushPolicy());
+        ~SocketLoggerSink() override;
+        void Sink(const std::string& content) override;
+        void Sink(level::LevelEnum lv, const std::string& content) override;
+        // 尝试发出全部积压，不等待(收集端不可用时仍留在缓冲中)
+        void Flush() override;
+        void EmergencyFlush() override;
+        bool EmergencyWrite(const char* data, size_t len) override;
+
+        bool IsConnected();
+        // 积压的字节数
+        size_t GetPendingBytes();
+        // 成功建立连接的次数(含首次)
+        uint64_t GetConnectCount();
+    private:
+        struct Datagram{
+            size_t      end;        // 报文在m_buffer中的结束位置
+            uint32_t    records;    // 报文中的记录数，丢弃时计入统计
+        };
+
+        bool IsDatagram() const{ return m_config.type != SOCKET_UNIX_STREAM; }
+        // 未连接且已到重连时刻时新建套接字并连接，需持有m_mutex
+        bool ConnectLocked();
+        void DisconnectLocked();
+        // 封口正在填充的报文
+        void SealLocked();
+        // 发送积压。seal为false时只发已封口的报文(按大小触发时，正在填充的报文留待填满)
+        void SendLocked(bool seal = true);
+        void SendDatagramsLocked();
+        void SendStreamLocked();
+        // 同FileLoggerSink：积压由空变为非空时在全局时间轮上挂max_latency_ms后的定时器，到期时发送(或重试)
+        void ArmLatencyTimerLocked(int64_t delay_ms);
+        void OnLatencyTimer();
+
+        SocketSinkConfig        m_config;
+        FileFlushPolicy         m_policy;
+        std::mutex              m_mutex;
+        int                     m_fd;
+        std::string             m_buffer;
+        std::vector<Datagram>   m_datagrams;        // 已封口的报文
+        uint32_t                m_open_records;     // 正在填充的报文中的记录数(仅数据报)
+        bool                    m_stream_partial;   // 流套接字上一次只发出了半条记录
+        size_t                  m_send_threshold;   // 积压达到该字节数时发送。发送未能清空时顺延buffer_size，避免每条记录都重试
+        int64_t                 m_first_pending_ms; // 缓冲中最早一条记录的写入时刻(发送未能清空时为该次尝试的时刻)，缓冲为空时为-1
+        int64_t                 m_next_connect_ms;  // 下一次允许重连的时刻
+        uint64_t                m_connect_count;
+        TimerId                 m_latency_timer;    // 挂起中的延迟发送定时器，0表示没有
+        bool                    m_timers_closed;    // 析构中，定时器回调不再续期
+        std::atomic<bool>       m_emergency_flushed{false};
+    };
+} // namespace dysv
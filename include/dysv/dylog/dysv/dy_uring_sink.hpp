@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "dy_log.hpp"
+
+/**
+ * @brief io_uring文件sink。
+ * @feature 记录追加进固定缓冲池中的当前缓冲，按FileFlushPolicy把写满的缓冲作为一次写请求提交给io_uring后立即返回,
+ *          换下一个空闲缓冲继续写; 完成事件从共享内存的完成队列中成批收割(不进系统调用)，缓冲随之归还池中。
+ *          写线程不再等待磁盘，每个缓冲只需一次io_uring_enter; 池中缓冲全部在途时才等待最早的完成。
+ *          每个请求带显式的文件偏移(提交时预留)，完成先后不影响文件内容。
+ *          直接使用io_uring系统调用，不依赖liburing; 编译时关闭(cmake -DDYSV_WITH_IO_URING=OFF)、
+ *          内核头文件过旧或运行时内核不支持时退化为同步pwrite，接口与行为不变。
+ * @note 文件以偏移写入而非O_APPEND，不适合多个进程同时追加同一文件;
+ *       崩溃时在途的缓冲会按原偏移重写一次(内容相同)，写失败的缓冲先同步重试，仍失败时丢弃并在文件中留下'\0'空洞;
+ *       io_uring_enter本身出错时关闭环，在途缓冲同步写出，之后退化为同步pwrite。
+ * @example
+ *      auto sink = std::make_shared<dysv::IoUringFileLoggerSink>("uring", "./app.log");
+ *      ADD_SINK(sink);
+ *      sink->IsUringEnabled();     // false表示已退化为同步pwrite
+ */
+
+namespace dysv
+{
+#define DEFAULT_URING_BUFFER_COUNT  8       // 默认缓冲池中的缓冲个数(同时在途的写请求上限)
+
+    /**
+     * @brief io_uring文件sink。所有成员由m_mutex保护; 提交与收割均在持锁的写线程中完成，没有后台线程。
+     *
+     */
+    class IoUringFileLoggerSink : public LoggerSinkInterface
+    {
+    public:
+        using ptr = std::shared_ptr<IoUringFileLoggerSink>;
+        IoUringFileLoggerSink(const std::string& name, const std::string& file_name,
+                                const FileFlushPolicy& policy = FileFlushPolicy(),
+                                size_t buffer_count = DEFAULT_URING_BUFFER_COUNT);
+        ~IoUringFileLoggerSink() override;
+        void Sink(const std::string& content) override;
+        void Sink(level::LevelEnum lv, const std::string& content) override;
+        // 提交当前缓冲并等待所有在途请求完成
+        void Flush() override;
+        // 崩溃时不加锁地以pwrite写出当前缓冲与在途的缓冲(只写一次)
+        void EmergencyFlush() override;
+        bool EmergencyWrite(const char* data, size_t len) override;
+
+        const std::string& GetFileName() const;
+        // 是否正在使用io_uring(否则为同步pwrite)
+        bool IsUringEnabled() const;
+        // 已提交的写请求数
+        uint64_t GetSubmitCount();
+    private:
+        struct Buffer{
+            char*       data = nullptr;
+            size_t      size = 0;           // 有效字节数
+            size_t      done = 0;           // 已写入的字节数(短写时据此续写)
+            uint64_t    offset = 0;         // 在文件中的起始偏移，提交时预留
+            uint64_t    records = 0;        // 缓冲中的记录数，写失败时计为丢弃
+            std::atomic<bool> in_flight{false};
+        };
+
+        bool SetupRing(size_t entries);
+        void DestroyRing();
+        // 提交当前缓冲并取一个空闲缓冲作为新的当前缓冲，需持有m_mutex
+        void SubmitCurrentLocked();
+        // 把缓冲从done处起的剩余部分作为写请求放入提交队列
+        void QueueWriteLocked(uint32_t index);
+        // 成功返回0; 出现EINTR/EAGAIN/EBUSY以外的错误时返回errno，调用方应改用AbandonRingLocked退化为同步写
+        int EnterLocked(uint32_t to_submit, uint32_t min_complete);
+        // 收割完成队列中已有的事件，返回收割的个数
+        size_t ReapLocked();
+        // 请求结束(成功或同步重试后)，缓冲归还池中
+        void RecycleLocked(uint32_t index, bool ok);
+        // io_uring_enter失败：关闭环，在途缓冲以pwrite同步写出后归还，此后退化为同步写
+        void AbandonRingLocked();
+        // 等待直到在途请求数不超过limit
+        void WaitInFlightLocked(size_t limit);
+        // 同FileLoggerSink：当前缓冲由空变为非空时在全局时间轮上挂max_latency_ms后的定时器，到期时提交
+        void ArmLatencyTimerLocked(int64_t delay_ms);
+        void OnLatencyTimer();
+
+        std::string             m_file_name;
+        FileFlushPolicy         m_policy;
+        std::mutex              m_mutex;
+        int                     m_fd;
+        uint64_t                m_file_offset;      // 下一个缓冲的起始偏移(已预留到的文件末尾)
+        size_t                  m_capacity;         // 每个缓冲的容量
+        std::vector<char>       m_pool;
+        std::vector<Buffer>     m_buffers;
+        std::vector<uint32_t>   m_free;             // 空闲缓冲的下标
+        uint32_t                m_current;          // 正在填充的缓冲
+        size_t                  m_in_flight;
+        int64_t                 m_first_pending_ms; // 当前缓冲中最早一条记录的写入时刻，缓冲为空时为-1
+        uint64_t                m_submit_count;
+        TimerId                 m_latency_timer;    // 挂起中的延迟提交定时器，0表示没有
+        bool                    m_timers_closed;    // 析构中，定时器回调不再续期
+        std::atomic<bool>       m_emergency_flushed{false};
+
+        // io_uring的共享内存环，m_ring_fd为-1时未启用
+        int                     m_ring_fd;
+        void*                   m_sq_ring;
+        void*                   m_cq_ring;
+        void*                   m_sqes;
+        size_t                  m_sq_ring_size;
+        size_t                  m_cq_ring_size;
+        size_t                  m_sqes_size;
+        unsigned*               m_sq_tail;
+        unsigned*               m_sq_mask;
+        unsigned*               m_sq_array;
+        unsigned*               m_cq_head;
+        unsigned*               m_cq_tail;
+        unsigned*               m_cq_mask;
+        void*                   m_cqes;
+    };
+} // namespace dysv
@@ -0,0 +1,173 @@
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "dysv/dy_event_loop.hpp"
+#include "dysv/dy_log.hpp"
+
+namespace dysv{
+    static thread_local EventLoop* t_loop = nullptr;
+
+    /*********************class EventLoop**************************************/
+    EventLoop::EventLoop() : m_thread_id(std::this_thread::get_id()), m_quit(false), m_running_tasks(false),
+                                m_events(NET_MAX_EVENTS), m_poll_ms(TimingWheel::NowMs())
+    {
+        m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if(m_epoll_fd < 0 || m_wakeup_fd < 0){
+            DY_LOGF_ERROR("event loop: epoll/eventfd failed: {}", strerror(errno));
+        }
+        AddFd(m_wakeup_fd, EPOLLIN, nullptr);
+        if(t_loop != nullptr){
+            DY_LOGF_ERROR("event loop: another loop already exists in this thread");
+        }
+        t_loop = this;
+    }
+
+    EventLoop::~EventLoop(){
+        if(t_loop == this){
+            t_loop = nullptr;
+        }
+        if(m_wakeup_fd >= 0){
+            close(m_wakeup_fd);
+        }
+        if(m_epoll_fd >= 0){
+            close(m_epoll_fd);
+        }
+    }
+
+    EventLoop* EventLoop::Current(){
+        return t_loop;
+    }
+
+    void EventLoop::Loop(){
+        m_quit.store(false);
+        while(!m_quit.load()){
+            int64_t timeout = m_timers.NextTimeoutMs(TimingWheel::NowMs());
+            int n = epoll_wait(m_epoll_fd, m_events.data(), (int)m_events.size(), (int)timeout);
+            m_poll_ms = TimingWheel::NowMs();
+            if(n < 0){
+                if(errno != EINTR){
+                    DY_LOGF_ERROR("event loop: epoll_wait failed: {}", strerror(errno));
+                }
+                continue;
+            }
+            for(int i = 0; i < n; i++){
+                IoHandler* handler = (IoHandler*)m_events[i].data.ptr;
+                if(handler == nullptr){
+                    DrainWakeup();
+                }else{
+                    handler->HandleEvents(m_events[i].events);
+                }
+            }
+            m_timers.Advance(m_poll_ms);
+            m_holders.clear();
+            RunPendingTasks();
+        }
+        // 退出前执行完已排队的任务(通常是关闭连接)
+        RunPendingTasks();
+        m_holders.clear();
+    }
+
+    void EventLoop::Quit(){
+        m_quit.store(true);
+        if(!IsInLoopThread()){
+            Wakeup();
+        }
+    }
+
+    bool EventLoop::IsInLoopThread() const{
+        return m_thread_id == std::this_thread::get_id();
+    }
+
+    void EventLoop::RunInLoop(Task task){
+        if(IsInLoopThread()){
+            task();
+        }else{
+            QueueInLoop(std::move(task));
+        }
+    }
+
+    void EventLoop::QueueInLoop(Task task){
+        {
+            std::lock_guard<std::mutex> lk(m_task_mutex);
+            m_tasks.push_back(std::move(task));
+        }
+        if(!IsInLoopThread() || m_running_tasks.load()){
+            Wakeup();
+        }
+    }
+
+    bool EventLoop::AddFd(int fd, uint32_t events, IoHandler* handler){
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.ptr = handler;
+        return epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    bool EventLoop::ModFd(int fd, uint32_t events, IoHandler* handler){
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.ptr = handler;
+        return epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+    }
+
+    void EventLoop::DelFd(int fd){
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    TimerId EventLoop::RunAfter(uint32_t delay_ms, TimingWheel::Callback cb){
+        TimerId id = m_timers.Add(delay_ms, std::move(cb));
+        if(!IsInLoopThread()){
+            // 循环可能正以更长的超时等待，唤醒后重新计算
+            Wakeup();
+        }
+        return id;
+    }
+
+    TimerId EventLoop::RunEvery(uint32_t interval_ms, TimingWheel::Callback cb){
+        TimerId id = m_timers.AddPeriodic(interval_ms, std::move(cb));
+        if(!IsInLoopThread()){
+            Wakeup();
+        }
+        return id;
+    }
+
+    void EventLoop::CancelTimer(TimerId id){
+        m_timers.Cancel(id);
+    }
+
+    void EventLoop::KeepUntilNextRound(std::shared_ptr<void> holder){
+        m_holders.push_back(std::move(holder));
+    }
+
+    void EventLoop::Wakeup(){
+        uint64_t one = 1;
+        ssize_t n = write(m_wakeup_fd, &one, sizeof(one));
+        (void)n;
+    }
+
+    void EventLoop::DrainWakeup(){
+        uint64_t count;
+        ssize_t n = read(m_wakeup_fd, &count, sizeof(count));
+        (void)n;
+    }
+
+    void EventLoop::RunPendingTasks(){
+        std::vector<Task> tasks;
+        {
+            std::lock_guard<std::mutex> lk(m_task_mutex);
+            tasks.swap(m_tasks);
+        }
+        if(tasks.empty()){
+            return;
+        }
+        m_running_tasks.store(true);
+        for(Task& task : tasks){
+            task();
+        }
+        m_running_tasks.store(false);
+    }
+} // namespace dysv
@@ -0,0 +1,211 @@
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "dysv/dy_net_buffer.hpp"
+
+namespace dysv{
+    /*********************class BufferPool**************************************/
+    BufferPool::BufferPool(size_t block_size, size_t max_free)
+                            : m_block_size(block_size), m_max_free(max_free), m_in_use(0){}
+
+    BufferPool::~BufferPool(){
+        for(char* block : m_free){
+            delete[] block;
+        }
+    }
+
+    char* BufferPool::Acquire(){
+        m_in_use++;
+        if(m_free.empty()){
+            return new char[m_block_size];
+        }
+        char* block = m_free.back();
+        m_free.pop_back();
+        return block;
+    }
+
+    void BufferPool::Release(char* block){
+        m_in_use--;
+        if(m_free.size() >= m_max_free){
+            delete[] block;
+            return;
+        }
+        m_free.push_back(block);
+    }
+
+    /*********************class InputBuffer**************************************/
+    InputBuffer::InputBuffer(BufferPool* pool) : m_pool(pool), m_data(nullptr), m_capacity(0),
+                                                m_read(0), m_write(0), m_pooled(false){}
+
+    InputBuffer::~InputBuffer(){
+        ReleaseStorage();
+    }
+
+    void InputBuffer::Retrieve(size_t len){
+        if(len >= ReadableBytes()){
+            RetrieveAll();
+            return;
+        }
+        m_read += len;
+    }
+
+    void InputBuffer::RetrieveAll(){
+        m_read = 0;
+        m_write = 0;
+    }
+
+    void InputBuffer::Shrink(){
+        if(ReadableBytes() == 0){
+            ReleaseStorage();
+        }
+    }
+
+    void InputBuffer::ReleaseStorage(){
+        if(m_data != nullptr){
+            if(m_pooled){
+                m_pool->Release(m_data);
+            }else{
+                delete[] m_data;
+            }
+        }
+        m_data = nullptr;
+        m_capacity = 0;
+        m_read = 0;
+        m_write = 0;
+        m_pooled = false;
+    }
+
+    void InputBuffer::EnsureWritable(size_t len){
+        if(m_data == nullptr && len <= m_pool->BlockSize()){
+            m_data = m_pool->Acquire();
+            m_capacity = m_pool->BlockSize();
+            m_pooled = true;
+            return;
+        }
+        if(m_capacity - m_write >= len){
+            return;
+        }
+        size_t readable = ReadableBytes();
+        if(m_capacity - readable >= len){
+            // 已读部分腾出的空间足够，前移即可
+            memmove(m_data, m_data + m_read, readable);
+        }else{
+            size_t capacity = std::max(m_capacity * 2, readable + len);
+            char* data = new char[capacity];
+            if(readable > 0){
+                memcpy(data, m_data + m_read, readable);
+            }
+            ReleaseStorage();
+            m_data = data;
+            m_capacity = capacity;
+            m_pooled = false;
+        }
+        m_read = 0;
+        m_write = readable;
+    }
+
+    void InputBuffer::Append(const char* data, size_t len){
+        EnsureWritable(len);
+        memcpy(m_data + m_write, data, len);
+        m_write += len;
+    }
+
+    ssize_t InputBuffer::ReadFd(int fd, int* saved_errno, bool* drained){
+        if(m_data == nullptr){
+            EnsureWritable(1);
+        }
+        char extra[NET_READ_EXTRA_SIZE];
+        iovec vec[2];
+        size_t writable = m_capacity - m_write;
+        vec[0].iov_base = m_data + m_write;
+        vec[0].iov_len = writable;
+        vec[1].iov_base = extra;
+        vec[1].iov_len = sizeof(extra);
+        ssize_t n = readv(fd, vec, 2);
+        if(drained != nullptr){
+            *drained = (n >= 0 && (size_t)n < writable + sizeof(extra));
+        }
+        if(n < 0){
+            *saved_errno = errno;
+        }else if((size_t)n <= writable){
+            m_write += n;
+        }else{
+            m_write = m_capacity;
+            Append(extra, n - writable);
+        }
+        return n;
+    }
+
+    /*********************class OutputBuffer**************************************/
+    OutputBuffer::OutputBuffer(BufferPool* pool) : m_pool(pool), m_size(0){}
+
+    OutputBuffer::~OutputBuffer(){
+        Clear();
+    }
+
+    void OutputBuffer::Clear(){
+        for(Block& block : m_blocks){
+            m_pool->Release(block.data);
+        }
+        m_blocks.clear();
+        m_size = 0;
+    }
+
+    void OutputBuffer::Append(const char* data, size_t len){
+        size_t block_size = m_pool->BlockSize();
+        m_size += len;
+        while(len > 0){
+            if(m_blocks.empty() || m_blocks.back().end == block_size){
+                m_blocks.push_back(Block{m_pool->Acquire(), 0, 0});
+            }
+            Block& tail = m_blocks.back();
+            size_t n = std::min(len, block_size - tail.end);
+            memcpy(tail.data + tail.end, data, n);
+            tail.end += n;
+            data += n;
+            len -= n;
+        }
+    }
+
+    ssize_t OutputBuffer::WriteFd(int fd, int* saved_errno){
+        iovec vec[NET_MAX_IOV];
+        int count = 0;
+        for(const Block& block : m_blocks){
+            if(count == NET_MAX_IOV){
+                break;
+            }
+            vec[count].iov_base = block.data + block.begin;
+            vec[count].iov_len = block.end - block.begin;
+            count++;
+        }
+        if(count == 0){
+            return 0;
+        }
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vec;
+        msg.msg_iovlen = count;
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if(n < 0){
+            *saved_errno = errno;
+            return n;
+        }
+        m_size -= n;
+        size_t left = n;
+        while(left > 0){
+            Block& head = m_blocks.front();
+            size_t len = head.end - head.begin;
+            if(left < len){
+                head.begin += left;
+                break;
+            }
+            left -= len;
+            m_pool->Release(head.data);
+            m_blocks.pop_front();
+        }
+        return n;
+    }
+} // namespace dysv
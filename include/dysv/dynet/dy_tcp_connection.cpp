@@ -0,0 +1,316 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "dysv/dy_tcp_connection.hpp"
+#include "dysv/dy_log.hpp"
+
+namespace dysv{
+    /*********************class TcpConnection**************************************/
+    TcpConnection::TcpConnection(EventLoop* loop, int fd, const std::string& peer)
+                                : m_loop(loop), m_fd(fd), m_peer(peer), m_state(CONN_CONNECTING),
+                                m_input(&loop->GetBufferPool()), m_output(&loop->GetBufferPool()),
+                                m_idle_timeout_ms(0), m_idle_timer(0), m_last_active_ms(loop->PollTimeMs())
+    {
+        int one = 1;
+        setsockopt(m_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    TcpConnection::~TcpConnection(){
+        // 正常情况下HandleClose已关闭fd并把缓冲还回池中
+        if(m_fd >= 0){
+            close(m_fd);
+        }
+    }
+
+    TcpConnectionPtr TcpConnection::Connect(EventLoop* loop, const std::string& host, uint16_t port){
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if(inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1){
+            DY_LOGF_ERROR("tcp connect: invalid address {}", host);
+            return nullptr;
+        }
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd < 0){
+            DY_LOGF_ERROR("tcp connect: socket failed: {}", strerror(errno));
+            return nullptr;
+        }
+        if(connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0){
+            DY_LOGF_ERROR("tcp connect: connect {}:{} failed: {}", host, port, strerror(errno));
+            close(fd);
+            return nullptr;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return std::make_shared<TcpConnection>(loop, fd, host + ":" + std::to_string(port));
+    }
+
+    void TcpConnection::Start(){
+        if(m_state != CONN_CONNECTING){
+            return;
+        }
+        m_state = CONN_CONNECTED;
+        if(!m_loop->AddFd(m_fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, this)){
+            DY_LOGF_ERROR("tcp connection {}: epoll add failed: {}", m_peer, strerror(errno));
+            HandleClose();
+        }
+    }
+
+    void TcpConnection::SetIdleTimeout(uint32_t timeout_ms){
+        m_idle_timeout_ms = timeout_ms;
+        m_last_active_ms = m_loop->PollTimeMs();
+        if(m_idle_timer != 0){
+            m_loop->CancelTimer(m_idle_timer);
+            m_idle_timer = 0;
+        }
+        if(timeout_ms > 0 && m_state != CONN_CLOSED){
+            ArmIdleTimer(timeout_ms);
+        }
+    }
+
+    void TcpConnection::ArmIdleTimer(int64_t delay_ms){
+        std::weak_ptr<TcpConnection> weak = shared_from_this();
+        m_idle_timer = m_loop->RunAfter((uint32_t)std::max<int64_t>(delay_ms, 1), [weak](){
+            TcpConnectionPtr self = weak.lock();
+            if(self){
+                self->HandleIdleTimer();
+            }
+        });
+    }
+
+    void TcpConnection::HandleIdleTimer(){
+        m_idle_timer = 0;
+        if(m_state == CONN_CLOSED || m_idle_timeout_ms == 0){
+            return;
+        }
+        int64_t idle = m_loop->PollTimeMs() - m_last_active_ms;
+        if(idle < (int64_t)m_idle_timeout_ms){
+            ArmIdleTimer(m_idle_timeout_ms - idle);
+            return;
+        }
+        DY_LOGF_TRACE("tcp connection {}: idle for {}ms, closing", m_peer, idle);
+        HandleClose();
+    }
+
+    void TcpConnection::HandleEvents(uint32_t events){
+        if(m_state == CONN_CLOSED){
+            return;
+        }
+        // 回调中可能释放使用者持有的最后一个引用
+        TcpConnectionPtr self = shared_from_this();
+        if(events & EPOLLERR){
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            HandleError(err);
+            return;
+        }
+        if(events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)){
+            HandleRead((events & (EPOLLRDHUP | EPOLLHUP)) != 0);
+        }
+        if((events & EPOLLOUT) && m_state != CONN_CLOSED){
+            HandleWrite();
+        }
+    }
+
+    void TcpConnection::HandleRead(bool hangup){
+        TcpConnectionPtr self = shared_from_this();
+        for(;;){
+            int err = 0;
+            bool drained = false;
+            ssize_t n = m_input.ReadFd(m_fd, &err, &drained);
+            if(n > 0){
+                m_last_active_ms = m_loop->PollTimeMs();
+                if(m_message_cb){
+                    m_message_cb(self, m_input);
+                }else{
+                    m_input.RetrieveAll();
+                }
+                if(m_state == CONN_CLOSED){
+                    return;
+                }
+                if(drained && !hangup){
+                    break;
+                }
+            }else if(n == 0){
+                HandleClose();
+                return;
+            }else if(err == EINTR){
+                continue;
+            }else if(err == EAGAIN || err == EWOULDBLOCK){
+                break;
+            }else{
+                HandleError(err);
+                return;
+            }
+        }
+        m_input.Shrink();
+    }
+
+    void TcpConnection::HandleWrite(){
+        while(!m_output.Empty()){
+            int err = 0;
+            ssize_t n = m_output.WriteFd(m_fd, &err);
+            if(n < 0){
+                if(err == EINTR){
+                    continue;
+                }
+                if(err != EAGAIN && err != EWOULDBLOCK){
+                    HandleError(err);
+                }
+                return;
+            }
+            m_last_active_ms = m_loop->PollTimeMs();
+            if(m_output.Empty()){
+                if(m_state == CONN_DISCONNECTING){
+                    shutdown(m_fd, SHUT_WR);
+                }
+                if(m_write_complete_cb){
+                    m_write_complete_cb(shared_from_this());
+                }
+            }
+        }
+    }
+
+    void TcpConnection::HandleClose(){
+        if(m_state == CONN_CLOSED){
+            return;
+        }
+        m_state = CONN_CLOSED;
+        if(m_idle_timer != 0){
+            m_loop->CancelTimer(m_idle_timer);
+            m_idle_timer = 0;
+        }
+        m_loop->DelFd(m_fd);
+        close(m_fd);
+        m_fd = -1;
+        m_input.RetrieveAll();
+        m_input.Shrink();
+        m_output.Clear();
+        TcpConnectionPtr self = shared_from_this();
+        m_loop->KeepUntilNextRound(self);
+        if(m_close_cb){
+            m_close_cb(self);
+        }
+    }
+
+    void TcpConnection::HandleError(int err){
+        if(err == ECONNRESET || err == EPIPE || err == ETIMEDOUT || err == 0){
+            DY_LOGF_TRACE("tcp connection {}: closed: {}", m_peer, strerror(err));
+        }else{
+            DY_LOGF_EVERY_MS(dysv::level::WARN, 1000, "tcp connection {}: error: {}", m_peer, strerror(err));
+        }
+        HandleClose();
+    }
+
+    void TcpConnection::Send(std::string_view data){
+        if(m_loop->IsInLoopThread()){
+            SendInLoop(&data, 1);
+            return;
+        }
+        TcpConnectionPtr self = shared_from_this();
+        m_loop->QueueInLoop([self, copy = std::string(data)](){
+            std::string_view piece(copy);
+            self->SendInLoop(&piece, 1);
+        });
+    }
+
+    void TcpConnection::Send(std::initializer_list<std::string_view> pieces){
+        if(m_loop->IsInLoopThread()){
+            SendInLoop(pieces.begin(), pieces.size());
+            return;
+        }
+        std::string copy;
+        for(std::string_view piece : pieces){
+            copy.append(piece);
+        }
+        TcpConnectionPtr self = shared_from_this();
+        m_loop->QueueInLoop([self, copy = std::move(copy)](){
+            std::string_view piece(copy);
+            self->SendInLoop(&piece, 1);
+        });
+    }
+
+    void TcpConnection::SendInLoop(const std::string_view* pieces, size_t count){
+        if(m_state != CONN_CONNECTED){
+            return;
+        }
+        size_t written = 0;
+        bool write_more = false;
+        if(m_output.Empty()){
+            // 写缓冲为空时直接写调用方的数据，通常一次写完，无需拷贝
+            iovec vec[NET_MAX_IOV];
+            size_t iov_count = std::min(count, (size_t)NET_MAX_IOV);
+            size_t total = 0;
+            for(size_t i = 0; i < iov_count; i++){
+                vec[i].iov_base = (void*)pieces[i].data();
+                vec[i].iov_len = pieces[i].size();
+                total += pieces[i].size();
+            }
+            // MSG_NOSIGNAL：写已断开的连接时以EPIPE返回，不触发SIGPIPE，也不改动进程的信号处理
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = vec;
+            msg.msg_iovlen = iov_count;
+            ssize_t n;
+            do{
+                n = sendmsg(m_fd, &msg, MSG_NOSIGNAL);
+            }while(n < 0 && errno == EINTR);
+            if(n < 0){
+                if(errno != EAGAIN && errno != EWOULDBLOCK){
+                    HandleError(errno);
+                    return;
+                }
+                n = 0;
+            }
+            written = n;
+            if(written == total && iov_count == count){
+                if(m_write_complete_cb){
+                    TcpConnectionPtr self = shared_from_this();
+                    m_loop->QueueInLoop([self](){ self->m_write_complete_cb(self); });
+                }
+                return;
+            }
+            // 片段数超过NET_MAX_IOV且前面的都写完了：没有遇到EAGAIN，不会有新的可写边沿，需主动再写
+            write_more = (written == total);
+        }
+        // 写不完的部分拷进写缓冲，等EPOLLOUT边沿再写
+        for(size_t i = 0; i < count; i++){
+            if(written >= pieces[i].size()){
+                written -= pieces[i].size();
+                continue;
+            }
+            m_output.Append(pieces[i].substr(written));
+            written = 0;
+        }
+        if(write_more){
+            HandleWrite();
+        }
+    }
+
+    void TcpConnection::Shutdown(){
+        TcpConnectionPtr self = shared_from_this();
+        m_loop->RunInLoop([self](){
+            if(self->m_state != CONN_CONNECTED){
+                return;
+            }
+            self->m_state = CONN_DISCONNECTING;
+            if(self->m_output.Empty()){
+                shutdown(self->m_fd, SHUT_WR);
+            }
+        });
+    }
+
+    void TcpConnection::ForceClose(){
+        TcpConnectionPtr self = shared_from_this();
+        m_loop->RunInLoop([self](){
+            self->HandleClose();
+        });
+    }
+} // namespace dysv
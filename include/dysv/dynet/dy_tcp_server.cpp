@@ -0,0 +1,255 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "dysv/dy_tcp_server.hpp"
+#include "dysv/dy_log.hpp"
+
+namespace dysv{
+#define NET_THREAD_NAME_LEN     15      // pthread线程名最长15字节
+
+    static std::string FormatPeer(const sockaddr_in& addr){
+        char ip[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+        return std::string(ip) + ":" + std::to_string(ntohs(addr.sin_port));
+    }
+
+    /*********************class TcpServer::Acceptor**************************************/
+    /**
+     * @brief 监听fd的事件处理者。边沿触发，每次可读时accept到EAGAIN。
+     *        fd耗尽(EMFILE)时借助预留的空闲fd接受并立即关闭新连接，避免监听fd一直可读而丢掉后续边沿。
+     *
+     */
+    class TcpServer::Acceptor : public IoHandler
+    {
+    public:
+        Acceptor(TcpServer* server, Worker* worker) : m_server(server), m_worker(worker){
+            m_idle_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+        ~Acceptor() override{
+            if(m_idle_fd >= 0){
+                close(m_idle_fd);
+            }
+        }
+
+        void HandleEvents(uint32_t events) override{
+            (void)events;
+            for(;;){
+                sockaddr_in addr;
+                socklen_t len = sizeof(addr);
+                int fd = accept4(m_worker->listen_fd, (sockaddr*)&addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(fd >= 0){
+                    m_server->Dispatch(m_worker, fd, FormatPeer(addr));
+                    continue;
+                }
+                int err = errno;
+                if(err == EAGAIN || err == EWOULDBLOCK){
+                    return;
+                }
+                if(err == EINTR || err == ECONNABORTED){
+                    continue;
+                }
+                if((err == EMFILE || err == ENFILE) && m_idle_fd >= 0){
+                    DY_LOGF_EVERY_MS(dysv::level::WARN, 1000, "tcp server: accept: {}, dropping connection", strerror(err));
+                    close(m_idle_fd);
+                    int dropped = accept(m_worker->listen_fd, nullptr, nullptr);
+                    if(dropped >= 0){
+                        close(dropped);
+                    }
+                    m_idle_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                    continue;
+                }
+                DY_LOGF_EVERY_MS(dysv::level::WARN, 1000, "tcp server: accept failed: {}", strerror(err));
+                return;
+            }
+        }
+    private:
+        TcpServer*  m_server;
+        Worker*     m_worker;
+        int         m_idle_fd;
+    };
+
+    /*********************class TcpServer**************************************/
+    TcpServer::TcpServer(const TcpServerConfig& config) : m_config(config), m_port(config.port), m_started(false),
+                                                            m_next_worker(0), m_conn_count(0)
+    {
+        if(m_config.threads == 0){
+            m_config.threads = 1;
+        }
+    }
+
+    TcpServer::~TcpServer(){
+        Stop();
+    }
+
+    int TcpServer::CreateListenFd(uint16_t port){
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if(inet_pton(AF_INET, m_config.host.c_str(), &addr.sin_addr) != 1){
+            DY_LOGF_ERROR("tcp server: invalid listen address {}", m_config.host);
+            return -1;
+        }
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(fd < 0){
+            DY_LOGF_ERROR("tcp server: socket failed: {}", strerror(errno));
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if(m_config.reuse_port && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0){
+            DY_LOGF_ERROR("tcp server: SO_REUSEPORT failed: {}", strerror(errno));
+            close(fd);
+            return -1;
+        }
+        if(bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, m_config.backlog) != 0){
+            DY_LOGF_ERROR("tcp server: listen {}:{} failed: {}", m_config.host, port, strerror(errno));
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool TcpServer::Start(){
+        if(m_started){
+            return true;
+        }
+        // 先在调用线程中建好所有监听fd，绑定失败能直接返回; 端口为0时后续监听fd复用第一个分到的端口
+        std::vector<int> listen_fds(m_config.threads, -1);
+        size_t listeners = m_config.reuse_port ? m_config.threads : 1;
+        for(size_t i = 0; i < listeners; i++){
+            listen_fds[i] = CreateListenFd(m_port);
+            if(listen_fds[i] < 0){
+                for(size_t j = 0; j < i; j++){
+                    close(listen_fds[j]);
+                }
+                m_port = m_config.port;
+                return false;
+            }
+            if(i == 0){
+                sockaddr_in addr;
+                socklen_t len = sizeof(addr);
+                getsockname(listen_fds[0], (sockaddr*)&addr, &len);
+                m_port = ntohs(addr.sin_port);
+            }
+        }
+
+        for(size_t i = 0; i < m_config.threads; i++){
+            std::unique_ptr<Worker> worker(new Worker);
+            worker->listen_fd = listen_fds[i];
+            m_workers.push_back(std::move(worker));
+        }
+        std::vector<std::promise<void>> ready(m_config.threads);
+        for(size_t i = 0; i < m_config.threads; i++){
+            Worker* worker = m_workers[i].get();
+            worker->thread = std::thread(&TcpServer::WorkerLoop, this, worker, &ready[i]);
+            std::string name = m_config.name + "-" + std::to_string(i);
+            if(name.size() > NET_THREAD_NAME_LEN){
+                name.resize(NET_THREAD_NAME_LEN);
+            }
+            pthread_setname_np(worker->thread.native_handle(), name.c_str());
+        }
+        for(auto& r : ready){
+            r.get_future().wait();
+        }
+        // 所有循环就绪后才开始accept，分派时各循环的loop指针都已发布
+        for(auto& worker : m_workers){
+            Worker* w = worker.get();
+            if(w->listen_fd < 0){
+                continue;
+            }
+            w->loop->RunInLoop([this, w](){
+                w->acceptor.reset(new Acceptor(this, w));
+                if(!w->loop->AddFd(w->listen_fd, EPOLLIN | EPOLLET, w->acceptor.get())){
+                    DY_LOGF_ERROR("tcp server: epoll add listen fd failed: {}", strerror(errno));
+                }
+            });
+        }
+        m_started = true;
+        DY_LOGF_INFO("tcp server: listening on {}:{} with {} loop(s){}", m_config.host, m_port, m_config.threads,
+                        m_config.reuse_port ? ", SO_REUSEPORT" : "");
+        return true;
+    }
+
+    void TcpServer::Stop(){
+        if(!m_started){
+            return;
+        }
+        for(auto& worker : m_workers){
+            Worker* w = worker.get();
+            w->loop->RunInLoop([w](){
+                if(w->acceptor){
+                    w->loop->DelFd(w->listen_fd);
+                    w->acceptor.reset();
+                }
+                if(w->listen_fd >= 0){
+                    close(w->listen_fd);
+                    w->listen_fd = -1;
+                }
+                // 关闭回调会从conns中删除，先拷贝一份
+                std::vector<TcpConnectionPtr> conns;
+                conns.reserve(w->conns.size());
+                for(auto& kv : w->conns){
+                    conns.push_back(kv.second);
+                }
+                for(auto& conn : conns){
+                    conn->ForceClose();
+                }
+                w->loop->Quit();
+            });
+        }
+        for(auto& worker : m_workers){
+            worker->thread.join();
+        }
+        m_workers.clear();
+        m_started = false;
+    }
+
+    void TcpServer::WorkerLoop(Worker* worker, std::promise<void>* ready){
+        EventLoop loop;
+        worker->loop = &loop;
+        ready->set_value();
+        loop.Loop();
+    }
+
+    void TcpServer::Dispatch(Worker* from, int fd, const std::string& peer){
+        if(m_config.reuse_port || m_workers.size() <= 1){
+            NewConnection(from, fd, peer);
+            return;
+        }
+        Worker* to = m_workers[m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_workers.size()].get();
+        if(to == from){
+            NewConnection(to, fd, peer);
+            return;
+        }
+        to->loop->QueueInLoop([this, to, fd, peer](){
+            NewConnection(to, fd, peer);
+        });
+    }
+
+    void TcpServer::NewConnection(Worker* worker, int fd, const std::string& peer){
+        TcpConnectionPtr conn = std::make_shared<TcpConnection>(worker->loop, fd, peer);
+        conn->SetMessageCallback(m_message_cb);
+        conn->SetCloseCallback([this, worker](const TcpConnectionPtr& c){
+            if(m_close_cb){
+                m_close_cb(c);
+            }
+            worker->conns.erase(c.get());
+            m_conn_count.fetch_sub(1, std::memory_order_relaxed);
+        });
+        worker->conns.emplace(conn.get(), conn);
+        m_conn_count.fetch_add(1, std::memory_order_relaxed);
+        conn->Start();
+        if(m_config.idle_timeout_ms > 0 && conn->Connected()){
+            conn->SetIdleTimeout(m_config.idle_timeout_ms);
+        }
+        if(m_connection_cb && conn->Connected()){
+            m_connection_cb(conn);
+        }
+    }
+} // namespace dysv
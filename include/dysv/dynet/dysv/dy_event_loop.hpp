@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/epoll.h>
+#include "common/dy_timing_wheel.hpp"
+#include "dy_net_buffer.hpp"
+
+namespace dysv
+{
+#define NET_MAX_EVENTS  256     // 每次epoll_wait最多取回的事件数
+
+    /**
+     * @brief fd上的事件处理者。注册到EventLoop时作为epoll_event.data.ptr。
+     *
+     */
+    class IoHandler
+    {
+    public:
+        virtual ~IoHandler() = default;
+        // events为epoll事件位(EPOLLIN/EPOLLOUT/EPOLLRDHUP/EPOLLERR/EPOLLHUP)
+        virtual void HandleEvents(uint32_t events) = 0;
+    };
+
+    /**
+     * @brief 事件循环，每个线程至多一个。epoll + eventfd唤醒; 其他线程通过RunInLoop把任务交给本线程执行。
+     *        定时器由循环自己的时间轮驱动：epoll_wait以最近的到期时间为超时，醒来后在本线程执行到期的回调。
+     *        除RunInLoop/QueueInLoop/Quit/RunAfter/RunEvery/CancelTimer外的接口只能在循环所在线程调用。
+     *
+     */
+    class EventLoop
+    {
+    public:
+        using Task = std::function<void()>;
+
+        // 在将要运行Loop的线程中构造
+        EventLoop();
+        ~EventLoop();
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator=(const EventLoop&) = delete;
+
+        // 运行直到Quit
+        void Loop();
+        void Quit();
+        bool IsInLoopThread() const;
+
+        // 在循环线程中执行task：当前就在循环线程时立即执行，否则排队并唤醒
+        void RunInLoop(Task task);
+        // 排队到本轮事件处理之后执行
+        void QueueInLoop(Task task);
+
+        bool AddFd(int fd, uint32_t events, IoHandler* handler);
+        bool ModFd(int fd, uint32_t events, IoHandler* handler);
+        void DelFd(int fd);
+        // 保持holder存活到本轮事件处理结束：已关闭的连接在同一批事件中仍可能被引用
+        void KeepUntilNextRound(std::shared_ptr<void> holder);
+
+        // 定时器回调在循环线程中执行
+        TimerId RunAfter(uint32_t delay_ms, TimingWheel::Callback cb);
+        TimerId RunEvery(uint32_t interval_ms, TimingWheel::Callback cb);
+        void CancelTimer(TimerId id);
+        // 本轮epoll_wait返回时的单调时钟毫秒数，供频繁取时间的地方(如连接的最近活动时间)使用
+        int64_t PollTimeMs() const{ return m_poll_ms; }
+
+        BufferPool& GetBufferPool(){ return m_pool; }
+        // 当前线程的事件循环，没有时返回nullptr
+        static EventLoop* Current();
+    private:
+        void Wakeup();
+        void DrainWakeup();
+        void RunPendingTasks();
+
+        int                                 m_epoll_fd;
+        int                                 m_wakeup_fd;    // eventfd，注册时data.ptr为空
+        std::thread::id                     m_thread_id;
+        std::atomic<bool>                   m_quit;
+        std::atomic<bool>                   m_running_tasks;    // 正在执行排队的任务，期间新排队的任务需唤醒下一轮
+        std::mutex                          m_task_mutex;
+        std::vector<Task>                   m_tasks;
+        std::vector<epoll_event>            m_events;
+        std::vector<std::shared_ptr<void>>  m_holders;
+        BufferPool                          m_pool;
+        TimingWheel                         m_timers;
+        int64_t                             m_poll_ms;
+    };
+} // namespace dysv
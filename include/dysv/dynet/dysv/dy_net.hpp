@@ -0,0 +1,27 @@
+#pragma once
+#include "dy_net_buffer.hpp"
+#include "dy_event_loop.hpp"
+#include "dy_tcp_connection.hpp"
+#include "dy_tcp_server.hpp"
+
+/**
+ * @brief 网络模块(libdynet)。
+ * @feature epoll边沿触发的reactor，one loop per thread; 新连接由SO_REUSEPORT在各循环的监听fd间分摊;
+ *          连接的读写缓冲取自所属循环的块池(dy_net_buffer.hpp)，空闲时还回; 写出以sendmsg(MSG_NOSIGNAL)一次写多块，
+ *          Send在写缓冲为空时直接sendmsg调用方数据; 诊断信息经LoggerMgr输出(DY_LOGF_*，高频错误限频);
+ *          每个循环带一个时间轮(../common/dy_timing_wheel.hpp)：RunAfter/RunEvery定时器，连接空闲超时(idle_timeout_ms);
+ * @example
+ *      dysv::TcpServerConfig config;
+ *      config.port = 8080;
+ *      config.threads = 4;
+ *      dysv::TcpServer server(config);
+ *      server.SetMessageCallback([](const dysv::TcpConnectionPtr& conn, dysv::InputBuffer& input){
+ *          conn->Send(input.View());   // echo
+ *          input.RetrieveAll();
+ *      });
+ *      if(!server.Start()){
+ *          return 1;
+ *      }
+ *      ...
+ *      server.Stop();
+ */
@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+namespace dysv
+{
+#define NET_BLOCK_SIZE          (16 * 1024)     // 缓冲池中每块的字节数
+#define NET_POOL_MAX_FREE       1024            // 缓冲池最多缓存的空闲块数，超出的直接释放
+#define NET_READ_EXTRA_SIZE     (64 * 1024)     // 读时额外使用的栈上缓冲，一次readv可读入块剩余空间+该大小
+#define NET_MAX_IOV             64              // 每次sendmsg最多的块数
+
+    /**
+     * @brief 定长内存块池。每个EventLoop一个，只在所属线程使用，不加锁。
+     *        连接的读写缓冲空闲时把块还回池中，大量空闲连接不占用缓冲内存。
+     *
+     */
+    class BufferPool
+    {
+    public:
+        explicit BufferPool(size_t block_size = NET_BLOCK_SIZE, size_t max_free = NET_POOL_MAX_FREE);
+        ~BufferPool();
+        BufferPool(const BufferPool&) = delete;
+        BufferPool& operator=(const BufferPool&) = delete;
+
+        char* Acquire();
+        void Release(char* block);
+        size_t BlockSize() const{ return m_block_size; }
+        size_t FreeCount() const{ return m_free.size(); }
+        // 当前借出未还的块数
+        size_t InUseCount() const{ return m_in_use; }
+    private:
+        size_t              m_block_size;
+        size_t              m_max_free;
+        size_t              m_in_use;
+        std::vector<char*>  m_free;
+    };
+
+    /**
+     * @brief 读缓冲，可读数据始终连续(便于按行/按长度解析)。
+     *        平时使用池中的一块，数据超过一块时换成堆上按倍数增长的内存; 读空后Shrink把内存还回。
+     *
+     */
+    class InputBuffer
+    {
+    public:
+        explicit InputBuffer(BufferPool* pool);
+        ~InputBuffer();
+        InputBuffer(const InputBuffer&) = delete;
+        InputBuffer& operator=(const InputBuffer&) = delete;
+
+        const char* Peek() const{ return m_data + m_read; }
+        size_t ReadableBytes() const{ return m_write - m_read; }
+        std::string_view View() const{ return std::string_view(Peek(), ReadableBytes()); }
+        void Retrieve(size_t len);
+        void RetrieveAll();
+        // 可读数据为空时释放内存(池中的块还回池)
+        void Shrink();
+
+        /**
+         * @brief 从fd读一次：readv到剩余空间与栈上的额外缓冲，额外缓冲中的部分再追加进来。
+         *
+         * @param drained 非空时写入本次是否未填满可用空间(即套接字中的数据已读完)
+         * @return 读到的字节数; 0表示对端关闭; -1表示出错，错误码写入saved_errno
+         */
+        ssize_t ReadFd(int fd, int* saved_errno, bool* drained = nullptr);
+        void Append(const char* data, size_t len);
+    private:
+        void EnsureWritable(size_t len);
+        void ReleaseStorage();
+
+        BufferPool* m_pool;
+        char*       m_data;
+        size_t      m_capacity;
+        size_t      m_read;
+        size_t      m_write;
+        bool        m_pooled;   // m_data为池中的块(否则为new[]得到的内存)
+    };
+
+    /**
+     * @brief 写缓冲，由池中的块链成。追加时填满尾块再取新块，写出时以sendmsg一次写出多块，写完的块立即还回池中。
+     *
+     */
+    class OutputBuffer
+    {
+    public:
+        explicit OutputBuffer(BufferPool* pool);
+        ~OutputBuffer();
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+        size_t ReadableBytes() const{ return m_size; }
+        bool Empty() const{ return m_size == 0; }
+        void Append(const char* data, size_t len);
+        void Append(std::string_view data){ Append(data.data(), data.size()); }
+        void Clear();
+
+        /**
+         * @brief 以sendmsg(MSG_NOSIGNAL)写出尽可能多的数据，fd须为套接字; 对端已断开时返回EPIPE而不产生SIGPIPE。
+         *
+         * @return 写出的字节数; -1表示出错(含EAGAIN)，错误码写入saved_errno
+         */
+        ssize_t WriteFd(int fd, int* saved_errno);
+    private:
+        struct Block{
+            char*   data;
+            size_t  begin;
+            size_t  end;
+        };
+
+        BufferPool*         m_pool;
+        std::deque<Block>   m_blocks;
+        size_t              m_size;
+    };
+} // namespace dysv
@@ -0,0 +1,99 @@
+#pragma once
+#include <any>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "dy_event_loop.hpp"
+#include "dy_net_buffer.hpp"
+
+namespace dysv
+{
+    class TcpConnection;
+    using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+    // 收到数据：解析并取走(Retrieve)已处理的部分，未取走的留到下次
+    using MessageCallback = std::function<void(const TcpConnectionPtr& conn, InputBuffer& input)>;
+    // 连接建立/关闭
+    using ConnectionCallback = std::function<void(const TcpConnectionPtr& conn)>;
+
+    /**
+     * @brief TCP连接。fd以边沿触发一次性注册EPOLLIN|EPOLLOUT|EPOLLRDHUP，之后不再epoll_ctl修改:
+     *        可读时读到EAGAIN，可写时把写缓冲写到EAGAIN。
+     *        Send在写缓冲为空时直接sendmsg调用方的数据，写不完的部分才拷进写缓冲; 读写缓冲空闲时把块还回所属循环的池。
+     *        除Send/Shutdown/ForceClose可在任意线程调用外，其余接口只在所属循环线程使用; 回调均在所属循环线程执行。
+     *
+     */
+    class TcpConnection : public IoHandler, public std::enable_shared_from_this<TcpConnection>
+    {
+    public:
+        using ptr = TcpConnectionPtr;
+
+        enum State{
+            CONN_CONNECTING = 0,    // 已创建，尚未Start
+            CONN_CONNECTED,
+            CONN_DISCONNECTING,     // 已请求Shutdown，等待写缓冲写完
+            CONN_CLOSED,
+        };
+
+        // fd须为已连接的非阻塞套接字，所有权归连接
+        TcpConnection(EventLoop* loop, int fd, const std::string& peer);
+        ~TcpConnection() override;
+
+        // 阻塞地连接host(IPv4):port，返回属于loop、尚未Start的连接; 失败返回nullptr。用于客户端与压测工具
+        static ptr Connect(EventLoop* loop, const std::string& host, uint16_t port);
+
+        void SetMessageCallback(MessageCallback cb){ m_message_cb = std::move(cb); }
+        void SetCloseCallback(ConnectionCallback cb){ m_close_cb = std::move(cb); }
+        // 写缓冲写空时回调(可据此做发送方向的流控)
+        void SetWriteCompleteCallback(ConnectionCallback cb){ m_write_complete_cb = std::move(cb); }
+
+        // 注册到事件循环并开始收发，在所属循环线程调用
+        void Start();
+        // 超过timeout_ms没有读写进展时关闭连接，0表示不限。在所属循环线程调用
+        void SetIdleTimeout(uint32_t timeout_ms);
+
+        void Send(std::string_view data);
+        // 多段数据一次sendmsg发出(如响应头+响应体)，不先拼接
+        void Send(std::initializer_list<std::string_view> pieces);
+        // 写缓冲写完后关闭写方向
+        void Shutdown();
+        // 立即关闭，丢弃写缓冲
+        void ForceClose();
+
+        bool Connected() const{ return m_state == CONN_CONNECTED; }
+        State GetState() const{ return m_state; }
+        int Fd() const{ return m_fd; }
+        EventLoop* GetLoop() const{ return m_loop; }
+        const std::string& GetPeer() const{ return m_peer; }
+        size_t GetPendingBytes() const{ return m_output.ReadableBytes(); }
+        // 由使用者存放的每连接状态
+        std::any& Context(){ return m_context; }
+
+        void HandleEvents(uint32_t events) override;
+    private:
+        // 读到EAGAIN; 读到的字节数少于缓冲剩余空间时说明已读空，未挂断时省掉最后一次返回EAGAIN的read
+        void HandleRead(bool hangup);
+        void HandleWrite();
+        void HandleClose();
+        void SendInLoop(const std::string_view* pieces, size_t count);
+        // 出错时记录日志并关闭; 对端复位等常见情况只记TRACE
+        void HandleError(int err);
+        // 空闲定时器到期：仍空闲则关闭，否则按剩余时间重新挂上(每个空闲周期至多一次定时器操作)
+        void HandleIdleTimer();
+        void ArmIdleTimer(int64_t delay_ms);
+
+        EventLoop*          m_loop;
+        int                 m_fd;
+        std::string         m_peer;
+        State               m_state;
+        InputBuffer         m_input;
+        OutputBuffer        m_output;
+        MessageCallback     m_message_cb;
+        ConnectionCallback  m_close_cb;
+        ConnectionCallback  m_write_complete_cb;
+        std::any            m_context;
+        uint32_t            m_idle_timeout_ms;
+        TimerId             m_idle_timer;
+        int64_t             m_last_active_ms;   // 最近一次读写进展的时刻(所属循环的PollTimeMs)
+    };
+} // namespace dysv
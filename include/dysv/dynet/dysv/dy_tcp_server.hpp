@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "dy_event_loop.hpp"
+#include "dy_tcp_connection.hpp"
+
+namespace dysv
+{
+#define NET_DEFAULT_BACKLOG     1024    // listen队列长度
+
+    struct TcpServerConfig{
+        std::string host = "0.0.0.0";       // 监听的IPv4地址
+        uint16_t    port = 0;               // 0表示由内核分配，Start后用GetPort取得
+        size_t      threads = 1;            // 事件循环线程数，每线程一个EventLoop
+        bool        reuse_port = true;      // 每个循环一个SO_REUSEPORT监听fd，由内核分摊新连接; 关闭时只有循环0监听，轮流分派
+        int         backlog = NET_DEFAULT_BACKLOG;
+        uint32_t    idle_timeout_ms = 0;    // 连接超过该时长没有读写进展时关闭，0表示不限(定时器在所属循环的时间轮上)
+        std::string name = "dysv-net";      // 线程名前缀
+    };
+
+    /**
+     * @brief 多线程TCP服务器：one loop per thread，连接从建立到关闭都只在一个循环线程中处理，无跨线程加锁。
+     *        新连接默认由SO_REUSEPORT在各循环的监听fd之间分摊(accept无惊群、无跨线程转交)。
+     *        回调在连接所属的循环线程中执行，不要在回调中阻塞。
+     *
+     */
+    class TcpServer
+    {
+    public:
+        explicit TcpServer(const TcpServerConfig& config);
+        ~TcpServer();
+        TcpServer(const TcpServer&) = delete;
+        TcpServer& operator=(const TcpServer&) = delete;
+
+        // 须在Start前设置
+        void SetMessageCallback(MessageCallback cb){ m_message_cb = std::move(cb); }
+        void SetConnectionCallback(ConnectionCallback cb){ m_connection_cb = std::move(cb); }
+        void SetCloseCallback(ConnectionCallback cb){ m_close_cb = std::move(cb); }
+
+        // 监听并启动循环线程; 绑定失败时记录日志并返回false
+        bool Start();
+        // 关闭监听与所有连接，停止并回收循环线程
+        void Stop();
+
+        uint16_t GetPort() const{ return m_port; }
+        size_t GetConnectionCount() const{ return m_conn_count.load(std::memory_order_relaxed); }
+    private:
+        class Acceptor;
+        struct Worker{
+            EventLoop*                                          loop = nullptr;
+            std::thread                                         thread;
+            int                                                 listen_fd = -1;
+            std::unique_ptr<Acceptor>                           acceptor;
+            std::unordered_map<TcpConnection*, TcpConnectionPtr> conns;     // 只在该循环线程访问
+        };
+
+        int CreateListenFd(uint16_t port);
+        // 在线程中构造EventLoop，就绪后经ready交回
+        void WorkerLoop(Worker* worker, std::promise<void>* ready);
+        // 在worker的循环线程中调用
+        void NewConnection(Worker* worker, int fd, const std::string& peer);
+        // Acceptor在from的循环中收到新连接：reuse_port时留在本循环，否则轮流分派
+        void Dispatch(Worker* from, int fd, const std::string& peer);
+
+        TcpServerConfig                         m_config;
+        uint16_t                                m_port;
+        bool                                    m_started;
+        std::vector<std::unique_ptr<Worker>>    m_workers;
+        std::atomic<size_t>                     m_next_worker;
+        std::atomic<size_t>                     m_conn_count;
+        MessageCallback                         m_message_cb;
+        ConnectionCallback                      m_connection_cb;
+        ConnectionCallback                      m_close_cb;
+    };
+} // namespace dysv
@@ -0,0 +1,90 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "dysv/dy_binary_log.hpp"
+
+/**
+ * @brief 二进制日志解码工具：将BinaryLogWriter写出的文件还原为文本，输出到标准输出。
+ * @usage dysv_log_decode [-p pattern] [file ...]
+ *        -p   使用指定的模式串(语法同LoggerPattern)，缺省时使用文件头中记录的模式串
+ *        未给出文件或文件为"-"时读取标准输入
+ */
+
+#define DECODE_READ_CHUNK_SIZE  (1024 * 1024)
+
+static void Usage(const char* prog){
+    fprintf(stderr, "usage: %s [-p pattern] [file ...]\n", prog);
+}
+
+// 解码一个文件，返回是否成功
+static bool DecodeFile(const char* path, const std::string& pattern){
+    FILE* fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if(fp == nullptr){
+        fprintf(stderr, "dysv_log_decode: cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    dysv::BinaryLogDecoder decoder(pattern);
+    std::vector<char> buf(DECODE_READ_CHUNK_SIZE);
+    size_t pending = 0;     // buf开头尚未解析完的字节数
+    uint64_t offset = 0;    // buf开头在文件中的偏移
+    std::string out;
+    bool ok = true;
+    for(;;){
+        if(pending == buf.size()){
+            // 单帧超过缓冲，扩容后继续读
+            buf.resize(buf.size() * 2);
+        }
+        size_t n = fread(buf.data() + pending, 1, buf.size() - pending, fp);
+        if(n == 0){
+            break;
+        }
+        size_t len = pending + n;
+        out.clear();
+        size_t used = decoder.Decode(buf.data(), len, out);
+        fwrite(out.data(), 1, out.size(), stdout);
+        if(decoder.IsBroken()){
+            fprintf(stderr, "dysv_log_decode: %s: malformed frame at offset %llu\n", path, (unsigned long long)(offset + used));
+            ok = false;
+            break;
+        }
+        pending = len - used;
+        offset += used;
+        memmove(buf.data(), buf.data() + used, pending);
+    }
+    if(ok && pending > 0){
+        // 写入方异常退出时末尾可能只有半帧
+        fprintf(stderr, "dysv_log_decode: %s: ignored %zu trailing bytes of an incomplete frame\n", path, pending);
+    }
+    if(fp != stdin){
+        fclose(fp);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv){
+    std::string pattern;
+    std::vector<const char*> files;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-p") == 0 && i + 1 < argc){
+            pattern = argv[++i];
+        }else if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0){
+            Usage(argv[0]);
+            return 0;
+        }else{
+            files.push_back(argv[i]);
+        }
+    }
+    if(files.empty()){
+        files.push_back("-");
+    }
+
+    bool ok = true;
+    for(const char* file : files){
+        ok = DecodeFile(file, pattern) && ok;
+    }
+    fflush(stdout);
+    return ok ? 0 : 1;
+}